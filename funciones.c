@@ -37,11 +37,31 @@
  */
 
 
+ // fileno, fsync y nanosleep son POSIX: se piden antes de cualquier include para que
+ // también se declaren al compilar con -std=c11
+ #ifndef _WIN32
+ #define _POSIX_C_SOURCE 200809L
+ #endif
+
  #include <stdio.h>
+ #include <stdlib.h>
+ #include <stddef.h>
+ #include <stdarg.h>
  #include <string.h>
  #include <time.h>
+ #include <signal.h>
  #include "funciones.h"
 
+ #ifdef _WIN32
+ #include <windows.h>
+ #include <io.h>
+ #define DISPOSITIVO_NULO "NUL"
+ #else
+ #include <fcntl.h>
+ #include <unistd.h>
+ #define DISPOSITIVO_NULO "/dev/null"
+ #endif
+
 // Función para calcular valor absoluto sin usar math.h
 float absoluto(float numero) {
     if (numero < 0) {
@@ -50,6 +70,45 @@ float absoluto(float numero) {
     return numero;
 }
 
+// Función para calcular raíz cuadrada (método de Newton) sin usar math.h
+float raizCuadrada(float numero) {
+    if (numero <= 0) {
+        return 0.0;
+    }
+    float x = numero > 1 ? numero : 1;
+    for (int i = 0; i < 30; i++) {
+        float siguiente = 0.5 * (x + numero / x);
+        if (absoluto(siguiente - x) < 1e-6 * x) {
+            return siguiente;
+        }
+        x = siguiente;
+    }
+    return x;
+}
+
+// Función para calcular e^x sin usar math.h: x = k*ln(2) + r y serie de Taylor para e^r
+float exponencial(float x) {
+    if (x < -80) return 0.0;
+    if (x > 80) x = 80;
+    
+    int k = (int)(x / 0.69314718f + (x < 0 ? -0.5f : 0.5f));
+    float r = x - k * 0.69314718f;
+    float resultado = 1 + r * (1 + r / 2 * (1 + r / 3 * (1 + r / 4 * (1 + r / 5 * (1 + r / 6)))));
+    
+    for (; k > 0; k--) resultado *= 2;
+    for (; k < 0; k++) resultado /= 2;
+    return resultado;
+}
+
+// Función de distribución normal estándar acumulada (Abramowitz y Stegun 26.2.17)
+float normalAcumulada(float z) {
+    float t = 1.0 / (1.0 + 0.2316419 * absoluto(z));
+    float densidad = 0.39894228 * exponencial(-z * z / 2);
+    float cola = densidad * t * (0.319381530 + t * (-0.356563782 + t * (1.781477937 +
+                 t * (-1.821255978 + t * 1.330274429))));
+    return z >= 0 ? 1 - cola : cola;
+}
+
 void leerCadena(char *cadena, int num)
 {
     fflush(stdin);
@@ -74,17 +133,25 @@ int menu()
         printf("6. Historial con Fechas                   \n");
         printf("7. Exportar Reportes                      \n");
         printf("8. Estado del Sistema                     \n");
+        printf("9. Mapa de Contaminacion                  \n");
+        printf("10. Pronostico Multi-dia                  \n");
+        printf("11. Modelo Estadistico                    \n");
+        printf("12. Evaluacion del Pronostico             \n");
+        printf("13. Importar Historico                    \n");
+        printf("14. Correlaciones                         \n");
+        printf("15. Percentiles                           \n");
+        printf("16. Configuracion de Limites              \n");
         printf("0. Salir                                   \n");
         printf("===========================================\n");
         printf("Seleccione una opción: ");
         fflush(stdin);
         val = scanf("%d", &opc);
         fflush(stdin);
-        if (val != 1 || opc < 0 || opc > 8)
+        if (val != 1 || opc < 0 || opc > 16)
         {
             printf("Opción inválida. Por favor, intente de nuevo.\n");
         }
-    } while (val != 1 || opc < 0 || opc > 8);
+    } while (val != 1 || opc < 0 || opc > 16);
     return opc;
 }
 
@@ -95,6 +162,20 @@ void inicializarZonas(ZonaUrbana zonas[])
         // Inicializar todo en cero
         zonas[i].id_zona = 0;
         zonas[i].dias_registrados = 0;
+        zonas[i].modelos_ajustados = 0;
+        zonas[i].modificada = 1; // Aún no existe su archivo
+        zonas[i].generacion = 0;
+        memset(&zonas[i].archivado, 0, sizeof(HistoricoArchivado));
+        zonas[i].detectores_listos = 0;
+        memset(zonas[i].dias_imputados, 0, sizeof(zonas[i].dias_imputados));
+        memset(zonas[i].dias_duplicados, 0, sizeof(zonas[i].dias_duplicados));
+        zonas[i].huecos_sin_completar = 0;
+        memset(zonas[i].excesos, 0, sizeof(zonas[i].excesos));
+        zonas[i].cuantiles = NULL;
+        zonas[i].num_anios_cuantiles = 0;
+        zonas[i].derivados_pendientes = TODOS_LOS_DERIVADOS;
+        memset(zonas[i].alcance_derivados, 0, sizeof(zonas[i].alcance_derivados));
+        zonas[i].pronostico_disponible = 0;
         
         // Inicializar niveles actuales en cero
         zonas[i].niveles_actuales.co2 = 0.0;
@@ -138,2085 +219,7015 @@ void inicializarZonas(ZonaUrbana zonas[])
     strcpy(zonas[4].nombre, "Cumbaya - Tumbaco");
     zonas[4].id_zona = 5;
     
+    // Ubicación de la estación de cada zona
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        zonas[i].ubicacion = coordenadasPorDefecto(zonas[i].id_zona);
+    }
+    
     // Guardar cada zona en archivo separado
     guardarTodasLasZonas(zonas);
 }
 
-// =================== FUNCIONES PARA ARCHIVOS SEPARADOS ===================
+// ============== FUNCIONES PARA LA ARENA DE MEMORIA TEMPORAL ==============
 
-void guardarZona(ZonaUrbana *zona) {
-    char nombre_archivo[100];
+// Arena compartida por los reportes y análisis (el programa tiene un solo hilo)
+static ArenaTemporal arena_reportes = {0};
+
+ArenaTemporal *arenaReportes(void) {
+    return &arena_reportes;
+}
+
+// Reserva 'tamano' bytes alineados. Primero se usa el bloque principal; si no alcanza,
+// se pide un bloque adicional que vive hasta liberarArena.
+void *reservarArena(ArenaTemporal *arena, size_t tamano) {
+    tamano = (tamano + ALINEACION_ARENA - 1) / ALINEACION_ARENA * ALINEACION_ARENA;
+    if(tamano == 0) tamano = ALINEACION_ARENA;
+    arena->reservas++;
+    
+    if(arena->bloque == NULL) {
+        arena->bloque = malloc(TAM_INICIAL_ARENA);
+        if(arena->bloque == NULL) return NULL;
+        arena->tamano = TAM_INICIAL_ARENA;
+        arena->reservas_sistema++;
+    }
+    if(arena->usado + tamano <= arena->tamano) {
+        void *memoria = arena->bloque + arena->usado;
+        arena->usado += tamano;
+        return memoria;
+    }
     
-    // Crear nombre de archivo basado en ID
-    sprintf(nombre_archivo, "zona_%d.dat", zona->id_zona);
+    // La cabecera ocupa un múltiplo de la alineación para que los datos queden alineados
+    size_t cabecera = (sizeof(BloqueArena) + ALINEACION_ARENA - 1) / ALINEACION_ARENA * ALINEACION_ARENA;
+    BloqueArena *adicional = malloc(cabecera + tamano);
+    if(adicional == NULL) return NULL;
+    adicional->siguiente = arena->adicionales;
+    adicional->tamano = tamano;
+    arena->adicionales = adicional;
+    arena->usado_adicionales += tamano;
+    arena->reservas_sistema++;
+    return (unsigned char *)adicional + cabecera;
+}
+
+// Texto con formato printf guardado en la arena
+char *formatearEnArena(ArenaTemporal *arena, const char *formato, ...) {
+    va_list argumentos;
+    va_start(argumentos, formato);
+    int longitud = vsnprintf(NULL, 0, formato, argumentos);
+    va_end(argumentos);
+    if(longitud < 0) return NULL;
+    
+    char *texto = reservarArena(arena, longitud + 1);
+    if(texto == NULL) return NULL;
+    va_start(argumentos, formato);
+    vsnprintf(texto, longitud + 1, formato, argumentos);
+    va_end(argumentos);
+    return texto;
+}
+
+// Marca y restauración para liberar solo lo reservado por una función auxiliar
+// (en orden de pila: lo reservado después de la marca se devuelve junto)
+MarcaArena marcaArena(ArenaTemporal *arena) {
+    MarcaArena marca;
+    marca.usado = arena->usado;
+    marca.adicionales = arena->adicionales;
+    return marca;
+}
+
+void restaurarArena(ArenaTemporal *arena, MarcaArena marca) {
+    size_t total = arena->usado + arena->usado_adicionales;
+    if(total > arena->pico) {
+        arena->pico = total;
+    }
+    while(arena->adicionales != NULL && arena->adicionales != marca.adicionales) {
+        BloqueArena *siguiente = arena->adicionales->siguiente;
+        arena->usado_adicionales -= arena->adicionales->tamano;
+        free(arena->adicionales);
+        arena->adicionales = siguiente;
+    }
+    if(marca.usado <= arena->usado) {
+        arena->usado = marca.usado;
+    }
+}
+
+// Libera de una vez todo lo reservado. Si el pico superó el bloque principal, este
+// crece para que el próximo reporte no vuelva a pedir memoria al sistema.
+void liberarArena(ArenaTemporal *arena) {
+    MarcaArena vacia = {0, NULL};
+    restaurarArena(arena, vacia);
+    
+    if(arena->pico > arena->tamano && arena->bloque != NULL) {
+        size_t nuevo_tamano = arena->tamano;
+        while(nuevo_tamano < arena->pico) nuevo_tamano *= 2;
+        unsigned char *nuevo_bloque = malloc(nuevo_tamano);
+        if(nuevo_bloque != NULL) {
+            free(arena->bloque);
+            arena->bloque = nuevo_bloque;
+            arena->tamano = nuevo_tamano;
+            arena->reservas_sistema++;
+        }
+    }
+}
+
+// ================ FUNCIONES PARA SALIDA CON BUFFER ================
+
+// Las filas se formatean en un bloque de la arena y se escriben con un solo fwrite
+// cuando el bloque se llena o al terminar la tabla
+void iniciarBufferSalida(BufferSalida *salida, ArenaTemporal *arena, size_t capacidad, FILE *destino) {
+    salida->datos = reservarArena(arena, capacidad);
+    salida->capacidad = salida->datos != NULL ? capacidad : 0;
+    salida->longitud = 0;
+    salida->destino = destino;
+    salida->escrituras = 0;
+}
+
+void vaciarBufferSalida(BufferSalida *salida) {
+    if(salida->longitud > 0) {
+        fwrite(salida->datos, 1, salida->longitud, salida->destino);
+        salida->escrituras++;
+        salida->longitud = 0;
+    }
+}
+
+// Deja al menos 'necesario' bytes libres; si no caben ni con el buffer vacío devuelve 0
+int reservarEnBufferSalida(BufferSalida *salida, size_t necesario) {
+    if(salida->longitud + necesario > salida->capacidad) {
+        vaciarBufferSalida(salida);
+    }
+    return necesario <= salida->capacidad;
+}
+
+void agregarTexto(BufferSalida *salida, const char *texto) {
+    size_t longitud = strlen(texto);
+    if(!reservarEnBufferSalida(salida, longitud)) {
+        fwrite(texto, 1, longitud, salida->destino);
+        salida->escrituras++;
+        return;
+    }
+    memcpy(salida->datos + salida->longitud, texto, longitud);
+    salida->longitud += longitud;
+}
+
+// Texto alineado a la izquierda en 'ancho' columnas (como %-Ns)
+void agregarTextoAncho(BufferSalida *salida, const char *texto, int ancho) {
+    agregarTexto(salida, texto);
+    int relleno = ancho - (int)strlen(texto);
+    if(relleno > 0 && reservarEnBufferSalida(salida, relleno)) {
+        memset(salida->datos + salida->longitud, ' ', relleno);
+        salida->longitud += relleno;
+    }
+}
+
+// Entero alineado a la derecha en 'ancho' columnas, rellenado con ' ' o '0' (%Nd, %0Nd)
+void agregarEntero(BufferSalida *salida, long valor, int ancho, char relleno) {
+    char cifras[24];
+    int n = 0;
+    int negativo = valor < 0;
+    unsigned long resto = negativo ? 0UL - (unsigned long)valor : (unsigned long)valor;
     
-    FILE *f = fopen(nombre_archivo, "wb");
-    if(f != NULL) {
-        fwrite(zona, sizeof(ZonaUrbana), 1, f);
-        fclose(f);
-        // Guardado silencioso para no interrumpir la experiencia del usuario
+    do {
+        cifras[n++] = '0' + resto % 10;
+        resto /= 10;
+    } while(resto > 0);
+    
+    if(!reservarEnBufferSalida(salida, (ancho > n + 1 ? ancho : n + 1))) return;
+    char *p = salida->datos + salida->longitud;
+    int ocupado = n + negativo;
+    if(relleno == '0') {
+        if(negativo) *p++ = '-';
+        for(int i = ocupado; i < ancho; i++) *p++ = '0';
     } else {
-        printf("Error al guardar datos de la zona %s\n", zona->nombre);
+        for(int i = ocupado; i < ancho; i++) *p++ = ' ';
+        if(negativo) *p++ = '-';
     }
+    while(n > 0) *p++ = cifras[--n];
+    salida->longitud = p - salida->datos;
 }
 
-void guardarTodasLasZonas(ZonaUrbana zonas[]) {
-    printf("Guardando zonas en archivos separados...\n");
-    for(int i = 0; i < MAX_ZONAS; i++) {
-        guardarZona(&zonas[i]);
+// Decimal en punto fijo con el mismo redondeo que printf (%N.Df o %-N.Df). El producto
+// de un float por 10, 100 o 1000 es exacto en double, así que los empates se detectan
+// sin error y se redondean al par como hace printf.
+void agregarDecimal(BufferSalida *salida, float valor, int ancho, int decimales, int a_la_izquierda) {
+    static const long potencias[] = {1, 10, 100, 1000};
+    if(decimales < 0) decimales = 0;
+    if(decimales > 3) decimales = 3;
+    
+    int negativo = valor < 0;
+    double escalado = (negativo ? -(double)valor : (double)valor) * potencias[decimales];
+    unsigned long entero = (unsigned long)escalado;
+    double fraccion = escalado - (double)entero;
+    if(fraccion > 0.5 || (fraccion == 0.5 && (entero & 1))) {
+        entero++;
+    }
+    
+    // Cifras de derecha a izquierda: decimales, punto y parte entera
+    char cifras[32];
+    int n = 0;
+    for(int i = 0; i < decimales; i++) {
+        cifras[n++] = '0' + entero % 10;
+        entero /= 10;
+    }
+    if(decimales > 0) cifras[n++] = '.';
+    do {
+        cifras[n++] = '0' + entero % 10;
+        entero /= 10;
+    } while(entero > 0);
+    if(negativo) cifras[n++] = '-';
+    
+    if(!reservarEnBufferSalida(salida, (ancho > n ? ancho : n))) return;
+    char *p = salida->datos + salida->longitud;
+    int relleno = ancho - n;
+    if(!a_la_izquierda) {
+        for(int i = 0; i < relleno; i++) *p++ = ' ';
+    }
+    while(n > 0) *p++ = cifras[--n];
+    if(a_la_izquierda) {
+        for(int i = 0; i < relleno; i++) *p++ = ' ';
     }
+    salida->longitud = p - salida->datos;
 }
 
-int cargarZona(ZonaUrbana *zona, int id_zona) {
-    char nombre_archivo[100];
-    sprintf(nombre_archivo, "zona_%d.dat", id_zona);
+// Fila de la tabla de Historial con Fechas, con la línea de contaminantes excedidos.
+// Los días completados por interpolación llevan un '*' después de la fecha.
+void agregarFilaHistorial(BufferSalida *salida, const RegistroHistorico *registro, int imputado,
+                          const float *limites) {
+    int excede_co2 = registro->niveles.co2 > limites[0];
+    int excede_so2 = registro->niveles.so2 > limites[1];
+    int excede_no2 = registro->niveles.no2 > limites[2];
+    int excede_pm25 = registro->niveles.pm25 > limites[3];
+    int excesos = excede_co2 + excede_so2 + excede_no2 + excede_pm25;
+    
+    const char *estado;
+    if(excesos == 0) {
+        estado = "Bueno";
+    } else if(excesos == 1) {
+        estado = "Moderado";
+    } else if(excesos == 2) {
+        estado = "Danino";
+    } else {
+        estado = "Peligroso";
+    }
     
-    FILE *f = fopen(nombre_archivo, "rb+");
-    if(f != NULL) {
-        if(fread(zona, sizeof(ZonaUrbana), 1, f) == 1) {
-            fclose(f);
-            printf("Zona %s cargada desde %s\n", zona->nombre, nombre_archivo);
-            return 1; // Éxito
+    agregarTexto(salida, "| ");
+    agregarEntero(salida, registro->fecha.dia, 2, '0');
+    agregarTexto(salida, "/");
+    agregarEntero(salida, registro->fecha.mes, 2, '0');
+    agregarTexto(salida, "/");
+    agregarEntero(salida, registro->fecha.año % 100, 2, '0');
+    agregarTexto(salida, imputado ? "*| " : " | ");
+    agregarDecimal(salida, registro->niveles.co2, 6, 1, 0);
+    agregarTexto(salida, " | ");
+    agregarDecimal(salida, registro->niveles.so2, 6, 1, 0);
+    agregarTexto(salida, " | ");
+    agregarDecimal(salida, registro->niveles.no2, 6, 1, 0);
+    agregarTexto(salida, " | ");
+    agregarDecimal(salida, registro->niveles.pm25, 6, 1, 0);
+    agregarTexto(salida, " | ");
+    agregarTextoAncho(salida, estado, 13);
+    agregarTexto(salida, " |\n");
+    
+    if(excesos > 0) {
+        const char *separador = "";
+        agregarTexto(salida, "|           |        |        |        |        | Exceden: ");
+        if(excede_co2) {
+            agregarTexto(salida, "CO2");
+            separador = ", ";
         }
-        fclose(f);
+        if(excede_so2) {
+            agregarTexto(salida, separador);
+            agregarTexto(salida, "SO2");
+            separador = ", ";
+        }
+        if(excede_no2) {
+            agregarTexto(salida, separador);
+            agregarTexto(salida, "NO2");
+            separador = ", ";
+        }
+        if(excede_pm25) {
+            agregarTexto(salida, separador);
+            agregarTexto(salida, "PM2.5");
+        }
+        agregarTexto(salida, "   |\n");
     }
-    return 0; // No se pudo cargar
 }
 
-int cargarTodasLasZonas(ZonaUrbana zonas[]) {
-    int zonas_cargadas = 0;
-    
-    printf("Cargando zonas desde archivos separados...\n");
-    for(int i = 0; i < MAX_ZONAS; i++) {
-        if(cargarZona(&zonas[i], i+1)) {
-            zonas_cargadas++;
+// Historial completo con un printf por campo, como se imprimía antes de usar el buffer.
+// Se conserva solo como referencia para medirRenderizadoHistorial.
+long renderizarHistorialConPrintf(FILE *destino, ZonaUrbana *zona) {
+    long llamadas = 0;
+    for(int i = 0; i < diasTotalesZona(zona); i++) {
+        RegistroHistorico registro = registroHistoricoCompleto(zona, i);
+        int excesos = (registro.niveles.co2 > zona->limites[0]) + (registro.niveles.so2 > zona->limites[1]) +
+                      (registro.niveles.no2 > zona->limites[2]) + (registro.niveles.pm25 > zona->limites[3]);
+        const char *estados[] = {"Bueno", "Moderado", "Danino", "Peligroso", "Peligroso"};
+        
+        fprintf(destino, "| %02d/%02d/%02d | %6.1f | %6.1f | %6.1f | %6.1f | %-13s |\n",
+                registro.fecha.dia, registro.fecha.mes, registro.fecha.año % 100,
+                registro.niveles.co2, registro.niveles.so2, registro.niveles.no2,
+                registro.niveles.pm25, estados[excesos]);
+        llamadas++;
+        if(excesos > 0) {
+            const char *separador = "";
+            fprintf(destino, "|           |        |        |        |        | Exceden: ");
+            llamadas++;
+            if(registro.niveles.co2 > zona->limites[0]) {
+                fprintf(destino, "%sCO2", separador);
+                separador = ", ";
+                llamadas++;
+            }
+            if(registro.niveles.so2 > zona->limites[1]) {
+                fprintf(destino, "%sSO2", separador);
+                separador = ", ";
+                llamadas++;
+            }
+            if(registro.niveles.no2 > zona->limites[2]) {
+                fprintf(destino, "%sNO2", separador);
+                separador = ", ";
+                llamadas++;
+            }
+            if(registro.niveles.pm25 > zona->limites[3]) {
+                fprintf(destino, "%sPM2.5", separador);
+                llamadas++;
+            }
+            fprintf(destino, "   |\n");
+            llamadas++;
         }
     }
-    
-    printf("Total de zonas cargadas: %d/%d\n", zonas_cargadas, MAX_ZONAS);
-    return zonas_cargadas;
+    return llamadas;
 }
 
-// ================= FUNCION DE VALIDACION DE DATOS =================
-void funcionValidarDatosdeRegistro(float *valor, char *nombre_dato, float min_val, float max_val) {
-    int val;
-    do {
-        printf("%s: ", nombre_dato);
-        fflush(stdin);
-        val = scanf("%f", valor);
-        fflush(stdin);
+void renderizarHistorialEnBuffer(BufferSalida *salida, ZonaUrbana *zona) {
+    for(int i = 0; i < diasTotalesZona(zona); i++) {
+        RegistroHistorico registro = registroHistoricoCompleto(zona, i);
+        agregarFilaHistorial(salida, &registro, 0, zona->limites);
+    }
+    vaciarBufferSalida(salida);
+}
+
+// Compara el costo de imprimir el historial completo de cada zona con printf por campo
+// y con el buffer, escribiendo en el dispositivo nulo
+void medirRenderizadoHistorial(ZonaUrbana zonas[]) {
+    const int repeticiones = 20;
+    FILE *nulo = fopen(DISPOSITIVO_NULO, "w");
+    if(nulo == NULL) {
+        return;
+    }
+    
+    printf("\nRENDIMIENTO DEL HISTORIAL COMPLETO (%d repeticiones):\n", repeticiones);
+    printf("  %-20s | %6s | %9s | %9s | %8s | %10s\n",
+           "Zona", "Dias", "printf ms", "buffer ms", "llamadas", "escrituras");
+    for(int z = 0; z < MAX_ZONAS; z++) {
+        long llamadas = 0;
+        BufferSalida salida;
+        ArenaTemporal *arena = arenaReportes();
         
-        if(val != 1) {
-            printf("ERROR: Ingrese un numero valido.\n");
-        } else if(*valor < min_val || *valor > max_val) {
-            printf("ERROR: El valor debe estar entre %.1f y %.1f\n", min_val, max_val);
+        double inicio = milisegundosActuales();
+        for(int r = 0; r < repeticiones; r++) {
+            llamadas = renderizarHistorialConPrintf(nulo, &zonas[z]);
         }
-    } while(val != 1 || *valor < min_val || *valor > max_val);
+        fflush(nulo);
+        double ms_printf = (milisegundosActuales() - inicio) / repeticiones;
+        
+        iniciarBufferSalida(&salida, arena, TAM_BUFFER_SALIDA, nulo);
+        inicio = milisegundosActuales();
+        for(int r = 0; r < repeticiones; r++) {
+            salida.escrituras = 0;
+            renderizarHistorialEnBuffer(&salida, &zonas[z]);
+        }
+        fflush(nulo);
+        double ms_buffer = (milisegundosActuales() - inicio) / repeticiones;
+        liberarArena(arena);
+        
+        printf("  %-20s | %6d | %9.3f | %9.3f | %8ld | %10ld\n", zonas[z].nombre,
+               diasTotalesZona(&zonas[z]), ms_printf, ms_buffer, llamadas, salida.escrituras);
+    }
+    fclose(nulo);
 }
 
-// ================= FUNCION DE REGISTRO DIARIO =================
-void registroDatosDiario(ZonaUrbana zonas[]) {
-    int id_zona, val;
-    // Mostrar zonas disponibles
-    cargarTodasLasZonas(zonas);
-    for(int i = 0; i < MAX_ZONAS; i++) {
-        printf("%d. %s\n", zonas[i].id_zona, zonas[i].nombre);
-    }
+// ================ FUNCIONES PARA EL HISTORICO ARCHIVADO ================
 
-    do
-    {
-        printf("Seleccione la zona para registrar datos (1-%d): ", MAX_ZONAS);
-        val = scanf("%d", &id_zona);
-        fflush(stdin);
+// Pool de bloques: se piden al sistema de BLOQUES_POR_RESERVA en BLOQUES_POR_RESERVA
+// y los bloques liberados se reutilizan
+static BloqueHistorico *bloques_libres = NULL;
 
-        if (val != 1 || id_zona < 1 || id_zona > MAX_ZONAS){
-            printf("Opcion invalida. Por favor, intente de nuevo.\n");
+BloqueHistorico *obtenerBloqueHistorico(void) {
+    if(bloques_libres == NULL) {
+        BloqueHistorico *reserva = malloc(BLOQUES_POR_RESERVA * sizeof(BloqueHistorico));
+        if(reserva == NULL) {
+            return NULL;
         }
-    } while (val != 1 || id_zona < 1 || id_zona > MAX_ZONAS);
+        for(int i = 0; i < BLOQUES_POR_RESERVA; i++) {
+            reserva[i].siguiente_libre = bloques_libres;
+            bloques_libres = &reserva[i];
+        }
+    }
+    BloqueHistorico *bloque = bloques_libres;
+    bloques_libres = bloque->siguiente_libre;
+    return bloque;
+}
 
-    // Mover datos históricos (FIFO - lo más reciente al inicio)
-    for(int i = MAX_DIAS_HISTORICOS-1; i > 0; i--) {
-        zonas[id_zona - 1].historico[i] = zonas[id_zona - 1].historico[i-1];
-        zonas[id_zona - 1].historico_fechas[i] = zonas[id_zona - 1].historico_fechas[i-1];
+void devolverBloqueHistorico(BloqueHistorico *bloque) {
+    bloque->siguiente_libre = bloques_libres;
+    bloques_libres = bloque;
+}
+
+// Añade un día como el más reciente del histórico archivado
+int archivarRegistro(HistoricoArchivado *archivado, RegistroHistorico registro) {
+    int posicion = (archivado->primero + archivado->num_registros) % REGISTROS_POR_BLOQUE;
+    
+    if(posicion == 0) {
+        if(archivado->num_bloques == archivado->capacidad_bloques) {
+            int capacidad = archivado->capacidad_bloques > 0 ? archivado->capacidad_bloques * 2 : 4;
+            BloqueHistorico **bloques = realloc(archivado->bloques, capacidad * sizeof(BloqueHistorico *));
+            if(bloques == NULL) {
+                return 0;
+            }
+            archivado->bloques = bloques;
+            archivado->capacidad_bloques = capacidad;
+        }
+        BloqueHistorico *bloque = obtenerBloqueHistorico();
+        if(bloque == NULL) {
+            return 0;
+        }
+        archivado->bloques[archivado->num_bloques++] = bloque;
     }
+    archivado->bloques[archivado->num_bloques - 1]->registros[posicion] = registro;
+    archivado->num_registros++;
+    return 1;
+}
 
-    // Leer nuevos datos con validación
-    printf("Ingrese los niveles de contaminantes para la zona %s:\n", zonas[id_zona - 1].nombre);
-    
-    // Validar datos de contaminantes con rangos específicos
-    funcionValidarDatosdeRegistro(&zonas[id_zona - 1].niveles_actuales.co2, 
-                                 "CO2 (ppm)", 0.0, 3000.0);
-    
-    funcionValidarDatosdeRegistro(&zonas[id_zona - 1].niveles_actuales.so2, 
-                                 "SO2 (ug/m3)", 0.0, 500.0);
-    
-    funcionValidarDatosdeRegistro(&zonas[id_zona - 1].niveles_actuales.no2, 
-                                 "NO2 (ug/m3)", 0.0, 300.0);
-    
-    funcionValidarDatosdeRegistro(&zonas[id_zona - 1].niveles_actuales.pm25, 
-                                 "PM2.5 (ug/m3)", 0.0, 200.0);
+// Día archivado por índice (0 = el más antiguo)
+RegistroHistorico *registroArchivado(HistoricoArchivado *archivado, int indice) {
+    indice += archivado->primero;
+    return &archivado->bloques[indice / REGISTROS_POR_BLOQUE]->registros[indice % REGISTROS_POR_BLOQUE];
+}
 
-    // Registrar datos climáticos con validación
-    printf("\nIngrese los datos climaticos para la zona %s:\n", zonas[id_zona - 1].nombre);
-    
-    funcionValidarDatosdeRegistro(&zonas[id_zona - 1].clima_actual.temperatura, 
-                                 "Temperatura (Celsius)", -20.0, 50.0);
-    
-    funcionValidarDatosdeRegistro(&zonas[id_zona - 1].clima_actual.velocidad_viento, 
-                                 "Velocidad del viento (km/h)", 0.0, 120.0);
-    
-    funcionValidarDatosdeRegistro(&zonas[id_zona - 1].clima_actual.humedad, 
-                                 "Humedad (%)", 0.0, 100.0);
+// Quita los 'cantidad' días más antiguos y devuelve al pool los bloques que quedan vacíos
+void descartarArchivadosAntiguos(HistoricoArchivado *archivado, int cantidad) {
+    if(cantidad >= archivado->num_registros) {
+        liberarHistoricoArchivado(archivado);
+        return;
+    }
+    archivado->primero += cantidad;
+    archivado->num_registros -= cantidad;
     
-    funcionValidarDatosdeRegistro(&zonas[id_zona - 1].clima_actual.presion_atmosferica, 
-                                 "Presion (hPa)", 900.0, 1100.0);
+    int vacios = archivado->primero / REGISTROS_POR_BLOQUE;
+    if(vacios > 0) {
+        for(int i = 0; i < vacios; i++) {
+            devolverBloqueHistorico(archivado->bloques[i]);
+        }
+        memmove(archivado->bloques, archivado->bloques + vacios,
+                (archivado->num_bloques - vacios) * sizeof(BloqueHistorico *));
+        archivado->num_bloques -= vacios;
+        archivado->primero %= REGISTROS_POR_BLOQUE;
+    }
+}
 
-    // Actualizar niveles actuales
-    zonas[id_zona - 1].historico[0] = zonas[id_zona - 1].niveles_actuales;
-    
-    // Actualizar histórico con fechas (fecha actual)
-    time_t tiempo_actual;
-    struct tm *info_tiempo;
-    time(&tiempo_actual);
-    info_tiempo = localtime(&tiempo_actual);
-    
-    zonas[id_zona - 1].historico_fechas[0].fecha.dia = info_tiempo->tm_mday;
-    zonas[id_zona - 1].historico_fechas[0].fecha.mes = info_tiempo->tm_mon + 1;
-    zonas[id_zona - 1].historico_fechas[0].fecha.año = info_tiempo->tm_year + 1900;
-    zonas[id_zona - 1].historico_fechas[0].niveles = zonas[id_zona - 1].niveles_actuales;
-    zonas[id_zona - 1].historico_fechas[0].clima = zonas[id_zona - 1].clima_actual;
+// Invierte el orden de los días (para cargar desde el archivo, que va del más reciente
+// al más antiguo)
+void invertirHistoricoArchivado(HistoricoArchivado *archivado) {
+    for(int i = 0, j = archivado->num_registros - 1; i < j; i++, j--) {
+        RegistroHistorico temporal = *registroArchivado(archivado, i);
+        *registroArchivado(archivado, i) = *registroArchivado(archivado, j);
+        *registroArchivado(archivado, j) = temporal;
+    }
+}
 
-    // Incrementar contador de días registrados
-    if (zonas[id_zona - 1].dias_registrados < MAX_DIAS_HISTORICOS) {
-        zonas[id_zona - 1].dias_registrados++;
+void liberarHistoricoArchivado(HistoricoArchivado *archivado) {
+    for(int i = 0; i < archivado->num_bloques; i++) {
+        devolverBloqueHistorico(archivado->bloques[i]);
     }
+    free(archivado->bloques);
+    memset(archivado, 0, sizeof(HistoricoArchivado));
+}
 
-    printf("Datos registrados correctamente para la zona %s.\n", zonas[id_zona - 1].nombre);
-    
-    // Guardar zona actualizada automáticamente
-    guardarZona(&zonas[id_zona - 1]);
-    
-    // Limpiar buffer de entrada
-    fflush(stdin);
+// Días de la zona contando la ventana de historico[] y los archivados
+int diasTotalesZona(ZonaUrbana *zona) {
+    return zona->dias_registrados + zona->archivado.num_registros;
+}
 
+// Día 'dia' del histórico completo (0 = más reciente): primero la ventana y luego
+// los archivados, del más nuevo al más antiguo
+RegistroHistorico registroHistoricoCompleto(ZonaUrbana *zona, int dia) {
+    if(dia < zona->dias_registrados) {
+        return zona->historico_fechas[dia];
+    }
+    return *registroArchivado(&zona->archivado, diasTotalesZona(zona) - 1 - dia);
 }
 
-void monitoreoDetalladoPorZona(ZonaUrbana zonas[]) {
-    // Obtener fecha y hora actual
-    time_t tiempo_actual;
-    struct tm *info_tiempo;
-    time(&tiempo_actual);
-    info_tiempo = localtime(&tiempo_actual);
-    
-    printf("=== MONITOREO ACTUAL DE CALIDAD DEL AIRE ===\n");
-    printf("Fecha: %02d/%02d/%04d - Hora: %02d:%02d\n", 
-           info_tiempo->tm_mday, 
-           info_tiempo->tm_mon + 1, 
-           info_tiempo->tm_year + 1900,
-           info_tiempo->tm_hour,
-           info_tiempo->tm_min);
-    printf("=============================================\n\n");
-    
-    // DASHBOARD GENERAL - Vista rápida de todas las zonas
-    printf("ESTADO ACTUAL DEL SISTEMA:\n");
-    printf("===========================================\n");
+// ============ FUNCIONES PARA HUECOS Y DUPLICADOS DEL HISTORICO ============
+
+int bitDeMapa(const unsigned int *mapa, int dia) {
+    return (mapa[dia / 32] >> (dia % 32)) & 1;
+}
+
+void marcarBitDeMapa(unsigned int *mapa, int dia, int valor) {
+    if(valor) {
+        mapa[dia / 32] |= 1u << (dia % 32);
+    } else {
+        mapa[dia / 32] &= ~(1u << (dia % 32));
+    }
+}
+
+// Corre un mapa de 'bits' días un día hacia el pasado: el bit i pasa a i + 1, el del
+// día 0 queda en cero y el que pasa del último día se descarta
+void desplazarMapaBits(unsigned int *mapa, int palabras, int bits) {
+    for(int p = palabras - 1; p > 0; p--) {
+        mapa[p] = (mapa[p] << 1) | (mapa[p - 1] >> 31);
+    }
+    mapa[0] <<= 1;
+    if(bits % 32 != 0) {
+        mapa[palabras - 1] &= (1u << (bits % 32)) - 1;
+    }
+}
+
+// Corre el mapa de la ventana como el FIFO de historico[]
+void desplazarMapaDias(unsigned int *mapa) {
+    desplazarMapaBits(mapa, PALABRAS_MAPA_DIAS, MAX_DIAS_HISTORICOS);
+}
+
+// Bits en uno de una palabra; con GCC (MinGW) es la instrucción popcount del procesador
+int contarBitsPalabra(unsigned int palabra) {
+#ifdef __GNUC__
+    return __builtin_popcount(palabra);
+#else
+    palabra = palabra - ((palabra >> 1) & 0x55555555u);
+    palabra = (palabra & 0x33333333u) + ((palabra >> 2) & 0x33333333u);
+    palabra = (palabra + (palabra >> 4)) & 0x0F0F0F0Fu;
+    return (palabra * 0x01010101u) >> 24;
+#endif
+}
+
+int contarBitsMapa(const unsigned int *mapa) {
+    int total = 0;
+    for(int p = 0; p < PALABRAS_MAPA_DIAS; p++) {
+        total += contarBitsPalabra(mapa[p]);
+    }
+    return total;
+}
+
+// Día del histórico completo completado por interpolación (solo hay en la ventana)
+int diaImputado(ZonaUrbana *zona, int dia) {
+    return dia < zona->dias_registrados && bitDeMapa(zona->dias_imputados, dia);
+}
+
+// Registro más antiguo de una fecha que se registró más de una vez
+int diaDuplicado(ZonaUrbana *zona, int dia) {
+    return dia < zona->dias_registrados && bitDeMapa(zona->dias_duplicados, dia);
+}
+
+// Día que no es una lectura propia (completado por interpolación o reemplazado por otro
+// registro de la misma fecha): los análisis lo omiten
+int diaExcluidoDeAnalisis(ZonaUrbana *zona, int dia) {
+    return diaImputado(zona, dia) || diaDuplicado(zona, dia);
+}
+
+// Marca los días de la ventana con la misma fecha que el día siguiente más reciente
+void marcarDuplicadosZona(ZonaUrbana *zona) {
+    memset(zona->dias_duplicados, 0, sizeof(zona->dias_duplicados));
+    long anterior = 0;
+    for(int i = 0; i < zona->dias_registrados; i++) {
+        long numero = numeroDeDia(zona->historico_fechas[i].fecha);
+        if(i > 0 && numero == anterior) {
+            marcarBitDeMapa(zona->dias_duplicados, i, 1);
+        }
+        anterior = numero;
+    }
+}
+
+// Posición del día 'objetivo' entre las 'fin' primeras de la serie cronológica; -1 si falta
+int buscarDiaEnSerie(long numeros[], int fin, long objetivo) {
+    for(int j = fin - 1; j >= 0 && numeros[j] >= objetivo; j--) {
+        if(numeros[j] == objetivo) return j;
+    }
+    return -1;
+}
+
+float interpolarLineal(float antes, float despues, float t) {
+    return antes + (despues - antes) * t;
+}
+
+// Valor de hace una semana más la diferencia con la semana anterior, interpolada
+// entre los extremos del hueco: conserva el ciclo semanal del tráfico
+float interpolarEstacional(float semana, float antes, float antes_semana,
+                           float despues, float despues_semana, float t) {
+    return semana + interpolarLineal(antes - antes_semana, despues - despues_semana, t);
+}
+
+// Revisa las fechas de la ventana y completa los huecos de hasta MAX_DIAS_IMPUTABLES
+// días. Los días completados se marcan en dias_imputados y nunca se guardan, así que
+// el archivo solo tiene lecturas reales y la interpolación se repite en cada carga.
+// Si la ventana se llena, los días reales más antiguos pasan al histórico archivado.
+// Devuelve 0 si no hubo memoria para archivar.
+int completarHuecosZona(ZonaUrbana *zona, int *huecos_completados) {
+    int n = zona->dias_registrados;
+    long numeros[MAX_DIAS_HISTORICOS];
+    int faltantes = 0, huecos = 0, completados = 0;
+    
+    memset(zona->dias_imputados, 0, sizeof(zona->dias_imputados));
+    zona->huecos_sin_completar = 0;
+    *huecos_completados = 0;
+    
+    for(int i = 0; i < n; i++) {
+        numeros[i] = numeroDeDia(zona->historico_fechas[i].fecha);
+    }
+    // Una sola pasada sin saltos sobre las diferencias entre días consecutivos
+    for(int i = 0; i < n - 1; i++) {
+        long diferencia = numeros[i] - numeros[i + 1];
+        int hueco = diferencia > 1;
+        int imputable = hueco & (diferencia - 1 <= MAX_DIAS_IMPUTABLES);
+        huecos += hueco;
+        completados += imputable;
+        faltantes += imputable * (int)(diferencia - 1);
+    }
+    zona->huecos_sin_completar = huecos - completados;
+    if(faltantes == 0) {
+        marcarDuplicadosZona(zona);
+        return 1;
+    }
     
-    int zonas_activas = 0;
-    int alertas_criticas = 0;
+    // Serie cronológica (del más antiguo al más reciente) con los días completados
+    int total = n + faltantes;
+    RegistroHistorico *serie = malloc(total * sizeof(RegistroHistorico));
+    long *numeros_serie = malloc(total * sizeof(long));
+    unsigned char *imputado = malloc(total);
+    if(serie == NULL || numeros_serie == NULL || imputado == NULL) {
+        free(serie);
+        free(numeros_serie);
+        free(imputado);
+        marcarDuplicadosZona(zona);
+        return 1; // Sin memoria para completar: la ventana queda como se leyó
+    }
     
-    for(int i = 0; i < MAX_ZONAS; i++) {
-        if(zonas[i].dias_registrados > 0) {
-            zonas_activas++;
-            
-            // Contar excesos críticos
-            int excesos = 0;
-            if(zonas[i].niveles_actuales.co2 > LIMITE_CO2_OMS) excesos++;
-            if(zonas[i].niveles_actuales.so2 > LIMITE_SO2_OMS) excesos++;
-            if(zonas[i].niveles_actuales.no2 > LIMITE_NO2_OMS) excesos++;
-            if(zonas[i].niveles_actuales.pm25 > LIMITE_PM25_OMS) excesos++;
+    int k = 0;
+    for(int i = n - 1; i >= 0; i--) {
+        RegistroHistorico actual = registroDeZona(zona, i);
+        long diferencia = (i < n - 1) ? numeros[i] - numeros[i + 1] : 0;
+        
+        if(diferencia > 1 && diferencia - 1 <= MAX_DIAS_IMPUTABLES) {
+            RegistroHistorico antes = serie[k - 1];
+            long inicio = numeros_serie[k - 1];
+            int pos_antes = buscarDiaEnSerie(numeros_serie, k, inicio - PERIODO_ESTACIONAL);
+            int pos_despues = buscarDiaEnSerie(numeros_serie, k, numeros[i] - PERIODO_ESTACIONAL);
             
-            // Determinar estado visual
-            char estado_icono[20];
-            if(excesos == 0) {
-                strcpy(estado_icono, "BUENO");
-            } else if(excesos <= 1) {
-                strcpy(estado_icono, "MODERADO");
-            } else if(excesos <= 2) {
-                strcpy(estado_icono, "DANINO");
-                alertas_criticas++;
-            } else {
-                strcpy(estado_icono, "CRITICO");
-                alertas_criticas++;
+            for(int g = 1; g < diferencia; g++) {
+                float t = (float)g / diferencia;
+                RegistroHistorico *nuevo = &serie[k];
+                nuevo->fecha = fechaDeNumeroDeDia(inicio + g);
+                nuevo->niveles.co2 = interpolarLineal(antes.niveles.co2, actual.niveles.co2, t);
+                nuevo->niveles.so2 = interpolarLineal(antes.niveles.so2, actual.niveles.so2, t);
+                nuevo->niveles.no2 = interpolarLineal(antes.niveles.no2, actual.niveles.no2, t);
+                nuevo->niveles.pm25 = interpolarLineal(antes.niveles.pm25, actual.niveles.pm25, t);
+                nuevo->clima.temperatura = interpolarLineal(antes.clima.temperatura, actual.clima.temperatura, t);
+                nuevo->clima.velocidad_viento = interpolarLineal(antes.clima.velocidad_viento,
+                                                                 actual.clima.velocidad_viento, t);
+                nuevo->clima.humedad = interpolarLineal(antes.clima.humedad, actual.clima.humedad, t);
+                nuevo->clima.presion_atmosferica = interpolarLineal(antes.clima.presion_atmosferica,
+                                                                    actual.clima.presion_atmosferica, t);
+                
+                // Con una semana completa antes del hueco, los contaminantes siguen el ciclo semanal
+                int pos_semana = buscarDiaEnSerie(numeros_serie, k, inicio + g - PERIODO_ESTACIONAL);
+                if(pos_antes >= 0 && pos_despues >= 0 && pos_semana >= 0) {
+                    NivelesContaminacion *semana = &serie[pos_semana].niveles;
+                    NivelesContaminacion *antes_semana = &serie[pos_antes].niveles;
+                    NivelesContaminacion *despues_semana = &serie[pos_despues].niveles;
+                    nuevo->niveles.co2 = interpolarEstacional(semana->co2, antes.niveles.co2, antes_semana->co2,
+                                                              actual.niveles.co2, despues_semana->co2, t);
+                    nuevo->niveles.so2 = interpolarEstacional(semana->so2, antes.niveles.so2, antes_semana->so2,
+                                                              actual.niveles.so2, despues_semana->so2, t);
+                    nuevo->niveles.no2 = interpolarEstacional(semana->no2, antes.niveles.no2, antes_semana->no2,
+                                                              actual.niveles.no2, despues_semana->no2, t);
+                    nuevo->niveles.pm25 = interpolarEstacional(semana->pm25, antes.niveles.pm25, antes_semana->pm25,
+                                                               actual.niveles.pm25, despues_semana->pm25, t);
+                    // Las lecturas no pueden ser negativas
+                    if(nuevo->niveles.co2 < 0) nuevo->niveles.co2 = 0;
+                    if(nuevo->niveles.so2 < 0) nuevo->niveles.so2 = 0;
+                    if(nuevo->niveles.no2 < 0) nuevo->niveles.no2 = 0;
+                    if(nuevo->niveles.pm25 < 0) nuevo->niveles.pm25 = 0;
+                }
+                numeros_serie[k] = inicio + g;
+                imputado[k] = 1;
+                k++;
             }
-            
-            printf("%-20s | %s\n", zonas[i].nombre, estado_icono);
-        } else {
-            printf("%-20s | SIN DATOS\n", zonas[i].nombre);
         }
+        serie[k] = actual;
+        numeros_serie[k] = numeros[i];
+        imputado[k] = 0;
+        k++;
     }
     
-    printf("\nRESUMEN: %d/%d zonas activas | %d alertas criticas\n", 
-           zonas_activas, MAX_ZONAS, alertas_criticas);
+    // Lo que no cabe en la ventana son los días más antiguos: los reales se archivan
+    int en_ventana = total < MAX_DIAS_HISTORICOS ? total : MAX_DIAS_HISTORICOS;
+    int correcto = 1;
+    for(int j = 0; correcto && j < total - en_ventana; j++) {
+        if(!imputado[j]) {
+            correcto = archivarRegistro(&zona->archivado, serie[j]);
+        }
+    }
+    if(correcto) {
+        for(int w = 0; w < en_ventana; w++) {
+            zona->historico_fechas[w] = serie[total - 1 - w];
+            zona->historico[w] = serie[total - 1 - w].niveles;
+            marcarBitDeMapa(zona->dias_imputados, w, imputado[total - 1 - w]);
+        }
+        zona->dias_registrados = en_ventana;
+        *huecos_completados = completados;
+    }
     
-    // SELECCIÓN DE ZONA PARA MONITOREO DETALLADO
-    printf("\n===========================================\n");
-    printf("MONITOREO DETALLADO POR ZONA\n");
-    printf("===========================================\n");
-    
-    int zona_seleccionada, val;
-    
-    printf("\nZONAS DISPONIBLES:\n");
-    for(int i = 0; i < MAX_ZONAS; i++) {
-        printf("%d. %s", zonas[i].id_zona, zonas[i].nombre);
-        if(zonas[i].dias_registrados > 0) {
-            // Mostrar fecha del último registro
-            printf(" (Ultimo: %02d/%02d/%04d)", 
-                   zonas[i].historico_fechas[0].fecha.dia,
-                   zonas[i].historico_fechas[0].fecha.mes,
-                   zonas[i].historico_fechas[0].fecha.año);
-        } else {
-            printf(" (Sin datos)");
+    free(serie);
+    free(numeros_serie);
+    free(imputado);
+    marcarDuplicadosZona(zona);
+    return correcto;
+}
+
+// ================ FUNCIONES PARA LOS MAPAS DE EXCESOS ================
+// Cada zona guarda un plano de bits por contaminante sobre el histórico completo en
+// memoria (bit i = día i, 0 el más reciente). Los conteos de días sobre el límite se
+// resuelven con popcount por palabras de 32 días en lugar de comparar cada lectura.
+
+// Máscara de 4 bits con los contaminantes que exceden su límite (bit c = contaminante c)
+int excesosDeNiveles(NivelesContaminacion niveles, const float *limites) {
+    return (niveles.co2 > limites[0]) | (niveles.so2 > limites[1]) << 1 |
+           (niveles.no2 > limites[2]) << 2 | (niveles.pm25 > limites[3]) << 3;
+}
+
+// Máscara del día 'dia' en cuatro planos consecutivos de 'palabras' palabras
+int excesosEnPlanos(const unsigned int *planos, int palabras, int dia) {
+    int mascara = 0;
+    for(int c = 0; c < 4; c++) {
+        mascara |= bitDeMapa(planos + c * palabras, dia) << c;
+    }
+    return mascara;
+}
+
+// Máscara del día 'dia' del histórico completo; los días más allá del mapa (histórico
+// archivado aún sin retención) se calculan desde la lectura
+int excesosDeDia(ZonaUrbana *zona, int dia) {
+    if(dia >= DIAS_MAPA_EXCESOS) {
+        return excesosDeNiveles(registroHistoricoCompleto(zona, dia).niveles, zona->limites);
+    }
+    return excesosEnPlanos(zona->excesos[0], PALABRAS_MAPA_EXCESOS, dia);
+}
+
+// Los días imputados o duplicados quedan sin excesos: no son lecturas propias
+void marcarExcesosDia(ZonaUrbana *zona, int dia, NivelesContaminacion niveles) {
+    if(dia >= DIAS_MAPA_EXCESOS) {
+        return;
+    }
+    int mascara = diaExcluidoDeAnalisis(zona, dia) ? 0 : excesosDeNiveles(niveles, zona->limites);
+    for(int c = 0; c < 4; c++) {
+        marcarBitDeMapa(zona->excesos[c], dia, (mascara >> c) & 1);
+    }
+}
+
+// Un día nuevo al frente del histórico: los demás se corren una posición
+void agregarDiaMapaExcesos(ZonaUrbana *zona, NivelesContaminacion niveles) {
+    for(int c = 0; c < 4; c++) {
+        desplazarMapaBits(zona->excesos[c], PALABRAS_MAPA_EXCESOS, DIAS_MAPA_EXCESOS);
+    }
+    marcarExcesosDia(zona, 0, niveles);
+}
+
+// Reconstruye los mapas con todo el histórico en memoria (al cargar, importar o
+// descartar un día intermedio)
+void recalcularMapaExcesos(ZonaUrbana *zona) {
+    int total = diasTotalesZona(zona);
+    memset(zona->excesos, 0, sizeof(zona->excesos));
+    for(int d = 0; d < total && d < DIAS_MAPA_EXCESOS; d++) {
+        NivelesContaminacion niveles = d < zona->dias_registrados ? zona->historico[d]
+                                                                  : registroHistoricoCompleto(zona, d).niveles;
+        marcarExcesosDia(zona, d, niveles);
+    }
+}
+
+// Bits de la palabra p que caen en los días [desde, hasta)
+unsigned int mascaraRangoPalabra(int p, int desde, int hasta) {
+    unsigned int mascara = 0xFFFFFFFFu;
+    if(desde > p * 32) mascara &= 0xFFFFFFFFu << (desde - p * 32);
+    if(hasta < p * 32 + 32) mascara &= 0xFFFFFFFFu >> (p * 32 + 32 - hasta);
+    return mascara;
+}
+
+// Días de la palabra p con al menos 'minimo' contaminantes (1 a 4) sobre su límite.
+// Los cuatro planos se suman bit a bit: al_menos[k] queda con los días que tienen
+// k + 1 excesos o más.
+unsigned int diasConExcesosPalabra(const unsigned int *planos, int palabras, int p, int minimo) {
+    unsigned int al_menos[4] = {0, 0, 0, 0};
+    for(int c = 0; c < 4; c++) {
+        unsigned int plano = planos[c * palabras + p];
+        al_menos[3] |= al_menos[2] & plano;
+        al_menos[2] |= al_menos[1] & plano;
+        al_menos[1] |= al_menos[0] & plano;
+        al_menos[0] |= plano;
+    }
+    return al_menos[minimo - 1];
+}
+
+// Días de [desde, hasta) con al menos 'minimo' excesos; 'hasta' no puede pasar del mapa
+int contarDiasConExcesosEnPlanos(const unsigned int *planos, int palabras, int desde, int hasta, int minimo) {
+    int total = 0;
+    if(minimo < 1) minimo = 1;
+    if(minimo > 4) return 0;
+    for(int p = desde / 32; desde < hasta && p <= (hasta - 1) / 32; p++) {
+        total += contarBitsPalabra(diasConExcesosPalabra(planos, palabras, p, minimo) &
+                                   mascaraRangoPalabra(p, desde, hasta));
+    }
+    return total;
+}
+
+// Primer día de [desde, hasta) con algún exceso, o 'hasta' si no hay ninguno. Salta de
+// a 32 días los tramos sin excesos.
+int siguienteDiaConExcesos(const unsigned int *planos, int palabras, int desde, int hasta) {
+    for(int p = desde / 32; desde < hasta && p <= (hasta - 1) / 32; p++) {
+        unsigned int dias = diasConExcesosPalabra(planos, palabras, p, 1) & mascaraRangoPalabra(p, desde, hasta);
+        if(dias != 0) {
+            // Posición del bit más bajo: los unos que quedan por debajo de él
+            return p * 32 + contarBitsPalabra((dias & (0u - dias)) - 1);
         }
-        printf("\n");
     }
-    
-    // Seleccionar zona
-    do {
-        printf("\nSeleccione la zona para monitoreo actual (1-%d): ", MAX_ZONAS);
-        val = scanf("%d", &zona_seleccionada);
-        fflush(stdin);
-        
-        if(val != 1 || zona_seleccionada < 1 || zona_seleccionada > MAX_ZONAS) {
-            printf("Opcion invalida. Por favor, intente de nuevo.\n");
+    return hasta;
+}
+
+// Días de [desde, hasta) en que el contaminante excede su límite
+int contarExcesosContaminante(ZonaUrbana *zona, int desde, int hasta, int tipo_contaminante) {
+    int total = 0;
+    if(hasta > diasTotalesZona(zona)) hasta = diasTotalesZona(zona);
+    int fin_mapa = hasta < DIAS_MAPA_EXCESOS ? hasta : DIAS_MAPA_EXCESOS;
+    
+    for(int p = desde / 32; desde < fin_mapa && p <= (fin_mapa - 1) / 32; p++) {
+        total += contarBitsPalabra(zona->excesos[tipo_contaminante][p] & mascaraRangoPalabra(p, desde, fin_mapa));
+    }
+    for(int d = desde > fin_mapa ? desde : fin_mapa; d < hasta; d++) {
+        total += (excesosDeDia(zona, d) >> tipo_contaminante) & 1;
+    }
+    return total;
+}
+
+// Días de [desde, hasta) del histórico completo con al menos 'minimo' excesos
+int contarDiasConExcesos(ZonaUrbana *zona, int desde, int hasta, int minimo) {
+    if(minimo < 1) minimo = 1;
+    if(hasta > diasTotalesZona(zona)) hasta = diasTotalesZona(zona);
+    int fin_mapa = hasta < DIAS_MAPA_EXCESOS ? hasta : DIAS_MAPA_EXCESOS;
+    int total = contarDiasConExcesosEnPlanos(zona->excesos[0], PALABRAS_MAPA_EXCESOS, desde, fin_mapa, minimo);
+    
+    for(int d = desde > fin_mapa ? desde : fin_mapa; d < hasta; d++) {
+        total += contarBitsPalabra(excesosDeDia(zona, d)) >= minimo;
+    }
+    return total;
+}
+
+// =================== FUNCIONES PARA ARCHIVOS SEPARADOS ===================
+
+// Zonas guardadas desde la última sincronización con el disco
+static int zonas_sin_sincronizar[MAX_ZONAS];
+static int guardados_sin_sincronizar = 0;
+
+// CRC32 (polinomio 0xEDB88320) con tabla calculada en el primer uso
+unsigned int calcularCRC32(const void *datos, size_t longitud) {
+    static unsigned int tabla[256];
+    static int tabla_lista = 0;
+    
+    if(!tabla_lista) {
+        for(unsigned int i = 0; i < 256; i++) {
+            unsigned int c = i;
+            for(int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            tabla[i] = c;
         }
-    } while(val != 1 || zona_seleccionada < 1 || zona_seleccionada > MAX_ZONAS);
-    
-    zona_seleccionada--;
-    
-    // Verificar si la zona tiene datos
-    if(zonas[zona_seleccionada].dias_registrados == 0) {
-        printf("\nERROR: La zona '%s' no tiene datos registrados.\n", 
-               zonas[zona_seleccionada].nombre);
-        printf("   Registre datos primero usando la opcion 1 del menu.\n");
-        return;
+        tabla_lista = 1;
     }
     
-    // ================= MONITOREO ACTUAL =================
-    printf("\nMONITOREO ACTUAL: %s\n", zonas[zona_seleccionada].nombre);
-    printf("===========================================\n");
-    
-    // Fecha del último registro
-    printf("Ultimo registro: %02d/%02d/%04d\n", 
-           zonas[zona_seleccionada].historico_fechas[0].fecha.dia,
-           zonas[zona_seleccionada].historico_fechas[0].fecha.mes,
-           zonas[zona_seleccionada].historico_fechas[0].fecha.año);
-    
-    // 1. NIVELES ACTUALES DE CONTAMINANTES
-    printf("\nNIVELES DE CONTAMINANTES ACTUALES:\n");
-    printf("-------------------------------------------\n");
-    
-    // CO2
-    printf("CO2:   %6.1f ppm   | Limite: %6.1f | ", 
-           zonas[zona_seleccionada].niveles_actuales.co2, LIMITE_CO2_OMS);
-    if(zonas[zona_seleccionada].niveles_actuales.co2 > LIMITE_CO2_OMS) {
-        printf("EXCEDE (%.1f%%)\n", 
-               (zonas[zona_seleccionada].niveles_actuales.co2 / LIMITE_CO2_OMS) * 100 - 100);
-    } else {
-        printf("NORMAL\n");
+    const unsigned char *bytes = datos;
+    unsigned int crc = 0xFFFFFFFFu;
+    for(size_t i = 0; i < longitud; i++) {
+        crc = tabla[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
     }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Fuerza la escritura en disco del contenido de un archivo abierto
+void sincronizarArchivo(FILE *f) {
+    fflush(f);
+#ifdef _WIN32
+    _commit(_fileno(f));
+#else
+    fsync(fileno(f));
+#endif
+}
+
+// Reemplaza destino por origen en una sola operación atómica
+int reemplazarArchivo(char *origen, char *destino) {
+#ifdef _WIN32
+    return MoveFileExA(origen, destino, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+    return rename(origen, destino);
+#endif
+}
+
+// Sincroniza con el disco los archivos de zona escritos desde la última sincronización
+// y el directorio que contiene sus renombrados
+void sincronizarZonasPendientes(void) {
+    char nombre_archivo[100];
     
-    // SO2
-    printf("SO2:   %6.1f ug/m3 | Limite: %6.1f | ",
-           zonas[zona_seleccionada].niveles_actuales.so2, LIMITE_SO2_OMS);
-    if(zonas[zona_seleccionada].niveles_actuales.so2 > LIMITE_SO2_OMS) {
-        printf("EXCEDE (%.1f%%)\n", 
-               (zonas[zona_seleccionada].niveles_actuales.so2 / LIMITE_SO2_OMS) * 100 - 100);
-    } else {
-        printf("NORMAL\n");
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        if(!zonas_sin_sincronizar[i]) continue;
+        
+        sprintf(nombre_archivo, "zona_%d.dat", i + 1);
+        FILE *f = fopen(nombre_archivo, "rb");
+        if(f != NULL) {
+            sincronizarArchivo(f);
+            fclose(f);
+        }
+        zonas_sin_sincronizar[i] = 0;
     }
     
-    // NO2
-    printf("NO2:   %6.1f ug/m3 | Limite: %6.1f | ",
-           zonas[zona_seleccionada].niveles_actuales.no2, LIMITE_NO2_OMS);
-    if(zonas[zona_seleccionada].niveles_actuales.no2 > LIMITE_NO2_OMS) {
-        printf("EXCEDE (%.1f%%)\n", 
-               (zonas[zona_seleccionada].niveles_actuales.no2 / LIMITE_NO2_OMS) * 100 - 100);
-    } else {
-        printf("NORMAL\n");
+#ifndef _WIN32
+    int directorio = open(".", O_RDONLY);
+    if(directorio >= 0) {
+        fsync(directorio);
+        close(directorio);
     }
+#endif
+    guardados_sin_sincronizar = 0;
+}
+
+// Escribe la zona en zona_N.tmp y la publica renombrándola a zona_N.dat, de modo que
+// una caída durante la escritura nunca deja a medias el único archivo de la zona.
+// Formato: cabecera + bloque de zona + CRC + un registro con CRC por día.
+int guardarZonaEnArchivo(ZonaUrbana *zona, int sincronizar) {
+    char nombre_archivo[100], nombre_temporal[100];
+    sprintf(nombre_archivo, "zona_%d.dat", zona->id_zona);
+    sprintf(nombre_temporal, "zona_%d.tmp", zona->id_zona);
     
-    // PM2.5
-    printf("PM2.5: %6.1f ug/m3 | Limite: %6.1f | ",
-           zonas[zona_seleccionada].niveles_actuales.pm25, LIMITE_PM25_OMS);
-    if(zonas[zona_seleccionada].niveles_actuales.pm25 > LIMITE_PM25_OMS) {
-        printf("EXCEDE (%.1f%%)\n", 
-               (zonas[zona_seleccionada].niveles_actuales.pm25 / LIMITE_PM25_OMS) * 100 - 100);
-    } else {
-        printf("NORMAL\n");
+    // Los percentiles se publican antes, con la generación que tendrá zona_N.dat
+    if(!guardarCuantilesZona(zona, zona->generacion + 1, sincronizar)) {
+        return 0;
     }
     
-    // 2. CONDICIONES CLIMÁTICAS ACTUALES
-    printf("\nCONDICIONES CLIMATICAS ACTUALES:\n");
-    printf("-------------------------------------------\n");
-    printf("Temperatura:       %6.1f°C\n", zonas[zona_seleccionada].clima_actual.temperatura);
-    printf("Viento:           %6.1f km/h\n", zonas[zona_seleccionada].clima_actual.velocidad_viento);
-    printf("Humedad:          %6.1f%%\n", zonas[zona_seleccionada].clima_actual.humedad);
-    printf("Presion:          %6.1f hPa\n", zonas[zona_seleccionada].clima_actual.presion_atmosferica);
+    FILE *f = fopen(nombre_temporal, "wb");
+    if(f == NULL) {
+        return 0;
+    }
     
-    // 3. ÍNDICE DE CALIDAD DEL AIRE (ICA)
-    printf("\nINDICE DE CALIDAD DEL AIRE:\n");
-    printf("-------------------------------------------\n");
+    CabeceraArchivoZona cabecera;
+    memset(&cabecera, 0, sizeof(cabecera));
+    memcpy(cabecera.magia, MAGIA_ARCHIVO_ZONA, 4);
+    cabecera.version = VERSION_ARCHIVO_ZONA;
+    cabecera.num_registros = diasTotalesZona(zona) - contarBitsMapa(zona->dias_imputados);
+    cabecera.tamano_registro = sizeof(RegistroHistorico);
+    cabecera.generacion = zona->generacion + 1;
+    cabecera.crc = calcularCRC32(&cabecera, offsetof(CabeceraArchivoZona, crc));
+    
+    // memset deja en cero el relleno de las estructuras, que también entra en el CRC
+    DatosZonaArchivo datos;
+    memset(&datos, 0, sizeof(datos));
+    snprintf(datos.nombre, MAX_NOMBRE, "%s", zona->nombre);
+    datos.id_zona = zona->id_zona;
+    datos.niveles_actuales = zona->niveles_actuales;
+    datos.clima_actual = zona->clima_actual;
+    memcpy(datos.promedio_30_dias, obtenerPromedio30Dias(zona), sizeof(datos.promedio_30_dias));
+    datos.ubicacion = zona->ubicacion;
+    memcpy(datos.modelos, zona->modelos, sizeof(datos.modelos));
+    datos.modelos_ajustados = zona->modelos_ajustados;
+    unsigned int crc_datos = calcularCRC32(&datos, sizeof(datos));
+    
+    int correcto = fwrite(&cabecera, sizeof(cabecera), 1, f) == 1 &&
+                   fwrite(&datos, sizeof(datos), 1, f) == 1 &&
+                   fwrite(&crc_datos, sizeof(crc_datos), 1, f) == 1;
+    
+    for(int i = 0; correcto && i < zona->dias_registrados; i++) {
+        if(diaImputado(zona, i)) {
+            continue; // Los días completados al cargar se recalculan en cada carga
+        }
+        RegistroArchivoZona registro;
+        memset(&registro, 0, sizeof(registro));
+        registro.registro = zona->historico_fechas[i];
+        registro.registro.niveles = zona->historico[i];
+        registro.crc = calcularCRC32(&registro.registro, sizeof(RegistroHistorico));
+        correcto = fwrite(&registro, sizeof(registro), 1, f) == 1;
+    }
+    // Los días archivados siguen a la ventana, también del más reciente al más antiguo
+    for(int i = zona->archivado.num_registros - 1; correcto && i >= 0; i--) {
+        RegistroArchivoZona registro;
+        memset(&registro, 0, sizeof(registro));
+        registro.registro = *registroArchivado(&zona->archivado, i);
+        registro.crc = calcularCRC32(&registro.registro, sizeof(RegistroHistorico));
+        correcto = fwrite(&registro, sizeof(registro), 1, f) == 1;
+    }
     
-    int contaminantes_excedidos = 0;
-    if(zonas[zona_seleccionada].niveles_actuales.co2 > LIMITE_CO2_OMS) contaminantes_excedidos++;
-    if(zonas[zona_seleccionada].niveles_actuales.so2 > LIMITE_SO2_OMS) contaminantes_excedidos++;
-    if(zonas[zona_seleccionada].niveles_actuales.no2 > LIMITE_NO2_OMS) contaminantes_excedidos++;
-    if(zonas[zona_seleccionada].niveles_actuales.pm25 > LIMITE_PM25_OMS) contaminantes_excedidos++;
+    if(correcto && sincronizar) {
+        sincronizarArchivo(f);
+    }
+    if(fclose(f) != 0) {
+        correcto = 0;
+    }
     
-    if(contaminantes_excedidos == 0) {
-        printf("BUENO - Calidad del aire satisfactoria\n");
-        printf("   Seguro para actividades al aire libre\n");
-    } else if(contaminantes_excedidos == 1) {
-        printf("MODERADO - Calidad del aire aceptable\n");
-        printf("   Grupos sensibles deben limitar actividades prolongadas\n");
-    } else if(contaminantes_excedidos <= 2) {
-        printf("DANINO - Calidad del aire no saludable\n");
-        printf("   Todos deben reducir actividades al aire libre\n");
-    } else {
-        printf("CRITICO - Calidad del aire peligrosa\n");
-        printf("   Evitar actividades al aire libre\n");
+    if(!correcto || reemplazarArchivo(nombre_temporal, nombre_archivo) != 0) {
+        remove(nombre_temporal);
+        return 0;
     }
     
-    // 4. RECOMENDACIONES INMEDIATAS
-    printf("\nRECOMENDACIONES INMEDIATAS:\n");
-    printf("-------------------------------------------\n");
+    // La memoria vuelve a coincidir con el archivo publicado
+    zona->generacion = cabecera.generacion;
+    zona->modificada = 0;
+    return 1;
+}
+
+// Pausa breve entre intentos de bloqueo
+void esperarMilisegundos(int milisegundos) {
+#ifdef _WIN32
+    Sleep(milisegundos);
+#else
+    struct timespec espera;
+    espera.tv_sec = milisegundos / 1000;
+    espera.tv_nsec = (milisegundos % 1000) * 1000000L;
+    nanosleep(&espera, NULL);
+#endif
+}
+
+// Identificador de esta instancia en sus archivos de bloqueo
+const char *tokenInstancia(void) {
+    static char token[40] = "";
+    if(token[0] == '\0') {
+#ifdef _WIN32
+        long proceso = (long)GetCurrentProcessId();
+#else
+        long proceso = (long)getpid();
+#endif
+        sprintf(token, "%ld-%lld", proceso, (long long)time(NULL));
+    }
+    return token;
+}
+
+// Lee la hora de creación y el dueño de un archivo de bloqueo. Devuelve 0 si no existe;
+// un archivo recién creado puede estar vacío todavía (hora 0)
+int leerBloqueo(char *nombre_bloqueo, long long *creado, char *token) {
+    FILE *f = fopen(nombre_bloqueo, "r");
+    if(f == NULL) {
+        return 0;
+    }
+    *creado = 0;
+    token[0] = '\0';
+    if(fscanf(f, "%lld %39s", creado, token) < 1) {
+        *creado = 0;
+    }
+    fclose(f);
+    return 1;
+}
+
+// Borra zona_N.lck solo si sigue siendo el bloqueo leído (misma hora y dueño; hora 0 =
+// cualquier hora). Los borrados se hacen con zona_N.lck.rmp tomado en modo exclusivo,
+// así dos instancias no pueden borrar una el bloqueo que la otra acaba de crear.
+// Devuelve 1 si se borró, 0 si el bloqueo ya es otro y -1 si otra instancia está borrando.
+int borrarBloqueoSiCoincide(char *nombre_bloqueo, long long creado, const char *token) {
+    char nombre_auxiliar[110], token_actual[40];
+    long long creado_actual;
+    sprintf(nombre_auxiliar, "%s.rmp", nombre_bloqueo);
+    
+    FILE *f = fopen(nombre_auxiliar, "wx");
+    if(f == NULL) {
+        // Solo queda abandonado si una instancia terminó en medio de un borrado
+        if(leerBloqueo(nombre_auxiliar, &creado_actual, token_actual) && creado_actual > 0 &&
+           (long long)time(NULL) - creado_actual > ANTIGUEDAD_BLOQUEO_SEG) {
+            remove(nombre_auxiliar);
+        }
+        return -1;
+    }
+    fprintf(f, "%lld %s\n", (long long)time(NULL), tokenInstancia());
+    fclose(f);
     
-    if(contaminantes_excedidos == 0) {
-        printf("- Condiciones favorables para actividades exteriores\n");
-        printf("- Mantener monitoreo de rutina\n");
-        printf("- Ventilar espacios interiores\n");
-    } else {
-        printf("- Limitar tiempo de exposicion al aire libre\n");
-        printf("- Usar mascarilla si es necesario salir\n");
-        printf("- Mantener ventanas cerradas\n");
-        printf("- Activar purificadores de aire si estan disponibles\n");
+    int borrado = 0;
+    if(leerBloqueo(nombre_bloqueo, &creado_actual, token_actual) &&
+       (creado == 0 || creado_actual == creado) && strcmp(token_actual, token) == 0) {
+        borrado = remove(nombre_bloqueo) == 0;
+    }
+    remove(nombre_auxiliar);
+    return borrado;
+}
+
+// Bloqueo entre instancias del programa: zona_N.lck se crea en modo exclusivo ("wx"),
+// que falla si otra instancia ya lo tiene. Guarda la hora de creación y el dueño para
+// poder liberar el bloqueo de una instancia que terminó sin quitarlo.
+int bloquearZona(int id_zona) {
+    char nombre_bloqueo[100], token[40];
+    long long creado;
+    sprintf(nombre_bloqueo, "zona_%d.lck", id_zona);
+    
+    for(int intento = 0; intento < INTENTOS_BLOQUEO; intento++) {
+        FILE *f = fopen(nombre_bloqueo, "wx");
+        if(f != NULL) {
+            fprintf(f, "%lld %s\n", (long long)time(NULL), tokenInstancia());
+            fclose(f);
+            return 1;
+        }
         
-        if(contaminantes_excedidos >= 3) {
-            printf("- URGENTE: Grupos vulnerables deben permanecer en interiores\n");
-            printf("- Suspender actividades deportivas al aire libre\n");
+        // Un archivo recién creado puede estar aún vacío: solo se libera si es antiguo
+        if(leerBloqueo(nombre_bloqueo, &creado, token) && creado > 0 &&
+           (long long)time(NULL) - creado > ANTIGUEDAD_BLOQUEO_SEG &&
+           borrarBloqueoSiCoincide(nombre_bloqueo, creado, token) == 1) {
+            continue;
         }
+        esperarMilisegundos(ESPERA_BLOQUEO_MS);
     }
-    
-    printf("\n===========================================\n");
+    return 0;
 }
 
-void mostrarEstadoSistema(ZonaUrbana zonas[])
-{
-    printf("Sistema de Monitoreo - Quito\n");
-    printf("==================================\n\n");
-    
-    // Resumen general
-    int zonas_activas = 0;
-    int total_registros = 0;
-    
-    for(int i = 0; i < MAX_ZONAS; i++) {
-        if(zonas[i].dias_registrados > 0) {
-            zonas_activas++;
-            total_registros += zonas[i].dias_registrados;
+// Quita el bloqueo solo si sigue siendo de esta instancia: si otra lo liberó por
+// antiguo, el archivo actual es de su nuevo dueño
+void desbloquearZona(int id_zona) {
+    char nombre_bloqueo[100];
+    sprintf(nombre_bloqueo, "zona_%d.lck", id_zona);
+    for(int intento = 0; intento < INTENTOS_BLOQUEO; intento++) {
+        if(borrarBloqueoSiCoincide(nombre_bloqueo, 0, tokenInstancia()) >= 0) {
+            return;
         }
+        esperarMilisegundos(ESPERA_BLOQUEO_MS);
     }
-    
-    printf("RESUMEN GENERAL:\n");
-    printf("  Zonas configuradas: %d\n", MAX_ZONAS);
-    printf("  Zonas con datos: %d\n", zonas_activas);
-    printf("  Total de registros: %d\n", total_registros);
-    if(zonas_activas > 0) {
-        printf("  Estado: OPERATIVO\n");
-    } else {
-        printf("  Estado: SIN DATOS\n");
+}
+
+// Recarga la zona si otra instancia publicó una generación distinta de su archivo.
+// Los cambios propios sin guardar (percentiles reconstruidos, compactación) se
+// pierden: se avisa al operador. Devuelve 1 si la zona se recargó.
+int refrescarZona(ZonaUrbana *zona) {
+    if(zona->id_zona < 1 || leerGeneracionArchivo(zona->id_zona) == zona->generacion) {
+        return 0;
     }
     
-    // Estado por zona (resumido)
-    printf("\nESTADO POR ZONA:\n");
-    for(int i = 0; i < MAX_ZONAS; i++) {
-        printf("  %s: %d días registrados", 
-               zonas[i].nombre, zonas[i].dias_registrados);
-        
-        if(zonas[i].dias_registrados > 0) {
-            printf(" OK\n");
-        } else {
-            printf(" SIN DATOS\n");
+    ZonaUrbana *recargada = malloc(sizeof(ZonaUrbana));
+    if(recargada == NULL) {
+        return 0;
+    }
+    int correcto = cargarZona(recargada, zona->id_zona);
+    if(correcto && recargada->generacion == zona->generacion) {
+        // Misma versión que la cargada (p. ej. recuperada de zona_N.tmp con zona_N.dat
+        // dañado): no es un cambio de otra instancia y se conserva la memoria
+        liberarHistoricoArchivado(&recargada->archivado);
+        liberarCuantilesZona(recargada);
+        correcto = 0;
+    } else if(correcto) {
+        if(zona->modificada) {
+            printf("ADVERTENCIA: Otra instancia modifico la zona %s; se recargaron sus datos y se "
+                   "descartaron los cambios sin guardar de esta sesion.\n", zona->nombre);
         }
+        liberarHistoricoArchivado(&zona->archivado);
+        liberarCuantilesZona(zona);
+        *zona = *recargada;
+        publicarInstantaneaZona(zona);
     }
+    free(recargada);
+    return correcto;
 }
 
-void mostrarTendenciasHistorico(ZonaUrbana zonas[]) {
-    printf("=== TENDENCIAS E HISTORICO ===\n");
-    printf("Fecha: %s - Hora: %s\n", __DATE__, __TIME__);
-    printf("======================================================\n");
-    printf("GRAFICOS Y ANALISIS DE DATOS HISTORICOS\n");
-    printf("======================================================\n\n");
-    
-    int zona_seleccionada, val;
+// Guarda la zona con su bloqueo ya tomado. Si otra instancia guardó el archivo desde
+// la última carga, no se escribe encima: la zona se recarga y se devuelve 0.
+int guardarZonaBloqueada(ZonaUrbana *zona) {
+    if(zona->id_zona < 1 || zona->id_zona > MAX_ZONAS) {
+        printf("Error: la zona no se cargo; no se guarda sobre su archivo.\n");
+        return 0;
+    }
+    if(refrescarZona(zona)) {
+        return 0; // refrescarZona() ya avisó que se descartó el cambio
+    }
     
-    // Mostrar zonas disponibles
-    printf("ZONAS DISPONIBLES:\n");
+    // La sincronización con el disco se agrupa cada LOTE_SINCRONIZACION guardados;
+    // los registros de un archivo sin sincronizar se validan con su CRC al cargar
+    if(!guardarZonaEnArchivo(zona, 0)) {
+        printf("Error al guardar datos de la zona %s\n", zona->nombre);
+        return 0;
+    }
+    // Guardado silencioso para no interrumpir la experiencia del usuario
+    if(zona->id_zona >= 1 && zona->id_zona <= MAX_ZONAS) {
+        zonas_sin_sincronizar[zona->id_zona - 1] = 1;
+    }
+    guardados_sin_sincronizar++;
+    if(guardados_sin_sincronizar >= LOTE_SINCRONIZACION) {
+        sincronizarZonasPendientes();
+    }
+    return 1;
+}
+
+int guardarZona(ZonaUrbana *zona) {
+    if(!bloquearZona(zona->id_zona)) {
+        printf("Error: la zona %s esta bloqueada por otra instancia; no se guardo.\n", zona->nombre);
+        return 0;
+    }
+    int guardada = guardarZonaBloqueada(zona);
+    desbloquearZona(zona->id_zona);
+    return guardada;
+}
+
+// Escribe solo las zonas con cambios pendientes; las demás ya coinciden con su archivo
+void guardarTodasLasZonas(ZonaUrbana zonas[]) {
+    int guardadas = 0;
     for(int i = 0; i < MAX_ZONAS; i++) {
-        printf("%d. %s", zonas[i].id_zona, zonas[i].nombre);
-        if(zonas[i].dias_registrados > 0) {
-            printf(" (%d dias de datos)\n", zonas[i].dias_registrados);
-        } else {
-            printf(" (Sin datos)\n");
+        if(zonas[i].id_zona >= 1 && zonas[i].modificada) {
+            guardarZona(&zonas[i]);
+            guardadas++;
         }
     }
+    printf("Zonas con cambios guardadas: %d\n", guardadas);
+    sincronizarZonasPendientes();
+}
+
+// Reloj de pared en milisegundos (el tiempo de E/S no cuenta en clock())
+double milisegundosActuales(void) {
+#ifdef TIME_UTC
+    struct timespec ahora;
+    timespec_get(&ahora, TIME_UTC);
+    return ahora.tv_sec * 1000.0 + ahora.tv_nsec / 1e6;
+#else
+    return (double)clock() * 1000.0 / CLOCKS_PER_SEC;
+#endif
+}
+
+// Decodifica un archivo con el formato anterior (estructura ZonaUrbana completa, sin
+// cabecera). Los archivos más antiguos terminan antes de los campos nuevos; lo que no
+// esté en el archivo queda en cero (modelos estadísticos pendientes de ajuste)
+int decodificarZonaFormatoAnterior(ZonaUrbana *zona, unsigned char *contenido, long tamano) {
+    if(tamano < (long)offsetof(ZonaUrbana, ubicacion)) {
+        return 0;
+    }
+    // Los campos desde 'modificada' son solo de ejecución y nunca se toman del archivo
+    size_t copiar = offsetof(ZonaUrbana, modificada);
+    memset(zona, 0, sizeof(ZonaUrbana));
+    memcpy(zona, contenido, tamano < (long)copiar ? (size_t)tamano : copiar);
+    if(tamano < (long)(offsetof(ZonaUrbana, ubicacion) + sizeof(CoordenadasZona))) {
+        zona->ubicacion = coordenadasPorDefecto(zona->id_zona);
+    }
+    // Estado en tiempo de ejecución: el archivo se convierte al formato actual al salir
+    zona->modificada = 1;
+    zona->generacion = 0;
+    return 1;
+}
+
+// Valida la cabecera al inicio de contenido (versión 2 o actual) y la devuelve en el
+// formato actual junto con su tamaño en el archivo. Los archivos de versión 2 no
+// tienen generación y se leen como generación 0.
+int leerCabeceraZona(unsigned char *contenido, long tamano, CabeceraArchivoZona *cabecera, long *tamano_cabecera) {
+    int version;
+    
+    if(tamano < (long)sizeof(CabeceraArchivoZonaV2)) {
+        return 0;
+    }
+    memcpy(&version, contenido + offsetof(CabeceraArchivoZona, version), sizeof(version));
     
-    // Seleccionar zona
-    do {
-        printf("\nSeleccione la zona para analizar tendencias (1-%d): ", MAX_ZONAS);
-        val = scanf("%d", &zona_seleccionada);
-        fflush(stdin);
-        
-        if(val != 1 || zona_seleccionada < 1 || zona_seleccionada > MAX_ZONAS) {
-            printf("Opcion invalida. Por favor, intente de nuevo.\n");
+    if(version == 2) {
+        CabeceraArchivoZonaV2 anterior;
+        memcpy(&anterior, contenido, sizeof(anterior));
+        if(anterior.crc != calcularCRC32(&anterior, offsetof(CabeceraArchivoZonaV2, crc))) {
+            return 0;
         }
-    } while(val != 1 || zona_seleccionada < 1 || zona_seleccionada > MAX_ZONAS);
-    
-    zona_seleccionada--;
-    
-    if(zonas[zona_seleccionada].dias_registrados == 0) {
-        printf("\nERROR: La zona '%s' no tiene datos registrados.\n", 
-               zonas[zona_seleccionada].nombre);
-        return;
-    }
-    
-    printf("\n=== ANALISIS DE TENDENCIAS: %s ===\n", zonas[zona_seleccionada].nombre);
-    printf("========================================================\n");
-    
-    // 1. HISTORIAL DETALLADO DE DATOS
-    printf("\n1. HISTORIAL DETALLADO DE CONTAMINANTES:\n");
-    printf("------------------------------------------------------\n");
-    
-    printf("Fecha      | CO2    | SO2    | NO2    | PM2.5  | Estado General\n");
-    printf("-----------|--------|--------|--------|--------|---------------\n");
-    
-    int dias_mostrar;
-    if(zonas[zona_seleccionada].dias_registrados > 10) {
-        dias_mostrar = 10;
+        memset(cabecera, 0, sizeof(CabeceraArchivoZona));
+        cabecera->version = anterior.version;
+        cabecera->num_registros = anterior.num_registros;
+        cabecera->tamano_registro = anterior.tamano_registro;
+        *tamano_cabecera = sizeof(anterior);
     } else {
-        dias_mostrar = zonas[zona_seleccionada].dias_registrados;
-    }
-    
-    for(int i = 0; i < dias_mostrar; i++) {
-        // Contar excesos para determinar estado
-        int excesos = 0;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.co2 > LIMITE_CO2_OMS) excesos++;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.so2 > LIMITE_SO2_OMS) excesos++;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.no2 > LIMITE_NO2_OMS) excesos++;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.pm25 > LIMITE_PM25_OMS) excesos++;
-        
-        char estado[16];
-        if(excesos == 0) {
-            strcpy(estado, "Bueno");
-        } else if(excesos <= 1) {
-            strcpy(estado, "Moderado");
-        } else if(excesos <= 2) {
-            strcpy(estado, "Danino");
-        } else {
-            strcpy(estado, "Peligroso");
+        if(tamano < (long)sizeof(CabeceraArchivoZona)) {
+            return 0;
         }
-        
-        printf("%02d/%02d/%04d | %-6.1f | %-6.1f | %-6.1f | %-6.1f | %s",
-               zonas[zona_seleccionada].historico_fechas[i].fecha.dia,
-               zonas[zona_seleccionada].historico_fechas[i].fecha.mes,
-               zonas[zona_seleccionada].historico_fechas[i].fecha.año,
-               zonas[zona_seleccionada].historico_fechas[i].niveles.co2,
-               zonas[zona_seleccionada].historico_fechas[i].niveles.so2,
-               zonas[zona_seleccionada].historico_fechas[i].niveles.no2,
-               zonas[zona_seleccionada].historico_fechas[i].niveles.pm25,
-               estado);
-        
-        // Marcar si excede límites OMS
-        if(excesos > 0) {
-            printf(" (");
-            if(zonas[zona_seleccionada].historico_fechas[i].niveles.co2 > LIMITE_CO2_OMS) printf("CO2 ");
-            if(zonas[zona_seleccionada].historico_fechas[i].niveles.so2 > LIMITE_SO2_OMS) printf("SO2 ");
-            if(zonas[zona_seleccionada].historico_fechas[i].niveles.no2 > LIMITE_NO2_OMS) printf("NO2 ");
-            if(zonas[zona_seleccionada].historico_fechas[i].niveles.pm25 > LIMITE_PM25_OMS) printf("PM2.5 ");
-            printf("exceden)");
+        memcpy(cabecera, contenido, sizeof(CabeceraArchivoZona));
+        if(cabecera->version != VERSION_ARCHIVO_ZONA ||
+           cabecera->crc != calcularCRC32(cabecera, offsetof(CabeceraArchivoZona, crc))) {
+            return 0;
         }
-        printf("\n");
+        *tamano_cabecera = sizeof(CabeceraArchivoZona);
     }
-    
-    // 2. ANÁLISIS ESTADÍSTICO
-    printf("\n2. ANALISIS ESTADISTICO:\n");
-    printf("------------------------------------------------------\n");
-    
-    // Calcular estadísticas
-    float suma_co2 = 0, suma_so2 = 0, suma_no2 = 0, suma_pm25 = 0;
-    float max_co2 = 0, max_so2 = 0, max_no2 = 0, max_pm25 = 0;
-    float min_co2 = 999999, min_so2 = 999999, min_no2 = 999999, min_pm25 = 999999;
-    
-    for(int i = 0; i < zonas[zona_seleccionada].dias_registrados; i++) {
-        // Sumas para promedio
-        suma_co2 += zonas[zona_seleccionada].historico_fechas[i].niveles.co2;
-        suma_so2 += zonas[zona_seleccionada].historico_fechas[i].niveles.so2;
-        suma_no2 += zonas[zona_seleccionada].historico_fechas[i].niveles.no2;
-        suma_pm25 += zonas[zona_seleccionada].historico_fechas[i].niveles.pm25;
-        
-        // Máximos
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.co2 > max_co2) 
-            max_co2 = zonas[zona_seleccionada].historico_fechas[i].niveles.co2;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.so2 > max_so2) 
-            max_so2 = zonas[zona_seleccionada].historico_fechas[i].niveles.so2;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.no2 > max_no2) 
-            max_no2 = zonas[zona_seleccionada].historico_fechas[i].niveles.no2;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.pm25 > max_pm25) 
-            max_pm25 = zonas[zona_seleccionada].historico_fechas[i].niveles.pm25;
-        
-        // Mínimos
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.co2 < min_co2) 
-            min_co2 = zonas[zona_seleccionada].historico_fechas[i].niveles.co2;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.so2 < min_so2) 
-            min_so2 = zonas[zona_seleccionada].historico_fechas[i].niveles.so2;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.no2 < min_no2) 
-            min_no2 = zonas[zona_seleccionada].historico_fechas[i].niveles.no2;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.pm25 < min_pm25) 
-            min_pm25 = zonas[zona_seleccionada].historico_fechas[i].niveles.pm25;
-    }
-    
-    // Calcular promedios
-    float promedio_co2 = suma_co2 / zonas[zona_seleccionada].dias_registrados;
-    float promedio_so2 = suma_so2 / zonas[zona_seleccionada].dias_registrados;
-    float promedio_no2 = suma_no2 / zonas[zona_seleccionada].dias_registrados;
-    float promedio_pm25 = suma_pm25 / zonas[zona_seleccionada].dias_registrados;
-    
-    printf("ESTADISTICAS GENERALES (%d dias):\n", zonas[zona_seleccionada].dias_registrados);
-    printf("                 | Promedio | Maximo  | Minimo  | Limite OMS | Estado\n");
-    printf("-----------------|----------|---------|---------|------------|--------\n");
-    printf("CO2 (ppm)\t| %.1f\t| %.1f\t| %.1f\t| %.1f\t| ", 
-           promedio_co2, max_co2, min_co2, LIMITE_CO2_OMS);
-    if(promedio_co2 > LIMITE_CO2_OMS) {
-        printf("EXCEDE\n");
-    } else {
-        printf("OK\n");
+    return cabecera->tamano_registro == sizeof(RegistroHistorico);
+}
+
+// Valida y decodifica el contenido completo de un archivo de zona ya leído en memoria.
+// Los registros diarios cuyo CRC no coincide (escritura interrumpida) se omiten y se
+// cuentan en *danados.
+int decodificarArchivoZona(ZonaUrbana *zona, unsigned char *contenido, long tamano, int *danados) {
+    CabeceraArchivoZona cabecera;
+    DatosZonaArchivo datos;
+    unsigned int crc_datos;
+    long tamano_cabecera;
+    
+    *danados = 0;
+    if(tamano < 4 || memcmp(contenido, MAGIA_ARCHIVO_ZONA, 4) != 0) {
+        return decodificarZonaFormatoAnterior(zona, contenido, tamano);
     }
     
-    printf("SO2 (ug/m3)\t| %.1f\t| %.1f\t| %.1f\t| %.1f\t| ", 
-           promedio_so2, max_so2, min_so2, LIMITE_SO2_OMS);
-    if(promedio_so2 > LIMITE_SO2_OMS) {
-        printf("EXCEDE\n");
-    } else {
-        printf("OK\n");
+    if(!leerCabeceraZona(contenido, tamano, &cabecera, &tamano_cabecera)) {
+        return 0;
     }
-    
-    printf("NO2 (ug/m3)\t| %.1f\t| %.1f\t| %.1f\t| %.1f\t| ", 
-           promedio_no2, max_no2, min_no2, LIMITE_NO2_OMS);
-    if(promedio_no2 > LIMITE_NO2_OMS) {
-        printf("EXCEDE\n");
-    } else {
-        printf("OK\n");
+    long posicion = tamano_cabecera + sizeof(datos) + sizeof(crc_datos);
+    if(tamano < posicion) {
+        return 0;
     }
-    
-    printf("PM2.5 (ug/m3)\t| %.1f\t| %.1f\t| %.1f\t| %.1f\t| ", 
-           promedio_pm25, max_pm25, min_pm25, LIMITE_PM25_OMS);
-    if(promedio_pm25 > LIMITE_PM25_OMS) {
-        printf("EXCEDE\n");
-    } else {
-        printf("OK\n");
+    memcpy(&datos, contenido + tamano_cabecera, sizeof(datos));
+    memcpy(&crc_datos, contenido + tamano_cabecera + sizeof(datos), sizeof(crc_datos));
+    if(crc_datos != calcularCRC32(&datos, sizeof(datos))) {
+        return 0;
     }
     
-    // 3. ANÁLISIS DE TENDENCIAS DETALLADO
-    printf("\n3. ANALISIS DE TENDENCIAS DETALLADO:\n");
-    printf("-------------------------------------------------------------\n");
-    
-    if(zonas[zona_seleccionada].dias_registrados > 1) {
-        // Calcular promedios históricos ponderados
-        int dias_para_promedio;
-        if(zonas[zona_seleccionada].dias_registrados > 7) {
-            dias_para_promedio = 7;
-        } else {
-            dias_para_promedio = zonas[zona_seleccionada].dias_registrados;
-        }
-        
-        float promedio_pond_co2 = 0, promedio_pond_so2 = 0, promedio_pond_no2 = 0, promedio_pond_pm25 = 0;
-        
-        for(int i = 0; i < dias_para_promedio; i++) {
-            promedio_pond_co2 += zonas[zona_seleccionada].historico[i].co2;
-            promedio_pond_so2 += zonas[zona_seleccionada].historico[i].so2;
-            promedio_pond_no2 += zonas[zona_seleccionada].historico[i].no2;
-            promedio_pond_pm25 += zonas[zona_seleccionada].historico[i].pm25;
-        }
-        
-        promedio_pond_co2 /= dias_para_promedio;
-        promedio_pond_so2 /= dias_para_promedio;
-        promedio_pond_no2 /= dias_para_promedio;
-        promedio_pond_pm25 /= dias_para_promedio;
-        
-        printf("PROMEDIO ULTIMOS %d DIAS vs NIVEL ACTUAL:\n", dias_para_promedio);
-        printf("Contaminante\t| Promedio\t| Actual\t| Diferencia\t| Tendencia\n");
-        printf("----------------|---------------|---------------|---------------|----------\n");
-        
-        // Análisis CO2
-        float dif_co2 = zonas[zona_seleccionada].niveles_actuales.co2 - promedio_pond_co2;
-        float porc_co2 = 0;
-        if(promedio_pond_co2 != 0) {
-            porc_co2 = absoluto(dif_co2 / promedio_pond_co2 * 100);
-        }
-        
-        printf("CO2 (ppm)\t| %.1f\t\t| %.1f\t\t| %.1f\t\t| ", 
-               promedio_pond_co2, zonas[zona_seleccionada].niveles_actuales.co2, dif_co2);
-        
-        if(zonas[zona_seleccionada].niveles_actuales.co2 > promedio_pond_co2) {
-            printf("SUBIENDO ");
-        } else {
-            printf("BAJANDO  ");
-        }
-        printf("(%.1f%%)\n", porc_co2);
-        
-        // Análisis SO2
-        float dif_so2 = zonas[zona_seleccionada].niveles_actuales.so2 - promedio_pond_so2;
-        float porc_so2 = 0;
-        if(promedio_pond_so2 != 0) {
-            porc_so2 = absoluto(dif_so2 / promedio_pond_so2 * 100);
-        }
-        
-        printf("SO2 (ug/m3)\t| %.1f\t\t| %.1f\t\t| %.1f\t\t| ", 
-               promedio_pond_so2, zonas[zona_seleccionada].niveles_actuales.so2, dif_so2);
-        
-        if(zonas[zona_seleccionada].niveles_actuales.so2 > promedio_pond_so2) {
-            printf("SUBIENDO ");
-        } else {
-            printf("BAJANDO  ");
-        }
-        printf("(%.1f%%)\n", porc_so2);
-        
-        // Análisis NO2
-        float dif_no2 = zonas[zona_seleccionada].niveles_actuales.no2 - promedio_pond_no2;
-        float porc_no2 = 0;
-        if(promedio_pond_no2 != 0) {
-            porc_no2 = absoluto(dif_no2 / promedio_pond_no2 * 100);
-        }
-        
-        printf("NO2 (ug/m3)\t| %.1f\t\t| %.1f\t\t| %.1f\t\t| ", 
-               promedio_pond_no2, zonas[zona_seleccionada].niveles_actuales.no2, dif_no2);
-        
-        if(zonas[zona_seleccionada].niveles_actuales.no2 > promedio_pond_no2) {
-            printf("SUBIENDO ");
-        } else {
-            printf("BAJANDO  ");
+    memset(zona, 0, sizeof(ZonaUrbana));
+    memcpy(zona->nombre, datos.nombre, MAX_NOMBRE);
+    zona->id_zona = datos.id_zona;
+    zona->niveles_actuales = datos.niveles_actuales;
+    zona->clima_actual = datos.clima_actual;
+    memcpy(zona->promedio_30_dias, datos.promedio_30_dias, sizeof(zona->promedio_30_dias));
+    zona->ubicacion = datos.ubicacion;
+    memcpy(zona->modelos, datos.modelos, sizeof(zona->modelos));
+    zona->modelos_ajustados = datos.modelos_ajustados;
+    zona->generacion = cabecera.generacion;
+    
+    int validos = 0;
+    for(int i = 0; i < cabecera.num_registros; i++) {
+        RegistroArchivoZona registro;
+        if(posicion + (long)sizeof(registro) > tamano) {
+            *danados += cabecera.num_registros - i; // Archivo truncado
+            break;
         }
-        printf("(%.1f%%)\n", porc_no2);
+        memcpy(&registro, contenido + posicion, sizeof(registro));
+        posicion += sizeof(registro);
         
-        // Análisis PM2.5
-        float dif_pm25 = zonas[zona_seleccionada].niveles_actuales.pm25 - promedio_pond_pm25;
-        float porc_pm25 = 0;
-        if(promedio_pond_pm25 != 0) {
-            porc_pm25 = absoluto(dif_pm25 / promedio_pond_pm25 * 100);
+        if(registro.crc != calcularCRC32(&registro.registro, sizeof(RegistroHistorico))) {
+            (*danados)++;
+            continue;
         }
-        
-        printf("PM2.5 (ug/m3)\t| %.1f\t\t| %.1f\t\t| %.1f\t\t| ", 
-               promedio_pond_pm25, zonas[zona_seleccionada].niveles_actuales.pm25, dif_pm25);
-        
-        if(zonas[zona_seleccionada].niveles_actuales.pm25 > promedio_pond_pm25) {
-            printf("SUBIENDO ");
-        } else {
-            printf("BAJANDO  ");
+        if(validos < MAX_DIAS_HISTORICOS) {
+            zona->historico_fechas[validos] = registro.registro;
+            zona->historico[validos] = registro.registro.niveles;
+            validos++;
+        } else if(!archivarRegistro(&zona->archivado, registro.registro)) {
+            liberarHistoricoArchivado(&zona->archivado);
+            return 0;
         }
-        printf(" (%.1f%%)\n", porc_pm25);
     }
+    invertirHistoricoArchivado(&zona->archivado);
     
-    if(zonas[zona_seleccionada].dias_registrados >= 3) {
-        printf("\nCOMPARACION TEMPORAL (Primeros vs Ultimos dias):\n");
-        
-        // Comparar primeros 3 días vs últimos 3 días
-        float promedio_reciente = (zonas[zona_seleccionada].historico[0].co2 + 
-                                  zonas[zona_seleccionada].historico[1].co2 + 
-                                  zonas[zona_seleccionada].historico[2].co2) / 3;
-        
-        int dias_antiguos = zonas[zona_seleccionada].dias_registrados - 1;
-        float promedio_antiguo = (zonas[zona_seleccionada].historico[dias_antiguos].co2 + 
-                                 zonas[zona_seleccionada].historico[dias_antiguos-1].co2 + 
-                                 zonas[zona_seleccionada].historico[dias_antiguos-2].co2) / 3;
-        
-        printf("CO2 - Tendencia:\n");
-        printf("  Promedio reciente (3 dias): %.1f ppm\n", promedio_reciente);
-        printf("  Promedio anterior (3 dias): %.1f ppm\n", promedio_antiguo);
-        
-        if(promedio_reciente > promedio_antiguo) {
-            float incremento = ((promedio_reciente - promedio_antiguo) / promedio_antiguo) * 100;
-            printf("  Tendencia: EMPEORANDO (%.1f%% mas alto)\n", incremento);
-        } else {
-            float mejora = ((promedio_antiguo - promedio_reciente) / promedio_antiguo) * 100;
-            printf("  Tendencia: MEJORANDO (%.1f%% mas bajo)\n", mejora);
-        }
+    zona->dias_registrados = validos;
+    if(*danados > 0) {
+        zona->modelos_ajustados = 0; // El histórico cambió: reajustar
+    }
+    return 1;
+}
+
+// Carga un archivo de zona con una sola lectura de todo su contenido (en almacenamiento
+// de red cada lectura es un viaje de ida y vuelta) y registra el tiempo de cada fase
+int cargarArchivoZona(ZonaUrbana *zona, char *nombre_archivo, EstadisticasCarga *estadisticas) {
+    double inicio = milisegundosActuales();
+    FILE *f = fopen(nombre_archivo, "rb");
+    estadisticas->ms_apertura += milisegundosActuales() - inicio;
+    if(f == NULL) {
+        return 0;
     }
     
-    // 4. DÍAS PROBLEMÁTICOS
-    printf("\n4. DIAS PROBLEMATICOS:\n");
-    printf("-----------------------------------------------------------\n");
+    inicio = milisegundosActuales();
+    long tamano = 0;
+    unsigned char *contenido = NULL;
+    if(fseek(f, 0, SEEK_END) == 0) {
+        tamano = ftell(f);
+        rewind(f);
+    }
+    if(tamano > 0) {
+        contenido = malloc(tamano);
+    }
+    if(contenido != NULL && fread(contenido, 1, tamano, f) != (size_t)tamano) {
+        free(contenido);
+        contenido = NULL;
+    }
+    fclose(f);
+    estadisticas->ms_lectura += milisegundosActuales() - inicio;
+    if(contenido == NULL) {
+        return 0;
+    }
     
-    int dias_exceso = 0;
-    printf("Dias con excesos de limites OMS:\n");
+    inicio = milisegundosActuales();
+    int danados = 0;
+    int cargada = decodificarArchivoZona(zona, contenido, tamano, &danados);
+    free(contenido);
+    estadisticas->ms_validacion += milisegundosActuales() - inicio;
     
-    for(int i = 0; i < zonas[zona_seleccionada].dias_registrados; i++) {
-        int excesos_dia = 0;
-        char problemas[200] = "";
-        
-        if(zonas[zona_seleccionada].historico[i].co2 > LIMITE_CO2_OMS) {
-            excesos_dia++;
-            strcat(problemas, "CO2 ");
-        }
-        if(zonas[zona_seleccionada].historico[i].so2 > LIMITE_SO2_OMS) {
-            excesos_dia++;
-            strcat(problemas, "SO2 ");
-        }
-        if(zonas[zona_seleccionada].historico[i].no2 > LIMITE_NO2_OMS) {
-            excesos_dia++;
-            strcat(problemas, "NO2 ");
-        }
-        if(zonas[zona_seleccionada].historico[i].pm25 > LIMITE_PM25_OMS) {
-            excesos_dia++;
-            strcat(problemas, "PM2.5 ");
-        }
-        
-        if(excesos_dia > 0) {
-            dias_exceso++;
-            printf("  Dia %d: %d exceso(s) - %s\n", i+1, excesos_dia, problemas);
-        }
+    if(!cargada) {
+        printf("ERROR: Cabecera o datos de zona danados en %s\n", nombre_archivo);
+        return 0;
+    }
+    if(danados > 0) {
+        printf("ADVERTENCIA: %d registro(s) danado(s) omitido(s) en %s\n", danados, nombre_archivo);
     }
     
-    printf("\nRESUMEN: %d de %d dias con excesos (%.1f%%)\n", 
-           dias_exceso, zonas[zona_seleccionada].dias_registrados,
-           (float)dias_exceso / zonas[zona_seleccionada].dias_registrados * 100);
-    
-    // 5. RECOMENDACIONES BASADAS EN TENDENCIAS
-    printf("\n5. RECOMENDACIONES BASADAS EN TENDENCIAS:\n");
-    printf("----------------------------------------------------------\n");
+    // Días faltantes y fechas repetidas de la ventana
+    int huecos_completados;
+    if(!completarHuecosZona(zona, &huecos_completados)) {
+        printf("ERROR: Memoria insuficiente para archivar el historico de %s\n", nombre_archivo);
+        liberarHistoricoArchivado(&zona->archivado);
+        return 0;
+    }
+    resolverLimitesZona(zona);
+    recalcularMapaExcesos(zona);
+    zona->derivados_pendientes = TODOS_LOS_DERIVADOS;
+    if(huecos_completados > 0) {
+        printf("INFO: %d dia(s) faltante(s) en %d hueco(s) completado(s) por interpolacion en %s\n",
+               contarBitsMapa(zona->dias_imputados), huecos_completados, nombre_archivo);
+    }
+    if(zona->huecos_sin_completar > 0) {
+        printf("ADVERTENCIA: %d hueco(s) de mas de %d dias sin completar en %s\n",
+               zona->huecos_sin_completar, MAX_DIAS_IMPUTABLES, nombre_archivo);
+    }
+    int duplicados = contarBitsMapa(zona->dias_duplicados);
+    if(duplicados > 0) {
+        printf("ADVERTENCIA: %d registro(s) con fecha repetida en %s (se usa el mas reciente)\n",
+               duplicados, nombre_archivo);
+    }
+    estadisticas->bytes = tamano;
+    estadisticas->registros_danados = danados;
+    return 1;
+}
+
+int cargarZonaConEstadisticas(ZonaUrbana *zona, int id_zona, EstadisticasCarga *estadisticas) {
+    char nombre_archivo[100];
     
-    float porcentaje_exceso = (float)dias_exceso / zonas[zona_seleccionada].dias_registrados * 100;
+    memset(estadisticas, 0, sizeof(EstadisticasCarga));
+    estadisticas->id_zona = id_zona;
     
-    if(porcentaje_exceso > 50) {
-        printf("CRITICO: Mas del 50%% de dias con excesos\n");
-        printf("- Implementar medidas de emergencia\n");
-        printf("- Restricciones de trafico permanentes\n");
-        printf("- Monitoreo continuo\n");
-    } else if(porcentaje_exceso > 25) {
-        printf("PREOCUPANTE: Mas del 25%% de dias con excesos\n");
-        printf("- Reforzar medidas preventivas\n");
-        printf("- Alertas tempranas\n");
-        printf("- Revision de politicas ambientales\n");
-    } else if(porcentaje_exceso > 0) {
-        printf("MODERADO: Algunos dias con excesos\n");
-        printf("- Mantener monitoreo regular\n");
-        printf("- Medidas preventivas ocasionales\n");
-    } else {
-        printf("BUENO: Sin excesos registrados\n");
-        printf("- Mantener politicas actuales\n");
-        printf("- Continuar monitoreo preventivo\n");
+    sprintf(nombre_archivo, "zona_%d.dat", id_zona);
+    int cargada = cargarArchivoZona(zona, nombre_archivo, estadisticas);
+    if(!cargada) {
+        // Un guardado interrumpido antes del renombrado deja el temporal completo
+        sprintf(nombre_archivo, "zona_%d.tmp", id_zona);
+        cargada = cargarArchivoZona(zona, nombre_archivo, estadisticas);
     }
     
-    printf("\n=======================================================\n");
+    if(!cargada) {
+        // Zona vacía sin ID: guardarZonaBloqueada() la rechaza, así no se escribe encima de
+        // un archivo dañado que aún puede recuperarse
+        memset(zona, 0, sizeof(ZonaUrbana));
+    } else if(!cargarCuantilesZona(zona)) {
+        // Sin archivo de percentiles válido: se recalculan con los días en memoria
+        if(reconstruirCuantilesZona(zona, 0)) {
+            printf("INFO: Percentiles de %s recalculados con %d dia(s) en memoria\n",
+                   zona->nombre, diasTotalesZona(zona));
+        }
+        zona->modificada = 1;
+    }
+    estadisticas->cargada = cargada;
+    return cargada;
 }
 
-// ============= FUNCIONES DE PREDICCION 24H =============
+int cargarZona(ZonaUrbana *zona, int id_zona) {
+    EstadisticasCarga estadisticas;
+    return cargarZonaConEstadisticas(zona, id_zona, &estadisticas);
+}
 
-// Función principal para predicción de contaminación 24h
-void prediccionContaminacion24h(ZonaUrbana zonas[]) {
-    int zona_seleccionada, i;
-    
-    printf("\n=======================================================\n");
-    printf("           PREDICCION DE CONTAMINACION 24H            \n");
-    printf("=======================================================\n");
+// Carga todas las zonas; cada zona queda disponible en cuanto termina su carga y su
+// fila se muestra en ese momento con el desglose de tiempos
+int cargarTodasLasZonas(ZonaUrbana zonas[]) {
+    int zonas_cargadas = 0;
+    EstadisticasCarga estadisticas;
+    double inicio = milisegundosActuales();
     
-    // Mostrar zonas disponibles
-    printf("\nZonas disponibles para prediccion:\n");
-    for(i = 0; i < MAX_ZONAS; i++) {
-        if(zonas[i].dias_registrados > 0) {
-            printf("%d. %s (ID: %d) - %d dias de datos\n", 
-                   i+1, zonas[i].nombre, zonas[i].id_zona, zonas[i].dias_registrados);
+    printf("Cargando zonas desde archivos separados...\n");
+    printf("Zona                 | Apertura | Lectura  | Validac. | Bytes  | Estado\n");
+    printf("---------------------|----------|----------|----------|--------|-------\n");
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        if(cargarZonaConEstadisticas(&zonas[i], i + 1, &estadisticas)) {
+            zonas_cargadas++;
+            // Un histórico importado o de otra instalación puede superar la retención
+            if(zonas[i].archivado.num_registros > MAX_DIAS_ARCHIVADOS && bloquearZona(i + 1)) {
+                aplicarRetencionZona(&zonas[i]);
+                desbloquearZona(i + 1);
+            }
         }
+        publicarInstantaneaZona(&zonas[i]);
+        printf("%-20.20s | %6.2fms | %6.2fms | %6.2fms | %6ld | %s\n",
+               estadisticas.cargada ? zonas[i].nombre : "(no disponible)",
+               estadisticas.ms_apertura, estadisticas.ms_lectura, estadisticas.ms_validacion,
+               estadisticas.bytes, estadisticas.cargada ? "OK" : "ERROR");
     }
     
-    int val;
-    do {
-        printf("\nSeleccione una zona (1-5): ");
-        val = scanf("%d", &zona_seleccionada);
-        fflush(stdin);
-        
-        if(val != 1) {
-            printf("ERROR: Ingrese un numero valido.\n");
+    printf("Total de zonas cargadas: %d/%d en %.2f ms\n", zonas_cargadas, MAX_ZONAS,
+           milisegundosActuales() - inicio);
+    return zonas_cargadas;
+}
+
+// Generación del archivo de la zona leyendo solo su cabecera. Como cargarZona(), si
+// zona_N.dat no tiene cabecera válida se usa zona_N.tmp; 0 si ninguno la tiene o no
+// tiene generación (formatos anteriores)
+unsigned int leerGeneracionArchivo(int id_zona) {
+    char nombre_archivo[100];
+    unsigned char contenido[sizeof(CabeceraArchivoZona)];
+    CabeceraArchivoZona cabecera;
+    long tamano_cabecera;
+    const char *extensiones[] = {"dat", "tmp"};
+    
+    for(int e = 0; e < 2; e++) {
+        sprintf(nombre_archivo, "zona_%d.%s", id_zona, extensiones[e]);
+        FILE *f = fopen(nombre_archivo, "rb");
+        if(f == NULL) {
             continue;
         }
+        long leidos = fread(contenido, 1, sizeof(contenido), f);
+        fclose(f);
         
-        zona_seleccionada--; // Ajustar a índice del array
-        
-        if(zona_seleccionada < 0 || zona_seleccionada >= MAX_ZONAS) {
-            printf("ERROR: Zona invalida. Ingrese un numero entre 1 y 5.\n");
-            continue;
+        if(leidos >= 4 && memcmp(contenido, MAGIA_ARCHIVO_ZONA, 4) == 0 &&
+           leerCabeceraZona(contenido, leidos, &cabecera, &tamano_cabecera)) {
+            return cabecera.generacion;
         }
-        
-        if(zonas[zona_seleccionada].dias_registrados < 3) {
-            printf("ERROR: Se necesitan al menos 3 dias de datos para hacer predicciones.\n");
-            printf("Esta zona tiene solo %d dias registrados.\n", 
-                   zonas[zona_seleccionada].dias_registrados);
-            continue;
-        }
-        
-        break;
-    } while(1);
-    
-    ZonaUrbana *zona = &zonas[zona_seleccionada];
-    
-    printf("\n=======================================================\n");
-    printf("PREDICCION PARA: %s (ID: %d)\n", zona->nombre, zona->id_zona);
-    printf("=======================================================\n");
-    
-    // Calcular predicciones para cada contaminante
-    float pred_co2, pred_so2, pred_no2, pred_pm25;
-    
-    // Extraer datos históricos por contaminante
-    float hist_co2[MAX_DIAS_HISTORICOS], hist_so2[MAX_DIAS_HISTORICOS];
-    float hist_no2[MAX_DIAS_HISTORICOS], hist_pm25[MAX_DIAS_HISTORICOS];
-    
-    for(i = 0; i < zona->dias_registrados; i++) {
-        hist_co2[i] = zona->historico[i].co2;
-        hist_so2[i] = zona->historico[i].so2;
-        hist_no2[i] = zona->historico[i].no2;
-        hist_pm25[i] = zona->historico[i].pm25;
     }
+    return 0;
+}
+
+// Las zonas en memoria son la copia de trabajo; solo se vuelve a leer una zona cuando
+// otro proceso publicó una generación distinta de su archivo. Una zona con cambios
+// propios sin guardar se conserva aquí; si al guardarla el archivo cambió,
+// refrescarZona() la recarga y avisa que esos cambios se descartan.
+int recargarZonasModificadasExternamente(ZonaUrbana zonas[]) {
+    int recargadas = 0;
     
-    // Calcular predicciones base
-    pred_co2 = calcularPrediccion(hist_co2, zona->dias_registrados);
-    pred_so2 = calcularPrediccion(hist_so2, zona->dias_registrados);
-    pred_no2 = calcularPrediccion(hist_no2, zona->dias_registrados);
-    pred_pm25 = calcularPrediccion(hist_pm25, zona->dias_registrados);
-    
-    // Predecir condiciones climáticas a 24h
-    DatosClimaticos clima_predicho = predecirClima24h(zona);
-    
-    // Ajustar predicciones por condiciones climáticas predichas
-    pred_co2 = ajustarPorClima(pred_co2, clima_predicho);
-    pred_so2 = ajustarPorClima(pred_so2, clima_predicho);
-    pred_no2 = ajustarPorClima(pred_no2, clima_predicho);
-    pred_pm25 = ajustarPorClima(pred_pm25, clima_predicho);
-    
-    // Mostrar predicciones
-    printf("\nPREDICCIONES PARA LAS PROXIMAS 24 HORAS:\n");
-    printf("-------------------------------------------------------\n");
-    printf("CO2:   %.2f ppm (Limite OMS: %.2f ppm)\n", pred_co2, LIMITE_CO2_OMS);
-    printf("SO2:   %.2f ug/m3 (Limite OMS: %.2f ug/m3)\n", pred_so2, LIMITE_SO2_OMS);
-    printf("NO2:   %.2f ug/m3 (Limite OMS: %.2f ug/m3)\n", pred_no2, LIMITE_NO2_OMS);
-    printf("PM2.5: %.2f ug/m3 (Limite OMS: %.2f ug/m3)\n", pred_pm25, LIMITE_PM25_OMS);
-    
-    // Determinar niveles de alerta
-    int alerta_co2 = determinarNivelAlerta(pred_co2, 0);
-    int alerta_so2 = determinarNivelAlerta(pred_so2, 1);
-    int alerta_no2 = determinarNivelAlerta(pred_no2, 2);
-    int alerta_pm25 = determinarNivelAlerta(pred_pm25, 3);
-    
-    // Mostrar alertas
-    printf("\nNIVELES DE ALERTA PREDICHOS:\n");
-    printf("-------------------------------------------------------\n");
-    
-    char *niveles[] = {"VERDE", "AMARILLO", "NARANJA", "ROJO"};
-    printf("CO2:   %s\n", niveles[alerta_co2]);
-    printf("SO2:   %s\n", niveles[alerta_so2]);
-    printf("NO2:   %s\n", niveles[alerta_no2]);
-    printf("PM2.5: %s\n", niveles[alerta_pm25]);
-    
-    // Determinar nivel de alerta general (el más alto)
-    int alerta_general = alerta_co2;
-    if(alerta_so2 > alerta_general) alerta_general = alerta_so2;
-    if(alerta_no2 > alerta_general) alerta_general = alerta_no2;
-    if(alerta_pm25 > alerta_general) alerta_general = alerta_pm25;
-    
-    printf("\nNIVEL DE ALERTA GENERAL: %s\n", niveles[alerta_general]);
-    
-    // Mostrar condiciones climáticas predichas
-    printf("\nCONDICIONES CLIMATICAS PREDICHAS:\n");
-    printf("-------------------------------------------------------\n");
-    printf("Temperatura:        %.1f°C\n", clima_predicho.temperatura);
-    printf("Viento:             %.1f km/h\n", clima_predicho.velocidad_viento);
-    printf("Humedad:            %.1f%%\n", clima_predicho.humedad);
-    printf("Presion:            %.1f hPa\n", clima_predicho.presion_atmosferica);
-    
-    // Mostrar recomendaciones
-    printf("\nRECOMENDACIONES:\n");
-    printf("-------------------------------------------------------\n");
-    if(alerta_general >= ALERTA_ROJA) {
-        mostrarRecomendaciones(ALERTA_ROJA, "GENERAL");
-    } else if(alerta_general >= ALERTA_NARANJA) {
-        mostrarRecomendaciones(ALERTA_NARANJA, "GENERAL");
-    } else if(alerta_general >= ALERTA_AMARILLA) {
-        mostrarRecomendaciones(ALERTA_AMARILLA, "GENERAL");
-    } else {
-        mostrarRecomendaciones(ALERTA_VERDE, "GENERAL");
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        if(zonas[i].modificada) continue;
+        if(refrescarZona(&zonas[i])) {
+            recargadas++;
+            printf("Zona %s actualizada desde su archivo.\n", zonas[i].nombre);
+        }
     }
-    
-    // Mostrar probabilidad de exceder límites
-    printf("\nPROBABILIDAD DE EXCEDER LIMITES OMS:\n");
-    printf("-------------------------------------------------------\n");
-    if(pred_co2 > LIMITE_CO2_OMS) {
-        printf("CO2:   85.0%%\n");
-    } else {
-        printf("CO2:   15.0%%\n");
+    return recargadas;
+}
+
+// =============== FUNCIONES PARA INSTANTANEAS DEL HISTORICO ===============
+
+// Instantánea vigente de cada zona; la tabla tiene una referencia propia
+static InstantaneaZona *instantaneas_vigentes[MAX_ZONAS];
+
+SegmentoHistorico *crearSegmento(int num_registros) {
+    SegmentoHistorico *segmento = malloc(sizeof(SegmentoHistorico) +
+                                         num_registros * sizeof(RegistroHistorico));
+    if(segmento != NULL) {
+        segmento->referencias = 1;
+        segmento->num_registros = num_registros;
     }
-    
-    if(pred_so2 > LIMITE_SO2_OMS) {
-        printf("SO2:   80.0%%\n");
-    } else {
-        printf("SO2:   20.0%%\n");
+    return segmento;
+}
+
+void liberarSegmento(SegmentoHistorico *segmento) {
+    if(segmento != NULL && --segmento->referencias == 0) {
+        free(segmento);
     }
-    
-    if(pred_no2 > LIMITE_NO2_OMS) {
-        printf("NO2:   75.0%%\n");
-    } else {
-        printf("NO2:   25.0%%\n");
+}
+
+// Registro del día en la forma en que se guarda (niveles de historico[])
+RegistroHistorico registroDeZona(ZonaUrbana *zona, int dia) {
+    RegistroHistorico registro = zona->historico_fechas[dia];
+    registro.niveles = zona->historico[dia];
+    return registro;
+}
+
+// Nueva instantánea con los datos actuales de la zona y sin segmentos
+InstantaneaZona *crearInstantanea(ZonaUrbana *zona) {
+    InstantaneaZona *instantanea = calloc(1, sizeof(InstantaneaZona));
+    if(instantanea == NULL) {
+        return NULL;
     }
-    
-    if(pred_pm25 > LIMITE_PM25_OMS) {
-        printf("PM2.5: 70.0%%\n");
-    } else {
-        printf("PM2.5: 30.0%%\n");
+    instantanea->referencias = 1;
+    memcpy(instantanea->nombre, zona->nombre, MAX_NOMBRE);
+    instantanea->id_zona = zona->id_zona;
+    instantanea->niveles_actuales = zona->niveles_actuales;
+    instantanea->clima_actual = zona->clima_actual;
+    memcpy(instantanea->promedio_30_dias, obtenerPromedio30Dias(zona), sizeof(instantanea->promedio_30_dias));
+    instantanea->estadisticas = *obtenerEstadisticasVentana(zona);
+    memcpy(instantanea->limites, zona->limites, sizeof(instantanea->limites));
+    memcpy(instantanea->perfil, zona->perfil, MAX_NOMBRE_PERFIL);
+    instantanea->dias_registrados = zona->dias_registrados;
+    for(int c = 0; c < 4; c++) {
+        memcpy(instantanea->excesos[c], zona->excesos[c], sizeof(instantanea->excesos[c]));
     }
-    
-    printf("\n=======================================================\n");
+    return instantanea;
 }
 
-// Función auxiliar para calcular predicción usando promedio ponderado
-float calcularPrediccion(float *historico, int dias_disponibles) {
-    if(dias_disponibles < 3) return 0.0;
-    
-    float prediccion = 0.0;
-    
-    // Usar promedio ponderado con más peso a los días recientes
-    if(dias_disponibles >= 3) {
-        // Días más recientes tienen más peso
-        prediccion = historico[dias_disponibles-1] * PESO_DIA_1;  // Día más reciente
-        prediccion += historico[dias_disponibles-2] * PESO_DIA_2; // Segundo día
-        prediccion += historico[dias_disponibles-3] * PESO_DIA_3; // Tercer día
-        
-        // Si hay más días, usar el peso restante distribuido
-        if(dias_disponibles > 3) {
-            float suma_resto = 0.0;
-            for(int i = 0; i < dias_disponibles - 3; i++) {
-                suma_resto += historico[i];
-            }
-            prediccion += (suma_resto / (dias_disponibles - 3)) * PESO_RESTO;
-        }
+// Sustituye la instantánea vigente; las que los lectores tienen fijadas siguen válidas
+void reemplazarInstantaneaVigente(int id_zona, InstantaneaZona *instantanea) {
+    if(id_zona < 1 || id_zona > MAX_ZONAS) {
+        liberarInstantanea(instantanea);
+        return;
     }
-    
-    return prediccion;
+    liberarInstantanea(instantaneas_vigentes[id_zona - 1]);
+    instantaneas_vigentes[id_zona - 1] = instantanea;
 }
 
-// Función auxiliar para ajustar predicción por condiciones climáticas
-float ajustarPorClima(float prediccion_base, DatosClimaticos clima) {
-    float factor_ajuste = 1.0;
-    
-    // Ajuste por temperatura (temperaturas altas aumentan algunos contaminantes)
-    if(clima.temperatura > 30.0) {
-        factor_ajuste *= 1.1; // Incremento del 10%
-    } else if(clima.temperatura < 10.0) {
-        factor_ajuste *= 1.05; // Incremento del 5%
+// Publica todo el histórico de la zona en un único segmento (carga, recarga o corrección)
+void publicarInstantaneaZona(ZonaUrbana *zona) {
+    InstantaneaZona *instantanea = crearInstantanea(zona);
+    if(instantanea == NULL) {
+        return;
     }
     
-    // Ajuste por viento (viento fuerte dispersa contaminantes)
-    if(clima.velocidad_viento > 20.0) {
-        factor_ajuste *= 0.85; // Reducción del 15%
-    } else if(clima.velocidad_viento < 5.0) {
-        factor_ajuste *= 1.15; // Incremento del 15%
+    SegmentoHistorico *segmento = crearSegmento(zona->dias_registrados);
+    if(segmento == NULL) {
+        free(instantanea);
+        return;
     }
-    
-    // Ajuste por humedad (alta humedad puede incrementar ciertos contaminantes)
-    if(clima.humedad > 80.0) {
-        factor_ajuste *= 1.08; // Incremento del 8%
+    for(int i = 0; i < zona->dias_registrados; i++) {
+        segmento->registros[i] = registroDeZona(zona, i);
     }
-    
-    // Ajuste por presión atmosférica (baja presión dificulta dispersión)
-    if(clima.presion_atmosferica < 1000.0) {
-        factor_ajuste *= 1.05; // Incremento del 5%
+    instantanea->segmentos[0] = segmento;
+    instantanea->num_segmentos = 1;
+    instantanea->num_anios_resumen = resumenAnualZona(zona, instantanea->resumen_anual, MAX_ANIOS_RESUMEN);
+    reemplazarInstantaneaVigente(zona->id_zona, instantanea);
+}
+
+// Publica el día recién registrado en historico[0] sin copiar el histórico: la nueva
+// instantánea comparte los segmentos de la anterior y suma el día a su resumen anual.
+// Cuando se alcanzan MAX_SEGMENTOS_INSTANTANEA se compacta todo en un segmento; si el
+// día reemplaza a otro de la misma fecha (o es de un año anterior al último del
+// resumen) el resumen no se puede actualizar en el lugar y se publica todo de nuevo.
+void publicarRegistroNuevo(ZonaUrbana *zona) {
+    InstantaneaZona *anterior = fijarInstantanea(zona->id_zona);
+    int año = zona->historico_fechas[0].fecha.año;
+    if(anterior == NULL || anterior->num_segmentos >= MAX_SEGMENTOS_INSTANTANEA ||
+       (zona->dias_registrados > 1 && diaDuplicado(zona, 1)) ||
+       (anterior->num_anios_resumen > 0 &&
+        año < anterior->resumen_anual[anterior->num_anios_resumen - 1].inicio.año)) {
+        liberarInstantanea(anterior);
+        publicarInstantaneaZona(zona);
+        return;
     }
     
-    return prediccion_base * factor_ajuste;
+    InstantaneaZona *instantanea = crearInstantanea(zona);
+    SegmentoHistorico *segmento = crearSegmento(1);
+    if(instantanea == NULL || segmento == NULL) {
+        free(instantanea);
+        free(segmento);
+        liberarInstantanea(anterior);
+        return;
+    }
+    segmento->registros[0] = registroDeZona(zona, 0);
+    instantanea->segmentos[0] = segmento;
+    for(int i = 0; i < anterior->num_segmentos; i++) {
+        anterior->segmentos[i]->referencias++;
+        instantanea->segmentos[i + 1] = anterior->segmentos[i];
+    }
+    instantanea->num_segmentos = anterior->num_segmentos + 1;
+    
+    RegistroAgregado dia;
+    iniciarAgregado(&dia, segmento->registros[0].fecha);
+    acumularEnAgregado(&dia, segmento->registros[0]);
+    memcpy(instantanea->resumen_anual, anterior->resumen_anual, sizeof(instantanea->resumen_anual));
+    instantanea->num_anios_resumen = anterior->num_anios_resumen;
+    sumarEnResumenAnual(instantanea->resumen_anual, &instantanea->num_anios_resumen, MAX_ANIOS_RESUMEN, &dia);
+    liberarInstantanea(anterior);
+    reemplazarInstantaneaVigente(zona->id_zona, instantanea);
 }
 
-// Función auxiliar para determinar nivel de alerta
-int determinarNivelAlerta(float valor, int tipo_contaminante) {
-    float limite_oms;
-    
-    // Determinar límite OMS según tipo de contaminante
-    switch(tipo_contaminante) {
-        case 0: limite_oms = LIMITE_CO2_OMS; break;  // CO2
-        case 1: limite_oms = LIMITE_SO2_OMS; break;  // SO2
-        case 2: limite_oms = LIMITE_NO2_OMS; break;  // NO2
-        case 3: limite_oms = LIMITE_PM25_OMS; break; // PM2.5
-        default: limite_oms = 100.0; break;
+// Fija la instantánea vigente de la zona (O(1)); se devuelve con liberarInstantanea
+InstantaneaZona *fijarInstantanea(int id_zona) {
+    if(id_zona < 1 || id_zona > MAX_ZONAS || instantaneas_vigentes[id_zona - 1] == NULL) {
+        return NULL;
     }
-    
-    // Determinar nivel de alerta basado en múltiplos del límite OMS
-    if(valor <= limite_oms) {
-        return ALERTA_VERDE;
-    } else if(valor <= limite_oms * 1.5) {
-        return ALERTA_AMARILLA;
-    } else if(valor <= limite_oms * 2.0) {
-        return ALERTA_NARANJA;
-    } else {
-        return ALERTA_ROJA;
+    instantaneas_vigentes[id_zona - 1]->referencias++;
+    return instantaneas_vigentes[id_zona - 1];
+}
+
+void liberarInstantanea(InstantaneaZona *instantanea) {
+    if(instantanea == NULL || --instantanea->referencias > 0) {
+        return;
+    }
+    for(int i = 0; i < instantanea->num_segmentos; i++) {
+        liberarSegmento(instantanea->segmentos[i]);
     }
+    free(instantanea);
 }
 
+// Registro del día 'dia' (0 = más reciente) de la instantánea
+const RegistroHistorico *registroInstantanea(const InstantaneaZona *instantanea, int dia) {
+    for(int i = 0; i < instantanea->num_segmentos; i++) {
+        if(dia < instantanea->segmentos[i]->num_registros) {
+            return &instantanea->segmentos[i]->registros[dia];
+        }
+        dia -= instantanea->segmentos[i]->num_registros;
+    }
+    return NULL;
+}
 
-// Función para calcular predicción climática usando promedio ponderado
-float calcularPrediccionClimatica(float *historico_clima, int dias_disponibles) {
-    if(dias_disponibles < 3) return 0.0;
-    
-    float prediccion = 0.0;
-    
-    // Usar la misma lógica de promedio ponderado que la contaminación
-    if(dias_disponibles >= 3) {
-        // Días más recientes tienen más peso
-        prediccion = historico_clima[dias_disponibles-1] * PESO_DIA_1;  // Día más reciente
-        prediccion += historico_clima[dias_disponibles-2] * PESO_DIA_2; // Segundo día
-        prediccion += historico_clima[dias_disponibles-3] * PESO_DIA_3; // Tercer día
+// ================= FUNCION DE VALIDACION DE DATOS =================
+void funcionValidarDatosdeRegistro(float *valor, char *nombre_dato, float min_val, float max_val) {
+    int val;
+    do {
+        printf("%s: ", nombre_dato);
+        fflush(stdin);
+        val = scanf("%f", valor);
+        fflush(stdin);
         
-        // Si hay más días, usar el peso restante distribuido
-        if(dias_disponibles > 3) {
-            float suma_resto = 0.0;
-            for(int i = 0; i < dias_disponibles - 3; i++) {
-                suma_resto += historico_clima[i];
-            }
-            prediccion += (suma_resto / (dias_disponibles - 3)) * PESO_RESTO;
+        if(val != 1) {
+            printf("ERROR: Ingrese un numero valido.\n");
+        } else if(*valor < min_val || *valor > max_val) {
+            printf("ERROR: El valor debe estar entre %.1f y %.1f\n", min_val, max_val);
+        }
+    } while(val != 1 || *valor < min_val || *valor > max_val);
+}
+
+// ================= FUNCION DE REGISTRO DIARIO =================
+void registroDatosDiario(ZonaUrbana zonas[]) {
+    int id_zona, val;
+    NivelesContaminacion niveles;
+    DatosClimaticos clima;
+    // Mostrar zonas disponibles
+    recargarZonasModificadasExternamente(zonas);
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        printf("%d. %s\n", zonas[i].id_zona, zonas[i].nombre);
+    }
+
+    do
+    {
+        printf("Seleccione la zona para registrar datos (1-%d): ", MAX_ZONAS);
+        val = scanf("%d", &id_zona);
+        fflush(stdin);
+
+        if (val != 1 || id_zona < 1 || id_zona > MAX_ZONAS){
+            printf("Opcion invalida. Por favor, intente de nuevo.\n");
         }
+    } while (val != 1 || id_zona < 1 || id_zona > MAX_ZONAS);
+
+    // Una zona que no se pudo cargar queda vacía: registrar en ella crearía un archivo
+    // nuevo en lugar de recuperar el dañado
+    if(zonas[id_zona - 1].id_zona == 0) {
+        printf("ERROR: La zona %d no se cargo (archivo ausente o danado); no se registran datos.\n", id_zona);
+        printf("\nPresione Enter para continuar...");
+        getchar();
+        return;
     }
+
+    // Leer nuevos datos con validación (antes de bloquear la zona: el bloqueo solo
+    // dura lo que tarda la escritura, no lo que tarda el operador)
+    printf("Ingrese los niveles de contaminantes para la zona %s:\n", zonas[id_zona - 1].nombre);
     
-    return prediccion;
-}
+    // Validar datos de contaminantes con rangos específicos
+    funcionValidarDatosdeRegistro(&niveles.co2, "CO2 (ppm)", 0.0, 3000.0);
+    
+    funcionValidarDatosdeRegistro(&niveles.so2, "SO2 (ug/m3)", 0.0, 500.0);
+    
+    funcionValidarDatosdeRegistro(&niveles.no2, "NO2 (ug/m3)", 0.0, 300.0);
+    
+    funcionValidarDatosdeRegistro(&niveles.pm25, "PM2.5 (ug/m3)", 0.0, 200.0);
 
-// Función principal para predecir clima a 24h
-DatosClimaticos predecirClima24h(ZonaUrbana *zona) {
-    DatosClimaticos clima_predicho;
+    // Registrar datos climáticos con validación
+    printf("\nIngrese los datos climaticos para la zona %s:\n", zonas[id_zona - 1].nombre);
     
-    // Generar datos históricos climáticos consistentes basados en el clima actual
-    // Usar variaciones determinísticas basadas en el índice del día
-    float hist_temperatura[MAX_DIAS_HISTORICOS];
-    float hist_viento[MAX_DIAS_HISTORICOS];
-    float hist_humedad[MAX_DIAS_HISTORICOS];
-    float hist_presion[MAX_DIAS_HISTORICOS];
+    funcionValidarDatosdeRegistro(&clima.temperatura, "Temperatura (Celsius)", -20.0, 50.0);
     
-    // Generar histórico climático de forma determinística
-    // Usar el día como semilla para variaciones consistentes
-    for(int i = 0; i < zona->dias_registrados; i++) {
-        // Variación basada en el índice del día (sin aleatoriedad)
-        float factor_dia = (float)(i % 7) / 7.0; // Ciclo semanal
-        float variacion_temp = (factor_dia - 0.5) * 6.0; // ±3°C
-        float variacion_viento = (factor_dia - 0.5) * 10.0; // ±5 km/h
-        float variacion_humedad = (factor_dia - 0.5) * 20.0; // ±10%
-        float variacion_presion = (factor_dia - 0.5) * 20.0; // ±10 hPa
-        
-        // Aplicar variaciones estacionales determinísticas
-        float factor_estacional = (float)((i % 30) / 30.0); // Ciclo mensual
-        variacion_temp += (factor_estacional - 0.5) * 4.0; // Variación estacional
-        
-        // Calcular valores históricos
-        hist_temperatura[i] = zona->clima_actual.temperatura + variacion_temp;
-        hist_viento[i] = zona->clima_actual.velocidad_viento + variacion_viento;
-        hist_humedad[i] = zona->clima_actual.humedad + variacion_humedad;
-        hist_presion[i] = zona->clima_actual.presion_atmosferica + variacion_presion;
-        
-        // Validar rangos durante la generación
-        if(hist_temperatura[i] < -20.0) hist_temperatura[i] = -20.0;
-        if(hist_temperatura[i] > 50.0) hist_temperatura[i] = 50.0;
-        if(hist_viento[i] < 0.0) hist_viento[i] = 0.0;
-        if(hist_viento[i] > 120.0) hist_viento[i] = 120.0;
-        if(hist_humedad[i] < 0.0) hist_humedad[i] = 0.0;
-        if(hist_humedad[i] > 100.0) hist_humedad[i] = 100.0;
-        if(hist_presion[i] < 900.0) hist_presion[i] = 900.0;
-        if(hist_presion[i] > 1100.0) hist_presion[i] = 1100.0;
-    }
-    
-    // Calcular predicciones usando promedio ponderado - MISMA LÓGICA QUE CONTAMINANTES
-    clima_predicho.temperatura = calcularPrediccionClimatica(hist_temperatura, zona->dias_registrados);
-    clima_predicho.velocidad_viento = calcularPrediccionClimatica(hist_viento, zona->dias_registrados);
-    clima_predicho.humedad = calcularPrediccionClimatica(hist_humedad, zona->dias_registrados);
-    clima_predicho.presion_atmosferica = calcularPrediccionClimatica(hist_presion, zona->dias_registrados);
+    funcionValidarDatosdeRegistro(&clima.velocidad_viento, "Velocidad del viento (km/h)", 0.0, 120.0);
     
-    // Validar rangos finales de las predicciones
-    if(clima_predicho.temperatura < -20.0) clima_predicho.temperatura = -20.0;
-    if(clima_predicho.temperatura > 50.0) clima_predicho.temperatura = 50.0;
-    if(clima_predicho.velocidad_viento < 0.0) clima_predicho.velocidad_viento = 0.0;
-    if(clima_predicho.velocidad_viento > 120.0) clima_predicho.velocidad_viento = 120.0;
-    if(clima_predicho.humedad < 0.0) clima_predicho.humedad = 0.0;
-    if(clima_predicho.humedad > 100.0) clima_predicho.humedad = 100.0;
-    if(clima_predicho.presion_atmosferica < 900.0) clima_predicho.presion_atmosferica = 900.0;
-    if(clima_predicho.presion_atmosferica > 1100.0) clima_predicho.presion_atmosferica = 1100.0;
+    funcionValidarDatosdeRegistro(&clima.humedad, "Humedad (%)", 0.0, 100.0);
     
-    return clima_predicho;
-}
+    funcionValidarDatosdeRegistro(&clima.presion_atmosferica, "Presion (hPa)", 900.0, 1100.0);
 
-void mostrarRecomendaciones(int nivel_alerta, char *contaminante) {
-    switch(nivel_alerta) {
-        case ALERTA_VERDE:
-            printf("> Condiciones normales - Calidad del aire buena\n");
-            printf("> Actividades al aire libre sin restricciones\n");
-            printf("> Ideal para ejercicio y deportes al exterior\n");
-            printf("> Mantener monitoreo regular\n");
-            printf("> Ventilar espacios cerrados normalmente\n");
-            break;
-            
-        case ALERTA_AMARILLA:
-            printf("> Personas sensibles deben limitar actividades prolongadas al aire libre\n");
-            printf("> Reducir ejercicio intenso en exteriores\n");
-            printf("> Preferir transporte publico o bicicleta\n");
-            printf("> Ventilar espacios cerrados en horas de menor contaminacion\n");
-            printf("> Grupos vulnerables: ninos, ancianos y personas con asma deben tomar precauciones\n");
-            break;
-            
-        case ALERTA_NARANJA:
-            printf("> Evitar actividades fisicas intensas al aire libre\n");
-            printf("> Usar mascarilla si es necesario salir por periodos prolongados\n");
-            printf("> Mantener ventanas cerradas durante el dia\n");
-            printf("> Personas con problemas respiratorios deben evitar exposicion\n");
-            printf("> Postponer actividades deportivas al exterior\n");
-            printf("> Usar purificadores de aire en espacios cerrados\n");
-            break;
-            
-        case ALERTA_ROJA:
-            printf("> EVITAR SALIR SI ES POSIBLE - PERMANECER EN INTERIORES\n");
-            printf("> Usar mascarilla N95 obligatoriamente al salir\n");
-            printf("> Mantener espacios cerrados y filtrar el aire\n");
-            printf("> Personas vulnerables deben quedarse en casa\n");
-            printf("> Contactar servicios medicos si hay sintomas respiratorios\n");
-            printf("> Suspender todas las actividades al aire libre\n");
-            printf("> Considerar evacuar a zonas con mejor calidad del aire\n");
-            break;
+    // Bloquear la zona y partir de la última versión guardada por cualquier instancia
+    ZonaUrbana *zona = &zonas[id_zona - 1];
+    if(!bloquearZona(id_zona)) {
+        printf("Error: la zona %s esta bloqueada por otra instancia. Intente de nuevo.\n", zona->nombre);
+        return;
     }
-    
-    // Recomendaciones adicionales generales
-    printf("\nRECOMENDACIONES ADICIONALES:\n");
-    switch(nivel_alerta) {
-        case ALERTA_VERDE:
-            printf("- Aprovechar para actividades al aire libre\n");
-            printf("- Mantener rutinas normales de ejercicio\n");
-            break;
-        case ALERTA_AMARILLA:
-            printf("- Revisar pronostico antes de planificar actividades\n");
-            printf("- Tener medicamentos para asma a la mano\n");
-            break;
-        case ALERTA_NARANJA:
-            printf("- Informar a grupos vulnerables sobre riesgos\n");
-            printf("- Evitar areas de trafico pesado\n");
-            break;
-        case ALERTA_ROJA:
-            printf("- Contactar autoridades de salud publica\n");
-            printf("- Activar protocolos de emergencia ambiental\n");
-            break;
+    refrescarZona(zona);
+
+    // Con la ventana llena, el día más antiguo pasa al histórico archivado (si es un
+    // día completado por interpolación, simplemente se descarta)
+    int descarta_imputado = zona->dias_registrados == MAX_DIAS_HISTORICOS && diaImputado(zona, MAX_DIAS_HISTORICOS - 1);
+    if(zona->dias_registrados == MAX_DIAS_HISTORICOS && !descarta_imputado &&
+       !archivarRegistro(&zona->archivado, registroDeZona(zona, MAX_DIAS_HISTORICOS - 1))) {
+        printf("Error: memoria insuficiente para archivar el historico de %s.\n", zona->nombre);
+        desbloquearZona(id_zona);
+        return;
     }
-}
 
-// ================= FUNCION DE CORRECCION DE DATOS INGRESADOS MEJORADA =================
-void corregirDatosIngresados(ZonaUrbana zonas[]) {
-    int id_zona, val, dia;
-    char continuar_editando = 's';
-    int cambios_realizados = 0;
+    // Mover datos históricos (FIFO - lo más reciente al inicio)
+    for(int i = MAX_DIAS_HISTORICOS-1; i > 0; i--) {
+        zona->historico[i] = zona->historico[i-1];
+        zona->historico_fechas[i] = zona->historico_fechas[i-1];
+    }
+    desplazarMapaDias(zona->dias_imputados);
+    desplazarMapaDias(zona->dias_duplicados);
 
-    // Mostrar zonas disponibles
-    cargarTodasLasZonas(zonas);
-    printf("\n=== EDITOR AVANZADO DE DATOS HISTORICOS ===\n");
-    printf("ZONAS DISPONIBLES PARA EDICION:\n");
-    for(int i = 0; i < MAX_ZONAS; i++) {
-        printf("%d. %s (%d dias de datos)\n", zonas[i].id_zona, zonas[i].nombre, zonas[i].dias_registrados);
+    // Actualizar niveles actuales
+    zona->niveles_actuales = niveles;
+    zona->clima_actual = clima;
+    zona->historico[0] = zona->niveles_actuales;
+    
+    // Actualizar histórico con fechas (fecha actual)
+    time_t tiempo_actual;
+    struct tm *info_tiempo;
+    time(&tiempo_actual);
+    info_tiempo = localtime(&tiempo_actual);
+    
+    zona->historico_fechas[0].fecha.dia = info_tiempo->tm_mday;
+    zona->historico_fechas[0].fecha.mes = info_tiempo->tm_mon + 1;
+    zona->historico_fechas[0].fecha.año = info_tiempo->tm_year + 1900;
+    zona->historico_fechas[0].niveles = zona->niveles_actuales;
+    zona->historico_fechas[0].clima = zona->clima_actual;
+    if(!agregarRegistroCuantiles(zona, &zona->historico_fechas[0])) {
+        printf("ADVERTENCIA: Memoria insuficiente para actualizar los percentiles de %s.\n", zona->nombre);
     }
 
-    // Seleccionar zona
-    do {
-        printf("\nSeleccione la zona a editar (1-%d): ", MAX_ZONAS);
-        val = scanf("%d", &id_zona);
-        fflush(stdin);
-        if(val != 1 || id_zona < 1 || id_zona > MAX_ZONAS) {
-            printf("ERROR: Opcion invalida. Intente de nuevo.\n");
+    // Incrementar contador de días registrados
+    if (zona->dias_registrados < MAX_DIAS_HISTORICOS) {
+        zona->dias_registrados++;
+    }
+    // Si se descartó un día imputado, el archivado no se corre y hay que rehacer los mapas
+    if(descarta_imputado) {
+        recalcularMapaExcesos(zona);
+    } else {
+        agregarDiaMapaExcesos(zona, zona->niveles_actuales);
+    }
+    invalidarDerivados(zona, TODOS_LOS_DERIVADOS); // Todos los días cambian de posición
+    // Un segundo registro en el mismo día deja al anterior como duplicado
+    if(zona->dias_registrados > 1 && numeroDeDia(zona->historico_fechas[1].fecha) ==
+                                      numeroDeDia(zona->historico_fechas[0].fecha)) {
+        // El anterior deja de contar: sus excesos se borran y el modelo y los detectores,
+        // que ya lo habían incorporado, se rehacen sin él
+        marcarBitDeMapa(zona->dias_duplicados, 1, 1);
+        marcarExcesosDia(zona, 1, zona->historico[1]);
+        zona->modelos_ajustados = 0;
+        zona->detectores_listos = 0;
+        // Los percentiles del año se rehacen sin la lectura anterior, igual que al cargar
+        int año_duplicado = zona->historico_fechas[1].fecha.año;
+        if(anioCompletoEnMemoria(zona, año_duplicado) && !reconstruirCuantilesZona(zona, año_duplicado)) {
+            printf("ADVERTENCIA: Memoria insuficiente para actualizar los percentiles de %s.\n", zona->nombre);
         }
-    } while(val != 1 || id_zona < 1 || id_zona > MAX_ZONAS);
+    }
 
-    ZonaUrbana *zona = &zonas[id_zona-1];
-    if(zona->dias_registrados == 0) {
-        printf("ERROR: No hay datos registrados para esta zona.\n");
-        return;
+    // Marcar valores atípicos y sensores trabados antes de guardar
+    detectarAnomaliasZona(zona);
+    
+    // Actualizar el modelo estadístico con la nueva lectura (sin reajuste completo)
+    actualizarModelosZona(zona, zona->niveles_actuales);
+    zona->modificada = 1;
+    publicarRegistroNuevo(zona);
+    aplicarRetencionZona(zona);
+
+    // Guardar zona actualizada automáticamente y liberar el bloqueo
+    if(guardarZonaBloqueada(zona)) {
+        printf("Datos registrados correctamente para la zona %s.\n", zona->nombre);
     }
+    desbloquearZona(id_zona);
+    
+    // Limpiar buffer de entrada
+    fflush(stdin);
 
-    printf("\n=== EDITANDO ZONA: %s ===\n", zona->nombre);
+}
+
+void monitoreoDetalladoPorZona(ZonaUrbana zonas[]) {
+    // Obtener fecha y hora actual
+    time_t tiempo_actual;
+    struct tm *info_tiempo;
+    time(&tiempo_actual);
+    info_tiempo = localtime(&tiempo_actual);
     
-    // BUCLE PRINCIPAL: SELECCIÓN DE DÍA Y EDICIÓN
+    printf("=== MONITOREO ACTUAL DE CALIDAD DEL AIRE ===\n");
+    printf("Fecha: %02d/%02d/%04d - Hora: %02d:%02d\n", 
+           info_tiempo->tm_mday, 
+           info_tiempo->tm_mon + 1, 
+           info_tiempo->tm_year + 1900,
+           info_tiempo->tm_hour,
+           info_tiempo->tm_min);
+    printf("=============================================\n\n");
+    
+    // DASHBOARD GENERAL - Vista rápida de todas las zonas
+    printf("ESTADO ACTUAL DEL SISTEMA:\n");
+    printf("===========================================\n");
+    
+    int zonas_activas = 0;
+    int alertas_criticas = 0;
+    ArenaTemporal *arena = arenaReportes();
+    BufferSalida salida;
+    iniciarBufferSalida(&salida, arena, TAM_BUFFER_SALIDA, stdout);
+    
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        if(zonas[i].dias_registrados > 0) {
+            zonas_activas++;
+            
+            // Contar excesos críticos (el día actual es el bit 0 de los mapas)
+            int excesos = contarBitsPalabra(excesosDeDia(&zonas[i], 0));
+            
+            // Determinar estado visual
+            const char *estado_icono;
+            if(excesos == 0) {
+                estado_icono = "BUENO";
+            } else if(excesos <= 1) {
+                estado_icono = "MODERADO";
+            } else if(excesos <= 2) {
+                estado_icono = "DANINO";
+                alertas_criticas++;
+            } else {
+                estado_icono = "CRITICO";
+                alertas_criticas++;
+            }
+            
+            agregarTextoAncho(&salida, zonas[i].nombre, 20);
+            agregarTexto(&salida, " | ");
+            agregarTexto(&salida, estado_icono);
+            agregarTexto(&salida, "\n");
+        } else {
+            agregarTextoAncho(&salida, zonas[i].nombre, 20);
+            agregarTexto(&salida, " | SIN DATOS\n");
+        }
+    }
+    vaciarBufferSalida(&salida);
+    liberarArena(arena);
+    
+    printf("\nRESUMEN: %d/%d zonas activas | %d alertas criticas\n", 
+           zonas_activas, MAX_ZONAS, alertas_criticas);
+    
+    // SELECCIÓN DE ZONA PARA MONITOREO DETALLADO
+    printf("\n===========================================\n");
+    printf("MONITOREO DETALLADO POR ZONA\n");
+    printf("===========================================\n");
+    
+    int zona_seleccionada, val;
+    
+    printf("\nZONAS DISPONIBLES:\n");
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        printf("%d. %s", zonas[i].id_zona, zonas[i].nombre);
+        if(zonas[i].dias_registrados > 0) {
+            // Mostrar fecha del último registro
+            printf(" (Ultimo: %02d/%02d/%04d)", 
+                   zonas[i].historico_fechas[0].fecha.dia,
+                   zonas[i].historico_fechas[0].fecha.mes,
+                   zonas[i].historico_fechas[0].fecha.año);
+        } else {
+            printf(" (Sin datos)");
+        }
+        printf("\n");
+    }
+    
+    // Seleccionar zona
     do {
-        // Mostrar días disponibles con fechas (últimos 10 días)
-        printf("\nDIAS DISPONIBLES PARA EDICION:\n");
-        printf("=================================================================\n");
-        printf("Dia    Fecha      CO2     SO2     NO2     PM2.5\n");
-        printf("-----------------------------------------------------------------\n");
-        
-        int dias_mostrar = (zona->dias_registrados > 10) ? 10 : zona->dias_registrados;
+        printf("\nSeleccione la zona para monitoreo actual (1-%d): ", MAX_ZONAS);
+        val = scanf("%d", &zona_seleccionada);
+        fflush(stdin);
         
-        for(int i = 0; i < dias_mostrar; i++) {
-            printf("%-6d %02d/%02d/%02d %7.1f %7.1f %7.1f %7.1f\n", 
-                   i+1,
-                   zona->historico_fechas[i].fecha.dia,
-                   zona->historico_fechas[i].fecha.mes,
-                   zona->historico_fechas[i].fecha.año % 100, // Solo últimos 2 dígitos del año
-                   zona->historico[i].co2, zona->historico[i].so2, 
-                   zona->historico[i].no2, zona->historico[i].pm25);
+        if(val != 1 || zona_seleccionada < 1 || zona_seleccionada > MAX_ZONAS) {
+            printf("Opcion invalida. Por favor, intente de nuevo.\n");
         }
-        printf("=================================================================\n");
+    } while(val != 1 || zona_seleccionada < 1 || zona_seleccionada > MAX_ZONAS);
+    
+    zona_seleccionada--;
+    
+    // Verificar si la zona tiene datos
+    if(zonas[zona_seleccionada].dias_registrados == 0) {
+        printf("\nERROR: La zona '%s' no tiene datos registrados.\n", 
+               zonas[zona_seleccionada].nombre);
+        printf("   Registre datos primero usando la opcion 1 del menu.\n");
+        return;
+    }
+    
+    // ================= MONITOREO ACTUAL =================
+    printf("\nMONITOREO ACTUAL: %s\n", zonas[zona_seleccionada].nombre);
+    printf("===========================================\n");
+    printf("Perfil de umbrales: %s\n", zonas[zona_seleccionada].perfil);
+    
+    // Fecha del último registro
+    printf("Ultimo registro: %02d/%02d/%04d\n", 
+           zonas[zona_seleccionada].historico_fechas[0].fecha.dia,
+           zonas[zona_seleccionada].historico_fechas[0].fecha.mes,
+           zonas[zona_seleccionada].historico_fechas[0].fecha.año);
+    
+    // 1. NIVELES ACTUALES DE CONTAMINANTES
+    printf("\nNIVELES DE CONTAMINANTES ACTUALES:\n");
+    printf("-------------------------------------------\n");
+    
+    // CO2
+    printf("CO2:   %6.1f ppm   | Limite: %6.1f | ", 
+           zonas[zona_seleccionada].niveles_actuales.co2, zonas[zona_seleccionada].limites[0]);
+    if(zonas[zona_seleccionada].niveles_actuales.co2 > zonas[zona_seleccionada].limites[0]) {
+        printf("EXCEDE (%.1f%%)\n", 
+               (zonas[zona_seleccionada].niveles_actuales.co2 / zonas[zona_seleccionada].limites[0]) * 100 - 100);
+    } else {
+        printf("NORMAL\n");
+    }
+    
+    // SO2
+    printf("SO2:   %6.1f ug/m3 | Limite: %6.1f | ",
+           zonas[zona_seleccionada].niveles_actuales.so2, zonas[zona_seleccionada].limites[1]);
+    if(zonas[zona_seleccionada].niveles_actuales.so2 > zonas[zona_seleccionada].limites[1]) {
+        printf("EXCEDE (%.1f%%)\n", 
+               (zonas[zona_seleccionada].niveles_actuales.so2 / zonas[zona_seleccionada].limites[1]) * 100 - 100);
+    } else {
+        printf("NORMAL\n");
+    }
+    
+    // NO2
+    printf("NO2:   %6.1f ug/m3 | Limite: %6.1f | ",
+           zonas[zona_seleccionada].niveles_actuales.no2, zonas[zona_seleccionada].limites[2]);
+    if(zonas[zona_seleccionada].niveles_actuales.no2 > zonas[zona_seleccionada].limites[2]) {
+        printf("EXCEDE (%.1f%%)\n", 
+               (zonas[zona_seleccionada].niveles_actuales.no2 / zonas[zona_seleccionada].limites[2]) * 100 - 100);
+    } else {
+        printf("NORMAL\n");
+    }
+    
+    // PM2.5
+    printf("PM2.5: %6.1f ug/m3 | Limite: %6.1f | ",
+           zonas[zona_seleccionada].niveles_actuales.pm25, zonas[zona_seleccionada].limites[3]);
+    if(zonas[zona_seleccionada].niveles_actuales.pm25 > zonas[zona_seleccionada].limites[3]) {
+        printf("EXCEDE (%.1f%%)\n", 
+               (zonas[zona_seleccionada].niveles_actuales.pm25 / zonas[zona_seleccionada].limites[3]) * 100 - 100);
+    } else {
+        printf("NORMAL\n");
+    }
+    
+    // 2. CONDICIONES CLIMÁTICAS ACTUALES
+    printf("\nCONDICIONES CLIMATICAS ACTUALES:\n");
+    printf("-------------------------------------------\n");
+    printf("Temperatura:       %6.1f°C\n", zonas[zona_seleccionada].clima_actual.temperatura);
+    printf("Viento:           %6.1f km/h\n", zonas[zona_seleccionada].clima_actual.velocidad_viento);
+    printf("Humedad:          %6.1f%%\n", zonas[zona_seleccionada].clima_actual.humedad);
+    printf("Presion:          %6.1f hPa\n", zonas[zona_seleccionada].clima_actual.presion_atmosferica);
+    
+    // 3. ÍNDICE DE CALIDAD DEL AIRE (ICA)
+    printf("\nINDICE DE CALIDAD DEL AIRE:\n");
+    printf("-------------------------------------------\n");
+    
+    // Alertas, ICA (tablas de 24 horas) y promedio móvil se recalculan solo si cambió
+    // alguno de los días de los que dependen
+    ZonaUrbana *zona = &zonas[zona_seleccionada];
+    const AlertasZona *alertas = obtenerAlertasZona(zona);
+    const float *promedio_30 = obtenerPromedio30Dias(zona);
+    ResultadoICA ica = alertas->ica;
+    char *nombres_ica[] = {"CO2", "SO2", "NO2", "PM2.5"};
+    char *niveles_alerta[] = {"VERDE", "AMARILLO", "NARANJA", "ROJO"};
+    printf("ICA: %d - %s (%s)\n", ica.indice, nombreCategoriaICA(ica.categoria), colorCategoriaICA(ica.categoria));
+    printf("Subindices: SO2 %d | NO2 %d | PM2.5 %d (principal: %s)\n",
+           ica.subindices[1], ica.subindices[2], ica.subindices[3], nombres_ica[ica.contaminante_principal]);
+    printf("Alerta actual: %s", niveles_alerta[alertas->general]);
+    if(alertas->general_24h >= 0) {
+        printf(" | Pronosticada a 24h: %s", niveles_alerta[alertas->general_24h]);
+    }
+    printf("\n");
+    printf("Promedio %d dias: CO2 %.1f | SO2 %.1f | NO2 %.1f | PM2.5 %.1f\n", DIAS_PROMEDIO_MOVIL,
+           promedio_30[0], promedio_30[1], promedio_30[2], promedio_30[3]);
+    
+    if(ica.categoria == 0) {
+        printf("   Seguro para actividades al aire libre\n");
+    } else if(ica.categoria == 1) {
+        printf("   Grupos sensibles deben limitar actividades prolongadas\n");
+    } else if(ica.categoria <= 3) {
+        printf("   Todos deben reducir actividades al aire libre\n");
+    } else {
+        printf("   Evitar actividades al aire libre\n");
+    }
+    
+    // 4. RECOMENDACIONES INMEDIATAS
+    printf("\nRECOMENDACIONES INMEDIATAS:\n");
+    printf("-------------------------------------------\n");
+    
+    if(ica.categoria == 0) {
+        printf("- Condiciones favorables para actividades exteriores\n");
+        printf("- Mantener monitoreo de rutina\n");
+        printf("- Ventilar espacios interiores\n");
+    } else {
+        printf("- Limitar tiempo de exposicion al aire libre\n");
+        printf("- Usar mascarilla si es necesario salir\n");
+        printf("- Mantener ventanas cerradas\n");
+        printf("- Activar purificadores de aire si estan disponibles\n");
         
-        if(zona->dias_registrados > 10) {
-            printf("(Mostrando ultimos 10 dias de %d disponibles)\n", zona->dias_registrados);
+        if(ica.categoria >= 3) {
+            printf("- URGENTE: Grupos vulnerables deben permanecer en interiores\n");
+            printf("- Suspender actividades deportivas al aire libre\n");
         }
+    }
+    
+    printf("\n===========================================\n");
+}
 
-        // Seleccionar día
-        do {
-            printf("Seleccione el dia a editar (1-%d): ", zona->dias_registrados);
-            val = scanf("%d", &dia);
-            fflush(stdin);
-            if(val != 1 || dia < 1 || dia > zona->dias_registrados) {
-                printf("ERROR: Dia invalido. Intente de nuevo.\n");
-            }
-        } while(val != 1 || dia < 1 || dia > zona->dias_registrados);
-        dia--; // convertir a índice
-
-        // BUCLE DE EDICIÓN MÚLTIPLE PARA EL DÍA SELECCIONADO
-        int cambios_dia = 0;
-        do {
-            int subop;
-            float nuevo_valor;
-            char confirmacion;
-            
-            // Mostrar panel de edición
-            printf("\nEDITOR - DIA %d de %s\n", dia + 1, zona->nombre);
-            printf("=======================================================\n");
-            printf("CONTAMINANTES ACTUALES:\n");
-            printf("  1. CO2:\t%6.1f ppm\n", zona->historico[dia].co2);
-            printf("  2. SO2:\t%6.1f ug/m3\n", zona->historico[dia].so2);
-            printf("  3. NO2:\t%6.1f ug/m3\n", zona->historico[dia].no2);
-            printf("  4. PM2.5:\t%6.1f ug/m3\n", zona->historico[dia].pm25);
-            printf("\nDATOS CLIMATICOS ACTUALES:\n");
-            printf("  5. Temperatura:\t%6.1f C\n", zona->clima_actual.temperatura);
-            printf("  6. Viento:\t\t%6.1f km/h\n", zona->clima_actual.velocidad_viento);
-            printf("  7. Humedad:\t\t%6.1f %%\n", zona->clima_actual.humedad);
-            printf("  8. Presion:\t\t%6.1f hPa\n", zona->clima_actual.presion_atmosferica);
-            printf("=======================================================\n");
-            printf("  9. Edicion rapida (todos los contaminantes)\n");
-            printf("  0. Terminar edicion de este dia\n");
-            
-            do {
-                printf("\nSeleccione el campo a editar (0-9): ");
-                val = scanf("%d", &subop);
-                fflush(stdin);
-                if(val != 1 || subop < 0 || subop > 9) {
-                    printf("ERROR: Opcion invalida. Intente de nuevo.\n");
-                }
-            } while(val != 1 || subop < 0 || subop > 9);
-            
-            if(subop == 0) {
-                break; // Terminar edición de este día
-            }
-            
-            // Edición rápida de todos los contaminantes
-            if(subop == 9) {
-                printf("\nEDICION RAPIDA - TODOS LOS CONTAMINANTES\n");
-                printf("Valores actuales: CO2=%.1f, SO2=%.1f, NO2=%.1f, PM2.5=%.1f\n",
-                       zona->historico[dia].co2, zona->historico[dia].so2, 
-                       zona->historico[dia].no2, zona->historico[dia].pm25);
-                       
-                float nuevos_valores[4];
-                char *nombres_cont[] = {"CO2 (ppm)", "SO2 (ug/m3)", "NO2 (ug/m3)", "PM2.5 (ug/m3)"};
-                float rangos_min[] = {0.0, 0.0, 0.0, 0.0};
-                float rangos_max[] = {1000.0, 500.0, 300.0, 200.0};
-                
-                printf("Ingrese los nuevos valores:\n");
-                for(int i = 0; i < 4; i++) {
-                    funcionValidarDatosdeRegistro(&nuevos_valores[i], nombres_cont[i], 
-                                                 rangos_min[i], rangos_max[i]);
-                }
-                
-                // Confirmar cambios masivos
-                printf("\nRESUMEN DE CAMBIOS:\n");
-                printf("CO2:\t%.1f\t-->\t%.1f ppm\n", zona->historico[dia].co2, nuevos_valores[0]);
-                printf("SO2:\t%.1f\t-->\t%.1f ug/m3\n", zona->historico[dia].so2, nuevos_valores[1]);
-                printf("NO2:\t%.1f\t-->\t%.1f ug/m3\n", zona->historico[dia].no2, nuevos_valores[2]);
-                printf("PM2.5:\t%.1f\t-->\t%.1f ug/m3\n", zona->historico[dia].pm25, nuevos_valores[3]);
-                
-                do {
-                    printf("¿Confirma TODOS estos cambios? (s/n): ");
-                    scanf(" %c", &confirmacion);
-                    fflush(stdin);
-                } while(confirmacion != 's' && confirmacion != 'S' && confirmacion != 'n' && confirmacion != 'N');
-                
-                if(confirmacion == 's' || confirmacion == 'S') {
-                    zona->historico[dia].co2 = nuevos_valores[0];
-                    zona->historico[dia].so2 = nuevos_valores[1];
-                    zona->historico[dia].no2 = nuevos_valores[2];
-                    zona->historico[dia].pm25 = nuevos_valores[3];
-                    
-                    // Actualizar también el histórico con fechas
-                    zona->historico_fechas[dia].niveles.co2 = nuevos_valores[0];
-                    zona->historico_fechas[dia].niveles.so2 = nuevos_valores[1];
-                    zona->historico_fechas[dia].niveles.no2 = nuevos_valores[2];
-                    zona->historico_fechas[dia].niveles.pm25 = nuevos_valores[3];
-                    
-                    // Actualizar niveles actuales si es el día más reciente
-                    if(dia == 0) {
-                        zona->niveles_actuales = zona->historico[0];
-                    }
-                    
-                    printf("EXITO: Todos los contaminantes actualizados exitosamente.\n");
-                    cambios_dia += 4;
-                    
-                    // Guardar inmediatamente para evitar pérdida de datos
-                    guardarZona(zona);
-                } else {
-                    printf("ERROR: Cambios cancelados.\n");
-                }
-                continue;
-            }
-            
-            // Edición individual
-            char *nombres[] = {"", "CO2 (ppm)", "SO2 (ug/m3)", "NO2 (ug/m3)", "PM2.5 (ug/m3)",
-                              "Temperatura (C)", "Viento (km/h)", "Humedad (%)", "Presion (hPa)"};
-            float rangos_min[] = {0, 0.0, 0.0, 0.0, 0.0, -20.0, 0.0, 0.0, 900.0};
-            float rangos_max[] = {0, 1000.0, 500.0, 300.0, 200.0, 50.0, 120.0, 100.0, 1100.0};
-            
-            printf("\nEDITANDO: %s\n", nombres[subop]);
-            printf("Valor actual: ");
-            switch(subop) {
-                case 1: printf("%.1f ppm\n", zona->historico[dia].co2); break;
-                case 2: printf("%.1f ug/m3\n", zona->historico[dia].so2); break;
-                case 3: printf("%.1f ug/m3\n", zona->historico[dia].no2); break;
-                case 4: printf("%.1f ug/m3\n", zona->historico[dia].pm25); break;
-                case 5: printf("%.1f C\n", zona->clima_actual.temperatura); break;
-                case 6: printf("%.1f km/h\n", zona->clima_actual.velocidad_viento); break;
-                case 7: printf("%.1f%%\n", zona->clima_actual.humedad); break;
-                case 8: printf("%.1f hPa\n", zona->clima_actual.presion_atmosferica); break;
-            }
-            
-            funcionValidarDatosdeRegistro(&nuevo_valor, nombres[subop], 
-                                         rangos_min[subop], rangos_max[subop]);
-
-            // Confirmar cambio individual
-            do {
-                printf("¿Confirma el cambio de %s? (s/n): ", nombres[subop]);
-                scanf(" %c", &confirmacion);
-                fflush(stdin);
-            } while(confirmacion != 's' && confirmacion != 'S' && confirmacion != 'n' && confirmacion != 'N');
+void mostrarEstadoSistema(ZonaUrbana zonas[])
+{
+    printf("Sistema de Monitoreo - Quito\n");
+    printf("==================================\n\n");
+    
+    // Resumen general
+    int zonas_activas = 0;
+    int total_registros = 0;
+    
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        if(zonas[i].dias_registrados > 0) {
+            zonas_activas++;
+            total_registros += zonas[i].dias_registrados;
+        }
+    }
+    
+    printf("RESUMEN GENERAL:\n");
+    printf("  Zonas configuradas: %d\n", MAX_ZONAS);
+    printf("  Zonas con datos: %d\n", zonas_activas);
+    printf("  Total de registros: %d\n", total_registros);
+    if(zonas_activas > 0) {
+        printf("  Estado: OPERATIVO\n");
+    } else {
+        printf("  Estado: SIN DATOS\n");
+    }
+    
+    // Estado por zona (resumido)
+    printf("\nESTADO POR ZONA:\n");
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        printf("  %s: %d días registrados", 
+               zonas[i].nombre, zonas[i].dias_registrados);
+        if(zonas[i].archivado.num_registros > 0) {
+            printf(" (+%d archivados)", zonas[i].archivado.num_registros);
+        }
+        
+        if(zonas[i].dias_registrados > 0) {
+            printf(" OK\n");
+        } else {
+            printf(" SIN DATOS\n");
+        }
+        
+        // Calidad de la serie de fechas
+        int imputados = contarBitsMapa(zonas[i].dias_imputados);
+        int duplicados = contarBitsMapa(zonas[i].dias_duplicados);
+        if(imputados > 0 || duplicados > 0 || zonas[i].huecos_sin_completar > 0) {
+            printf("    %d interpolado(s), %d fecha(s) repetida(s), %d hueco(s) sin completar\n",
+                   imputados, duplicados, zonas[i].huecos_sin_completar);
+        }
+    }
+    
+    // Memoria temporal de reportes: las reservas al sistema no deben crecer con el uso
+    ArenaTemporal *arena = arenaReportes();
+    printf("\nMEMORIA TEMPORAL DE REPORTES:\n");
+    printf("  Capacidad: %lu KB (pico %lu KB)\n",
+           (unsigned long)(arena->tamano / 1024), (unsigned long)(arena->pico / 1024));
+    printf("  Pedidos atendidos: %ld\n", arena->reservas);
+    printf("  Reservas al sistema: %ld\n", arena->reservas_sistema);
+    
+    medirRenderizadoHistorial(zonas);
+}
 
-            if(confirmacion == 's' || confirmacion == 'S') {
-                switch(subop) {
-                    case 1: 
-                        zona->historico[dia].co2 = nuevo_valor; 
-                        zona->historico_fechas[dia].niveles.co2 = nuevo_valor;
-                        break;
-                    case 2: 
-                        zona->historico[dia].so2 = nuevo_valor; 
-                        zona->historico_fechas[dia].niveles.so2 = nuevo_valor;
-                        break;
-                    case 3: 
-                        zona->historico[dia].no2 = nuevo_valor; 
-                        zona->historico_fechas[dia].niveles.no2 = nuevo_valor;
-                        break;
-                    case 4: 
-                        zona->historico[dia].pm25 = nuevo_valor; 
-                        zona->historico_fechas[dia].niveles.pm25 = nuevo_valor;
-                        break;
-                    case 5: 
-                        zona->clima_actual.temperatura = nuevo_valor; 
-                        zona->historico_fechas[dia].clima.temperatura = nuevo_valor;
-                        break;
-                    case 6: 
-                        zona->clima_actual.velocidad_viento = nuevo_valor; 
-                        zona->historico_fechas[dia].clima.velocidad_viento = nuevo_valor;
-                        break;
-                    case 7: 
-                        zona->clima_actual.humedad = nuevo_valor; 
-                        zona->historico_fechas[dia].clima.humedad = nuevo_valor;
-                        break;
-                    case 8: 
-                        zona->clima_actual.presion_atmosferica = nuevo_valor; 
-                        zona->historico_fechas[dia].clima.presion_atmosferica = nuevo_valor;
-                        break;
-                }
-                
-                // Si editamos el día más reciente (día 1 = índice 0), actualizar niveles actuales
-                if(dia == 0 && subop <= 4) {
-                    zona->niveles_actuales = zona->historico[0];
-                    printf("INFO: Niveles actuales actualizados (día más reciente modificado).\n");
-                }
-                
-                printf("EXITO: Cambio aplicado exitosamente.\n");
-                cambios_dia++;
-                
-                // Guardar inmediatamente para evitar pérdida de datos
-                guardarZona(zona);
-            } else {
-                printf("ERROR: Cambio cancelado.\n");
+void mostrarTendenciasHistorico(ZonaUrbana zonas[]) {
+    printf("=== TENDENCIAS E HISTORICO ===\n");
+    printf("Fecha: %s - Hora: %s\n", __DATE__, __TIME__);
+    printf("======================================================\n");
+    printf("GRAFICOS Y ANALISIS DE DATOS HISTORICOS\n");
+    printf("======================================================\n\n");
+    
+    int zona_seleccionada, val;
+    
+    // Mostrar zonas disponibles
+    printf("ZONAS DISPONIBLES:\n");
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        printf("%d. %s", zonas[i].id_zona, zonas[i].nombre);
+        if(zonas[i].dias_registrados > 0) {
+            printf(" (%d dias de datos)\n", zonas[i].dias_registrados);
+        } else {
+            printf(" (Sin datos)\n");
+        }
+    }
+    
+    // Seleccionar zona
+    do {
+        printf("\nSeleccione la zona para analizar tendencias (1-%d): ", MAX_ZONAS);
+        val = scanf("%d", &zona_seleccionada);
+        fflush(stdin);
+        
+        if(val != 1 || zona_seleccionada < 1 || zona_seleccionada > MAX_ZONAS) {
+            printf("Opcion invalida. Por favor, intente de nuevo.\n");
+        }
+    } while(val != 1 || zona_seleccionada < 1 || zona_seleccionada > MAX_ZONAS);
+    
+    zona_seleccionada--;
+    
+    // El análisis trabaja sobre una instantánea fija: un registro nuevo publica otra
+    // instantánea sin esperar a que termine el reporte
+    InstantaneaZona *zona = fijarInstantanea(zona_seleccionada + 1);
+    if(zona == NULL) {
+        printf("\nERROR: La zona seleccionada no esta disponible.\n");
+        return;
+    }
+    
+    if(zona->dias_registrados == 0) {
+        printf("\nERROR: La zona '%s' no tiene datos registrados.\n", 
+               zona->nombre);
+        liberarInstantanea(zona);
+        return;
+    }
+    
+    // Datos intermedios del análisis, liberados juntos al terminar
+    ArenaTemporal *arena = arenaReportes();
+    
+    printf("\n=== ANALISIS DE TENDENCIAS: %s ===\n", zona->nombre);
+    printf("========================================================\n");
+    
+    // 1. HISTORIAL DETALLADO DE DATOS
+    printf("\n1. HISTORIAL DETALLADO DE CONTAMINANTES:\n");
+    printf("------------------------------------------------------\n");
+    
+    printf("Fecha      | CO2    | SO2    | NO2    | PM2.5  | Estado General\n");
+    printf("-----------|--------|--------|--------|--------|---------------\n");
+    
+    int dias_mostrar;
+    if(zona->dias_registrados > 10) {
+        dias_mostrar = 10;
+    } else {
+        dias_mostrar = zona->dias_registrados;
+    }
+    
+    BufferSalida salida;
+    iniciarBufferSalida(&salida, arena, TAM_BUFFER_SALIDA, stdout);
+    for(int i = 0; i < dias_mostrar; i++) {
+        const RegistroHistorico *registro = registroInstantanea(zona, i);
+        // Contar excesos para determinar estado
+        int mascara = excesosEnPlanos(zona->excesos[0], PALABRAS_MAPA_DIAS, i);
+        int excesos = contarBitsPalabra(mascara);
+        
+        const char *estado;
+        if(excesos == 0) {
+            estado = "Bueno";
+        } else if(excesos <= 1) {
+            estado = "Moderado";
+        } else if(excesos <= 2) {
+            estado = "Danino";
+        } else {
+            estado = "Peligroso";
+        }
+        
+        agregarEntero(&salida, registro->fecha.dia, 2, '0');
+        agregarTexto(&salida, "/");
+        agregarEntero(&salida, registro->fecha.mes, 2, '0');
+        agregarTexto(&salida, "/");
+        agregarEntero(&salida, registro->fecha.año, 4, '0');
+        agregarTexto(&salida, " | ");
+        agregarDecimal(&salida, registro->niveles.co2, 6, 1, 1);
+        agregarTexto(&salida, " | ");
+        agregarDecimal(&salida, registro->niveles.so2, 6, 1, 1);
+        agregarTexto(&salida, " | ");
+        agregarDecimal(&salida, registro->niveles.no2, 6, 1, 1);
+        agregarTexto(&salida, " | ");
+        agregarDecimal(&salida, registro->niveles.pm25, 6, 1, 1);
+        agregarTexto(&salida, " | ");
+        agregarTexto(&salida, estado);
+        
+        // Marcar si excede límites OMS
+        if(excesos > 0) {
+            agregarTexto(&salida, " (");
+            if(mascara & 1) agregarTexto(&salida, "CO2 ");
+            if(mascara & 2) agregarTexto(&salida, "SO2 ");
+            if(mascara & 4) agregarTexto(&salida, "NO2 ");
+            if(mascara & 8) agregarTexto(&salida, "PM2.5 ");
+            agregarTexto(&salida, "exceden)");
+        }
+        agregarTexto(&salida, "\n");
+    }
+    vaciarBufferSalida(&salida);
+    
+    // 2. ANÁLISIS ESTADÍSTICO
+    printf("\n2. ANALISIS ESTADISTICO:\n");
+    printf("------------------------------------------------------\n");
+    
+    // Estadísticas de la ventana, calculadas al publicar la instantánea
+    const EstadisticasVentana *estadisticas = &zona->estadisticas;
+    float promedio_co2 = estadisticas->promedio[0], max_co2 = estadisticas->maximo[0], min_co2 = estadisticas->minimo[0];
+    float promedio_so2 = estadisticas->promedio[1], max_so2 = estadisticas->maximo[1], min_so2 = estadisticas->minimo[1];
+    float promedio_no2 = estadisticas->promedio[2], max_no2 = estadisticas->maximo[2], min_no2 = estadisticas->minimo[2];
+    float promedio_pm25 = estadisticas->promedio[3], max_pm25 = estadisticas->maximo[3], min_pm25 = estadisticas->minimo[3];
+    
+    printf("ESTADISTICAS DE LA VENTANA (ultimos %d dias):\n", zona->dias_registrados);
+    printf("                 | Promedio | Maximo  | Minimo  | Limite OMS | Estado\n");
+    printf("-----------------|----------|---------|---------|------------|--------\n");
+    printf("CO2 (ppm)\t| %.1f\t| %.1f\t| %.1f\t| %.1f\t| ", 
+           promedio_co2, max_co2, min_co2, zona->limites[0]);
+    if(promedio_co2 > zona->limites[0]) {
+        printf("EXCEDE\n");
+    } else {
+        printf("OK\n");
+    }
+    
+    printf("SO2 (ug/m3)\t| %.1f\t| %.1f\t| %.1f\t| %.1f\t| ", 
+           promedio_so2, max_so2, min_so2, zona->limites[1]);
+    if(promedio_so2 > zona->limites[1]) {
+        printf("EXCEDE\n");
+    } else {
+        printf("OK\n");
+    }
+    
+    printf("NO2 (ug/m3)\t| %.1f\t| %.1f\t| %.1f\t| %.1f\t| ", 
+           promedio_no2, max_no2, min_no2, zona->limites[2]);
+    if(promedio_no2 > zona->limites[2]) {
+        printf("EXCEDE\n");
+    } else {
+        printf("OK\n");
+    }
+    
+    printf("PM2.5 (ug/m3)\t| %.1f\t| %.1f\t| %.1f\t| %.1f\t| ", 
+           promedio_pm25, max_pm25, min_pm25, zona->limites[3]);
+    if(promedio_pm25 > zona->limites[3]) {
+        printf("EXCEDE\n");
+    } else {
+        printf("OK\n");
+    }
+    
+    // Promedio y máximo de todo el histórico, desde el resumen anual de la instantánea
+    char *nombres_percentil[] = {"CO2 (ppm)", "SO2 (ug/m3)", "NO2 (ug/m3)", "PM2.5 (ug/m3)"};
+    int dias_historico = 0;
+    for(int i = 0; i < zona->num_anios_resumen; i++) {
+        dias_historico += zona->resumen_anual[i].dias;
+    }
+    if(dias_historico > zona->dias_registrados) {
+        printf("\nTODO EL HISTORICO (%d dias, incluidos los compactados en disco):\n", dias_historico);
+        printf("                 | Promedio | Maximo\n");
+        printf("-----------------|----------|---------\n");
+        for(int c = 0; c < 4; c++) {
+            float suma = 0, maximo = 0;
+            for(int i = 0; i < zona->num_anios_resumen; i++) {
+                float maximo_anio = obtenerNivelContaminante(zona->resumen_anual[i].maximo, c);
+                suma += obtenerNivelContaminante(zona->resumen_anual[i].suma, c);
+                if(i == 0 || maximo_anio > maximo) maximo = maximo_anio;
             }
-                
-        } while(1); // El bucle se rompe con subop == 0
+            printf("%-16s | %8.1f | %8.1f\n", nombres_percentil[c], suma / dias_historico, maximo);
+        }
+    }
+    
+    // Percentiles de todo el histórico, desde los resúmenes anuales de la zona
+    printf("\nPERCENTILES DE TODO EL HISTORICO:\n");
+    printf("                 | P95      | P99      | Lecturas\n");
+    printf("-----------------|----------|----------|---------\n");
+    for(int c = 0; c < 4; c++) {
+        DigestCuantiles digest;
+        combinarCuantilesZonas(zonas, zona->id_zona, 0, 9999, c, &digest);
+        float p95 = cuantilDigest(&digest, 0.95);
+        printf("%-16s | %8.1f | %8.1f | %.0f\n", nombres_percentil[c], p95,
+               cuantilDigest(&digest, 0.99), digest.total);
+    }
+    
+    // 3. ANÁLISIS DE TENDENCIAS DETALLADO
+    printf("\n3. ANALISIS DE TENDENCIAS DETALLADO:\n");
+    printf("-------------------------------------------------------------\n");
+    
+    if(zona->dias_registrados > 1) {
+        // Calcular promedios históricos ponderados
+        int dias_para_promedio;
+        if(zona->dias_registrados > 7) {
+            dias_para_promedio = 7;
+        } else {
+            dias_para_promedio = zona->dias_registrados;
+        }
+        
+        float promedio_pond_co2 = 0, promedio_pond_so2 = 0, promedio_pond_no2 = 0, promedio_pond_pm25 = 0;
+        
+        for(int i = 0; i < dias_para_promedio; i++) {
+            const RegistroHistorico *registro = registroInstantanea(zona, i);
+            promedio_pond_co2 += registro->niveles.co2;
+            promedio_pond_so2 += registro->niveles.so2;
+            promedio_pond_no2 += registro->niveles.no2;
+            promedio_pond_pm25 += registro->niveles.pm25;
+        }
+        
+        promedio_pond_co2 /= dias_para_promedio;
+        promedio_pond_so2 /= dias_para_promedio;
+        promedio_pond_no2 /= dias_para_promedio;
+        promedio_pond_pm25 /= dias_para_promedio;
+        
+        printf("PROMEDIO ULTIMOS %d DIAS vs NIVEL ACTUAL:\n", dias_para_promedio);
+        printf("Contaminante\t| Promedio\t| Actual\t| Diferencia\t| Tendencia\n");
+        printf("----------------|---------------|---------------|---------------|----------\n");
+        
+        // Análisis CO2
+        float dif_co2 = zona->niveles_actuales.co2 - promedio_pond_co2;
+        float porc_co2 = 0;
+        if(promedio_pond_co2 != 0) {
+            porc_co2 = absoluto(dif_co2 / promedio_pond_co2 * 100);
+        }
+        
+        printf("CO2 (ppm)\t| %.1f\t\t| %.1f\t\t| %.1f\t\t| ", 
+               promedio_pond_co2, zona->niveles_actuales.co2, dif_co2);
+        
+        if(zona->niveles_actuales.co2 > promedio_pond_co2) {
+            printf("SUBIENDO ");
+        } else {
+            printf("BAJANDO  ");
+        }
+        printf("(%.1f%%)\n", porc_co2);
+        
+        // Análisis SO2
+        float dif_so2 = zona->niveles_actuales.so2 - promedio_pond_so2;
+        float porc_so2 = 0;
+        if(promedio_pond_so2 != 0) {
+            porc_so2 = absoluto(dif_so2 / promedio_pond_so2 * 100);
+        }
+        
+        printf("SO2 (ug/m3)\t| %.1f\t\t| %.1f\t\t| %.1f\t\t| ", 
+               promedio_pond_so2, zona->niveles_actuales.so2, dif_so2);
+        
+        if(zona->niveles_actuales.so2 > promedio_pond_so2) {
+            printf("SUBIENDO ");
+        } else {
+            printf("BAJANDO  ");
+        }
+        printf("(%.1f%%)\n", porc_so2);
+        
+        // Análisis NO2
+        float dif_no2 = zona->niveles_actuales.no2 - promedio_pond_no2;
+        float porc_no2 = 0;
+        if(promedio_pond_no2 != 0) {
+            porc_no2 = absoluto(dif_no2 / promedio_pond_no2 * 100);
+        }
+        
+        printf("NO2 (ug/m3)\t| %.1f\t\t| %.1f\t\t| %.1f\t\t| ", 
+               promedio_pond_no2, zona->niveles_actuales.no2, dif_no2);
+        
+        if(zona->niveles_actuales.no2 > promedio_pond_no2) {
+            printf("SUBIENDO ");
+        } else {
+            printf("BAJANDO  ");
+        }
+        printf("(%.1f%%)\n", porc_no2);
+        
+        // Análisis PM2.5
+        float dif_pm25 = zona->niveles_actuales.pm25 - promedio_pond_pm25;
+        float porc_pm25 = 0;
+        if(promedio_pond_pm25 != 0) {
+            porc_pm25 = absoluto(dif_pm25 / promedio_pond_pm25 * 100);
+        }
+        
+        printf("PM2.5 (ug/m3)\t| %.1f\t\t| %.1f\t\t| %.1f\t\t| ", 
+               promedio_pond_pm25, zona->niveles_actuales.pm25, dif_pm25);
+        
+        if(zona->niveles_actuales.pm25 > promedio_pond_pm25) {
+            printf("SUBIENDO ");
+        } else {
+            printf("BAJANDO  ");
+        }
+        printf(" (%.1f%%)\n", porc_pm25);
+    }
+    
+    if(zona->dias_registrados >= 3) {
+        printf("\nCOMPARACION TEMPORAL (Primeros vs Ultimos dias):\n");
+        
+        // Comparar primeros 3 días vs últimos 3 días
+        float promedio_reciente = (registroInstantanea(zona, 0)->niveles.co2 + 
+                                  registroInstantanea(zona, 1)->niveles.co2 + 
+                                  registroInstantanea(zona, 2)->niveles.co2) / 3;
+        
+        int dias_antiguos = zona->dias_registrados - 1;
+        float promedio_antiguo = (registroInstantanea(zona, dias_antiguos)->niveles.co2 + 
+                                 registroInstantanea(zona, dias_antiguos-1)->niveles.co2 + 
+                                 registroInstantanea(zona, dias_antiguos-2)->niveles.co2) / 3;
+        
+        printf("CO2 - Tendencia:\n");
+        printf("  Promedio reciente (3 dias): %.1f ppm\n", promedio_reciente);
+        printf("  Promedio anterior (3 dias): %.1f ppm\n", promedio_antiguo);
+        
+        if(promedio_reciente > promedio_antiguo) {
+            float incremento = ((promedio_reciente - promedio_antiguo) / promedio_antiguo) * 100;
+            printf("  Tendencia: EMPEORANDO (%.1f%% mas alto)\n", incremento);
+        } else {
+            float mejora = ((promedio_antiguo - promedio_reciente) / promedio_antiguo) * 100;
+            printf("  Tendencia: MEJORANDO (%.1f%% mas bajo)\n", mejora);
+        }
+    }
+    
+    // 4. DÍAS PROBLEMÁTICOS
+    printf("\n4. DIAS PROBLEMATICOS:\n");
+    printf("-----------------------------------------------------------\n");
+    
+    printf("Dias con excesos de limites OMS en la ventana (ultimos %d dias):\n", zona->dias_registrados);
+    
+    // Los mapas de excesos de la instantánea llevan directo a cada día con excesos
+    const char *nombres_contaminantes[] = {"CO2 ", "SO2 ", "NO2 ", "PM2.5 "};
+    int dias_exceso = contarDiasConExcesosEnPlanos(zona->excesos[0], PALABRAS_MAPA_DIAS, 0,
+                                                   zona->dias_registrados, 1);
+    for(int i = siguienteDiaConExcesos(zona->excesos[0], PALABRAS_MAPA_DIAS, 0, zona->dias_registrados);
+        i < zona->dias_registrados;
+        i = siguienteDiaConExcesos(zona->excesos[0], PALABRAS_MAPA_DIAS, i + 1, zona->dias_registrados)) {
+        int mascara = excesosEnPlanos(zona->excesos[0], PALABRAS_MAPA_DIAS, i);
+        agregarTexto(&salida, "  Dia ");
+        agregarEntero(&salida, i + 1, 0, ' ');
+        agregarTexto(&salida, ": ");
+        agregarEntero(&salida, contarBitsPalabra(mascara), 0, ' ');
+        agregarTexto(&salida, " exceso(s) - ");
+        for(int c = 0; c < 4; c++) {
+            if(mascara & (1 << c)) agregarTexto(&salida, nombres_contaminantes[c]);
+        }
+        agregarTexto(&salida, "\n");
+    }
+    vaciarBufferSalida(&salida);
+    
+    printf("\nRESUMEN: %d de %d dias con excesos (%.1f%%)\n", 
+           dias_exceso, zona->dias_registrados,
+           (float)dias_exceso / zona->dias_registrados * 100);
+    
+    // 5. RECOMENDACIONES BASADAS EN TENDENCIAS
+    printf("\n5. RECOMENDACIONES BASADAS EN TENDENCIAS:\n");
+    printf("----------------------------------------------------------\n");
+    
+    float porcentaje_exceso = (float)dias_exceso / zona->dias_registrados * 100;
+    
+    if(porcentaje_exceso > 50) {
+        printf("CRITICO: Mas del 50%% de dias con excesos\n");
+        printf("- Implementar medidas de emergencia\n");
+        printf("- Restricciones de trafico permanentes\n");
+        printf("- Monitoreo continuo\n");
+    } else if(porcentaje_exceso > 25) {
+        printf("PREOCUPANTE: Mas del 25%% de dias con excesos\n");
+        printf("- Reforzar medidas preventivas\n");
+        printf("- Alertas tempranas\n");
+        printf("- Revision de politicas ambientales\n");
+    } else if(porcentaje_exceso > 0) {
+        printf("MODERADO: Algunos dias con excesos\n");
+        printf("- Mantener monitoreo regular\n");
+        printf("- Medidas preventivas ocasionales\n");
+    } else {
+        printf("BUENO: Sin excesos registrados\n");
+        printf("- Mantener politicas actuales\n");
+        printf("- Continuar monitoreo preventivo\n");
+    }
+    
+    // 6. TENDENCIA DE LARGO PLAZO (todas las capas: ventana, archivados, semanas y meses)
+    printf("\n6. TENDENCIA DE LARGO PLAZO (promedios anuales):\n");
+    printf("----------------------------------------------------------\n");
+    
+    const RegistroAgregado *resumen = zona->resumen_anual;
+    int num_anios = zona->num_anios_resumen;
+    printf("Anio | Dias | CO2    | SO2    | NO2    | PM2.5\n");
+    printf("-----|------|--------|--------|--------|-------\n");
+    for(int i = 0; i < num_anios; i++) {
+        float dias = resumen[i].dias;
+        printf("%4d | %4d | %-6.1f | %-6.1f | %-6.1f | %-6.1f\n",
+               resumen[i].inicio.año, resumen[i].dias,
+               resumen[i].suma.co2 / dias, resumen[i].suma.so2 / dias,
+               resumen[i].suma.no2 / dias, resumen[i].suma.pm25 / dias);
+    }
+    if(num_anios > 1) {
+        float pm25_primero = resumen[0].suma.pm25 / resumen[0].dias;
+        float pm25_ultimo = resumen[num_anios - 1].suma.pm25 / resumen[num_anios - 1].dias;
+        printf("PM2.5 %d -> %d: %s\n", resumen[0].inicio.año, resumen[num_anios - 1].inicio.año,
+               pm25_ultimo > pm25_primero ? "EMPEORANDO" : "MEJORANDO");
+    }
+    
+    printf("\n=======================================================\n");
+    liberarInstantanea(zona);
+    liberarArena(arena);
+}
+
+// ============= FUNCIONES DE PREDICCION 24H =============
+
+// Función principal para predicción de contaminación 24h
+void prediccionContaminacion24h(ZonaUrbana zonas[]) {
+    int zona_seleccionada, i;
+    
+    printf("\n=======================================================\n");
+    printf("           PREDICCION DE CONTAMINACION 24H            \n");
+    printf("=======================================================\n");
+    
+    // Mostrar zonas disponibles
+    printf("\nZonas disponibles para prediccion:\n");
+    for(i = 0; i < MAX_ZONAS; i++) {
+        if(zonas[i].dias_registrados > 0) {
+            printf("%d. %s (ID: %d) - %d dias de datos\n", 
+                   i+1, zonas[i].nombre, zonas[i].id_zona, zonas[i].dias_registrados);
+        }
+    }
+    
+    int val;
+    do {
+        printf("\nSeleccione una zona (1-5): ");
+        val = scanf("%d", &zona_seleccionada);
+        fflush(stdin);
+        
+        if(val != 1) {
+            printf("ERROR: Ingrese un numero valido.\n");
+            continue;
+        }
+        
+        zona_seleccionada--; // Ajustar a índice del array
+        
+        if(zona_seleccionada < 0 || zona_seleccionada >= MAX_ZONAS) {
+            printf("ERROR: Zona invalida. Ingrese un numero entre 1 y 5.\n");
+            continue;
+        }
+        
+        if(zonas[zona_seleccionada].dias_registrados < 3) {
+            printf("ERROR: Se necesitan al menos 3 dias de datos para hacer predicciones.\n");
+            printf("Esta zona tiene solo %d dias registrados.\n", 
+                   zonas[zona_seleccionada].dias_registrados);
+            continue;
+        }
+        
+        break;
+    } while(1);
+    
+    ZonaUrbana *zona = &zonas[zona_seleccionada];
+    
+    printf("\n=======================================================\n");
+    printf("PREDICCION PARA: %s (ID: %d)\n", zona->nombre, zona->id_zona);
+    printf("=======================================================\n");
+    
+    // Calcular predicciones ajustadas por el clima predicho
+    DatosClimaticos clima_predicho;
+    NivelesContaminacion prediccion = predecirNivelesZona24h(zona, &clima_predicho);
+    
+    float pred_co2 = prediccion.co2;
+    float pred_so2 = prediccion.so2;
+    float pred_no2 = prediccion.no2;
+    float pred_pm25 = prediccion.pm25;
+    
+    // Mostrar predicciones
+    printf("\nPREDICCIONES PARA LAS PROXIMAS 24 HORAS:\n");
+    printf("-------------------------------------------------------\n");
+    printf("CO2:   %.2f ppm (Limite OMS: %.2f ppm)\n", pred_co2, zona->limites[0]);
+    printf("SO2:   %.2f ug/m3 (Limite OMS: %.2f ug/m3)\n", pred_so2, zona->limites[1]);
+    printf("NO2:   %.2f ug/m3 (Limite OMS: %.2f ug/m3)\n", pred_no2, zona->limites[2]);
+    printf("PM2.5: %.2f ug/m3 (Limite OMS: %.2f ug/m3)\n", pred_pm25, zona->limites[3]);
+    
+    // Determinar niveles de alerta
+    int alerta_co2 = determinarNivelAlerta(pred_co2, zona->limites[0]);
+    int alerta_so2 = determinarNivelAlerta(pred_so2, zona->limites[1]);
+    int alerta_no2 = determinarNivelAlerta(pred_no2, zona->limites[2]);
+    int alerta_pm25 = determinarNivelAlerta(pred_pm25, zona->limites[3]);
+    
+    // Mostrar alertas
+    printf("\nNIVELES DE ALERTA PREDICHOS:\n");
+    printf("-------------------------------------------------------\n");
+    
+    char *niveles[] = {"VERDE", "AMARILLO", "NARANJA", "ROJO"};
+    printf("CO2:   %s\n", niveles[alerta_co2]);
+    printf("SO2:   %s\n", niveles[alerta_so2]);
+    printf("NO2:   %s\n", niveles[alerta_no2]);
+    printf("PM2.5: %s\n", niveles[alerta_pm25]);
+    
+    // Determinar nivel de alerta general (el más alto)
+    int alerta_general = alerta_co2;
+    if(alerta_so2 > alerta_general) alerta_general = alerta_so2;
+    if(alerta_no2 > alerta_general) alerta_general = alerta_no2;
+    if(alerta_pm25 > alerta_general) alerta_general = alerta_pm25;
+    
+    printf("\nNIVEL DE ALERTA GENERAL: %s\n", niveles[alerta_general]);
+    
+    // Mostrar condiciones climáticas predichas
+    printf("\nCONDICIONES CLIMATICAS PREDICHAS:\n");
+    printf("-------------------------------------------------------\n");
+    printf("Temperatura:        %.1f°C\n", clima_predicho.temperatura);
+    printf("Viento:             %.1f km/h\n", clima_predicho.velocidad_viento);
+    printf("Humedad:            %.1f%%\n", clima_predicho.humedad);
+    printf("Presion:            %.1f hPa\n", clima_predicho.presion_atmosferica);
+    
+    // Mostrar recomendaciones
+    printf("\nRECOMENDACIONES:\n");
+    printf("-------------------------------------------------------\n");
+    if(alerta_general >= ALERTA_ROJA) {
+        mostrarRecomendaciones(ALERTA_ROJA, "GENERAL");
+    } else if(alerta_general >= ALERTA_NARANJA) {
+        mostrarRecomendaciones(ALERTA_NARANJA, "GENERAL");
+    } else if(alerta_general >= ALERTA_AMARILLA) {
+        mostrarRecomendaciones(ALERTA_AMARILLA, "GENERAL");
+    } else {
+        mostrarRecomendaciones(ALERTA_VERDE, "GENERAL");
+    }
+    
+    // Probabilidad de exceder límites según el intervalo de predicción del modelo Holt,
+    // centrado en la predicción mostrada arriba (ya ajustada por el clima)
+    printf("\nPROBABILIDAD DE EXCEDER LIMITES OMS (modelo Holt):\n");
+    printf("-------------------------------------------------------\n");
+    
+    char *nombres_cont[] = {"CO2:  ", "SO2:  ", "NO2:  ", "PM2.5:"};
+    float factor_clima = ajustarPorClima(1.0, clima_predicho);
+    for(i = 0; i < 4; i++) {
+        float desviacion;
+        pronosticoHolt(&zona->modelos[i], 1, &desviacion);
+        float probabilidad = probabilidadExceder(obtenerNivelContaminante(prediccion, i),
+                                                 desviacion * factor_clima, zona->limites[i]);
+        printf("%s %5.1f%%\n", nombres_cont[i], probabilidad * 100);
+    }
+    
+    printf("\n=======================================================\n");
+}
+
+// Predicción de los cuatro contaminantes a 24h ajustada por el clima predicho.
+// Corresponde al primer horizonte del pronóstico multi-horizonte.
+// Si clima_predicho no es NULL, devuelve también las condiciones climáticas usadas.
+NivelesContaminacion predecirNivelesZona24h(ZonaUrbana *zona, DatosClimaticos *clima_predicho) {
+    const PronosticoZona *pronostico = obtenerPronosticoZona(zona);
+    NivelesContaminacion prediccion = {0.0, 0.0, 0.0, 0.0};
+    DatosClimaticos clima = zona->clima_actual;
+    
+    if(pronostico != NULL) {
+        prediccion.co2 = pronostico->niveles[0][0];
+        prediccion.so2 = pronostico->niveles[0][1];
+        prediccion.no2 = pronostico->niveles[0][2];
+        prediccion.pm25 = pronostico->niveles[0][3];
+        clima = pronostico->clima_predicho;
+    }
+    if(clima_predicho != NULL) {
+        *clima_predicho = clima;
+    }
+    return prediccion;
+}
+
+// Función auxiliar para calcular predicción usando promedio ponderado.
+// El arreglo debe estar en orden cronológico: el último elemento es el día más reciente.
+float calcularPrediccion(float *historico, int dias_disponibles) {
+    if(dias_disponibles < 3) return 0.0;
+    
+    float prediccion = 0.0;
+    
+    // Usar promedio ponderado con más peso a los días recientes
+    if(dias_disponibles >= 3) {
+        // Días más recientes tienen más peso
+        prediccion = historico[dias_disponibles-1] * PESO_DIA_1;  // Día más reciente
+        prediccion += historico[dias_disponibles-2] * PESO_DIA_2; // Segundo día
+        prediccion += historico[dias_disponibles-3] * PESO_DIA_3; // Tercer día
+        
+        // Si hay más días, usar el peso restante distribuido
+        if(dias_disponibles > 3) {
+            float suma_resto = 0.0;
+            for(int i = 0; i < dias_disponibles - 3; i++) {
+                suma_resto += historico[i];
+            }
+            prediccion += (suma_resto / (dias_disponibles - 3)) * PESO_RESTO;
+        }
+    }
+    
+    return prediccion;
+}
+
+// Función auxiliar para ajustar predicción por condiciones climáticas
+float ajustarPorClima(float prediccion_base, DatosClimaticos clima) {
+    const ConfiguracionSistema *config = configuracionActual();
+    float factor_ajuste = 1.0;
+    
+    // Ajuste por temperatura (temperaturas altas aumentan algunos contaminantes)
+    if(clima.temperatura > config->temperatura_alta) {
+        factor_ajuste *= config->factor_temperatura_alta;
+    } else if(clima.temperatura < config->temperatura_baja) {
+        factor_ajuste *= config->factor_temperatura_baja;
+    }
+    
+    // Ajuste por viento (viento fuerte dispersa contaminantes)
+    if(clima.velocidad_viento > config->viento_fuerte) {
+        factor_ajuste *= config->factor_viento_fuerte;
+    } else if(clima.velocidad_viento < config->viento_calmo) {
+        factor_ajuste *= config->factor_viento_calmo;
+    }
+    
+    // Ajuste por humedad (alta humedad puede incrementar ciertos contaminantes)
+    if(clima.humedad > config->humedad_alta) {
+        factor_ajuste *= config->factor_humedad_alta;
+    }
+    
+    // Ajuste por presión atmosférica (baja presión dificulta dispersión)
+    if(clima.presion_atmosferica < config->presion_baja) {
+        factor_ajuste *= config->factor_presion_baja;
+    }
+    
+    return prediccion_base * factor_ajuste;
+}
+
+// Función auxiliar para obtener el límite OMS de un contaminante
+float obtenerLimiteOMS(int tipo_contaminante) {
+    const LimitesOMS *limites = &configuracionActual()->limites;
+    switch(tipo_contaminante) {
+        case 0: return limites->co2_limite;  // CO2
+        case 1: return limites->so2_limite;  // SO2
+        case 2: return limites->no2_limite;  // NO2
+        case 3: return limites->pm25_limite; // PM2.5
+        default: return 100.0;
+    }
+}
+
+// Función auxiliar para determinar nivel de alerta con el límite de la zona
+// (zona->limites[c]), ya resuelto según su perfil
+int determinarNivelAlerta(float valor, float limite_oms) {
+    const ConfiguracionSistema *config = configuracionActual();
+    
+    // Determinar nivel de alerta basado en múltiplos del límite
+    if(valor <= limite_oms) {
+        return ALERTA_VERDE;
+    } else if(valor <= limite_oms * config->multiplicador_amarilla) {
+        return ALERTA_AMARILLA;
+    } else if(valor <= limite_oms * config->multiplicador_naranja) {
+        return ALERTA_NARANJA;
+    } else {
+        return ALERTA_ROJA;
+    }
+}
+
+// ================ FUNCIONES DE CONFIGURACION ================
+// Límites, múltiplos de alerta y factores climáticos se leen de ARCHIVO_CONFIGURACION
+// ("clave = valor", '#' para comentarios). Cada configuración publicada es inmutable:
+// recargar arma una nueva y solo si es válida cambia el puntero, así las lecturas no
+// usan bloqueos ni ven una configuración a medio cargar. La recarga (menú o SIGHUP) se
+// aplica entre opciones del menú, cuando nadie conserva un puntero a la anterior.
+
+static const ConfiguracionSistema CONFIGURACION_POR_DEFECTO = {
+    {LIMITE_CO2_OMS, LIMITE_SO2_OMS, LIMITE_NO2_OMS, LIMITE_PM25_OMS},
+    MULTIPLICADOR_ALERTA_AMARILLA, MULTIPLICADOR_ALERTA_NARANJA,
+    30.0, 1.1,      // Temperatura alta: +10%
+    10.0, 1.05,     // Temperatura baja: +5%
+    20.0, 0.85,     // Viento fuerte: -15%
+    5.0, 1.15,      // Viento calmo: +15%
+    80.0, 1.08,     // Humedad alta: +8%
+    1000.0, 1.05,   // Presión baja: +5%
+    {{"", {0}}}, 0, // Sin perfiles
+    {PERFIL_GENERAL}
+};
+
+static const ClaveConfiguracion CLAVES_CONFIGURACION[] = {
+    {"limite_co2", offsetof(ConfiguracionSistema, limites.co2_limite), 1.0, 5000.0},
+    {"limite_so2", offsetof(ConfiguracionSistema, limites.so2_limite), 1.0, 500.0},
+    {"limite_no2", offsetof(ConfiguracionSistema, limites.no2_limite), 1.0, 300.0},
+    {"limite_pm25", offsetof(ConfiguracionSistema, limites.pm25_limite), 1.0, 200.0},
+    {"multiplicador_amarilla", offsetof(ConfiguracionSistema, multiplicador_amarilla), 1.0, 10.0},
+    {"multiplicador_naranja", offsetof(ConfiguracionSistema, multiplicador_naranja), 1.0, 10.0},
+    {"temperatura_alta", offsetof(ConfiguracionSistema, temperatura_alta), -20.0, 50.0},
+    {"factor_temperatura_alta", offsetof(ConfiguracionSistema, factor_temperatura_alta), 0.1, 5.0},
+    {"temperatura_baja", offsetof(ConfiguracionSistema, temperatura_baja), -20.0, 50.0},
+    {"factor_temperatura_baja", offsetof(ConfiguracionSistema, factor_temperatura_baja), 0.1, 5.0},
+    {"viento_fuerte", offsetof(ConfiguracionSistema, viento_fuerte), 0.0, 120.0},
+    {"factor_viento_fuerte", offsetof(ConfiguracionSistema, factor_viento_fuerte), 0.1, 5.0},
+    {"viento_calmo", offsetof(ConfiguracionSistema, viento_calmo), 0.0, 120.0},
+    {"factor_viento_calmo", offsetof(ConfiguracionSistema, factor_viento_calmo), 0.1, 5.0},
+    {"humedad_alta", offsetof(ConfiguracionSistema, humedad_alta), 0.0, 100.0},
+    {"factor_humedad_alta", offsetof(ConfiguracionSistema, factor_humedad_alta), 0.1, 5.0},
+    {"presion_baja", offsetof(ConfiguracionSistema, presion_baja), 900.0, 1100.0},
+    {"factor_presion_baja", offsetof(ConfiguracionSistema, factor_presion_baja), 0.1, 5.0},
+};
+#define NUM_CLAVES_CONFIGURACION ((int)(sizeof(CLAVES_CONFIGURACION) / sizeof(CLAVES_CONFIGURACION[0])))
+
+static const ConfiguracionSistema *configuracion_vigente = &CONFIGURACION_POR_DEFECTO;
+static volatile sig_atomic_t recarga_configuracion_pendiente = 0;
+
+const ConfiguracionSistema *configuracionActual(void) {
+    return configuracion_vigente;
+}
+
+// Lee el archivo sobre 'configuracion' (las claves ausentes conservan su valor). Tras
+// una línea "[perfil nombre]" solo se aceptan límites, que quedan en ese perfil; los que
+// el perfil no define toman el límite general. Las zonas se asignan con
+// "perfil_zona_N = nombre". Devuelve el número de líneas inválidas, o -1 si no se pudo abrir.
+int leerArchivoConfiguracion(char *nombre_archivo, ConfiguracionSistema *configuracion) {
+    FILE *archivo = fopen(nombre_archivo, "r");
+    if(archivo == NULL) {
+        return -1;
+    }
+    
+    char linea[256];
+    char perfiles_asignados[MAX_ZONAS][MAX_NOMBRE_PERFIL];
+    int num_linea = 0, errores = 0;
+    PerfilUmbrales *perfil = NULL; // Sección en curso; NULL = configuración general
+    memset(perfiles_asignados, 0, sizeof(perfiles_asignados));
+    
+    while(fgets(linea, sizeof(linea), archivo) != NULL) {
+        char clave[64], texto[64], *fin;
+        int id_zona;
+        
+        num_linea++;
+        char *inicio = linea;
+        while(*inicio == ' ' || *inicio == '\t') inicio++;
+        if(*inicio == '\0' || *inicio == '\n' || *inicio == '\r' || *inicio == '#') {
+            continue;
+        }
+        
+        if(*inicio == '[') {
+            char nombre[MAX_NOMBRE_PERFIL];
+            int repetido = 0;
+            if(sscanf(inicio, "[perfil %31[^] \t]]", nombre) != 1) {
+                printf("%s, linea %d: seccion invalida ([perfil nombre])\n", nombre_archivo, num_linea);
+                errores++;
+                perfil = NULL;
+                continue;
+            }
+            for(int p = 0; p < configuracion->num_perfiles; p++) {
+                if(strcmp(configuracion->perfiles[p].nombre, nombre) == 0) repetido = 1;
+            }
+            if(repetido || configuracion->num_perfiles == MAX_PERFILES_UMBRALES) {
+                printf("%s, linea %d: perfil '%s' %s\n", nombre_archivo, num_linea, nombre,
+                       repetido ? "repetido" : "excede MAX_PERFILES_UMBRALES");
+                errores++;
+                perfil = NULL;
+                continue;
+            }
+            perfil = &configuracion->perfiles[configuracion->num_perfiles++];
+            strcpy(perfil->nombre, nombre);
+            for(int c = 0; c < 4; c++) {
+                perfil->limites[c] = -1.0; // Sin definir: límite general
+            }
+            continue;
+        }
+        
+        if(sscanf(inicio, "%63[^= \t] = %63s", clave, texto) != 2) {
+            printf("%s, linea %d: formato invalido (clave = valor)\n", nombre_archivo, num_linea);
+            errores++;
+            continue;
+        }
+        
+        // Asignación de perfil a una zona (valor de texto)
+        if(perfil == NULL && sscanf(clave, "perfil_zona_%d", &id_zona) == 1) {
+            if(id_zona < 1 || id_zona > MAX_ZONAS) {
+                printf("%s, linea %d: zona %d inexistente\n", nombre_archivo, num_linea, id_zona);
+                errores++;
+            } else if(strlen(texto) >= MAX_NOMBRE_PERFIL) {
+                printf("%s, linea %d: nombre de perfil de mas de %d caracteres\n", nombre_archivo, num_linea,
+                       MAX_NOMBRE_PERFIL - 1);
+                errores++;
+            } else {
+                snprintf(perfiles_asignados[id_zona - 1], MAX_NOMBRE_PERFIL, "%s", texto);
+            }
+            continue;
+        }
+        
+        float valor = strtof(texto, &fin);
+        int k = 0;
+        while(k < NUM_CLAVES_CONFIGURACION && strcmp(CLAVES_CONFIGURACION[k].clave, clave) != 0) k++;
+        if(*fin != '\0' || fin == texto) {
+            printf("%s, linea %d: valor no numerico '%s'\n", nombre_archivo, num_linea, texto);
+            errores++;
+        } else if(k == NUM_CLAVES_CONFIGURACION || (perfil != NULL && k >= 4)) {
+            printf("%s, linea %d: clave %s '%s'\n", nombre_archivo, num_linea,
+                   k == NUM_CLAVES_CONFIGURACION ? "desconocida" : "no valida en un perfil", clave);
+            errores++;
+        } else if(valor < CLAVES_CONFIGURACION[k].minimo || valor > CLAVES_CONFIGURACION[k].maximo) {
+            printf("%s, linea %d: %s fuera de rango (%.2f a %.2f)\n", nombre_archivo, num_linea, clave,
+                   CLAVES_CONFIGURACION[k].minimo, CLAVES_CONFIGURACION[k].maximo);
+            errores++;
+        } else if(perfil != NULL) {
+            perfil->limites[k] = valor; // Las cuatro primeras claves son los límites
+        } else {
+            *(float *)((char *)configuracion + CLAVES_CONFIGURACION[k].desplazamiento) = valor;
+        }
+    }
+    fclose(archivo);
+    
+    if(configuracion->multiplicador_naranja <= configuracion->multiplicador_amarilla) {
+        printf("%s: multiplicador_naranja debe ser mayor que multiplicador_amarilla\n", nombre_archivo);
+        errores++;
+    }
+    
+    // Los perfiles heredan los límites generales que no definen
+    for(int p = 0; p < configuracion->num_perfiles; p++) {
+        for(int c = 0; c < 4; c++) {
+            if(configuracion->perfiles[p].limites[c] < 0) {
+                configuracion->perfiles[p].limites[c] =
+                    *(float *)((char *)configuracion + CLAVES_CONFIGURACION[c].desplazamiento);
+            }
+        }
+    }
+    for(int z = 0; z < MAX_ZONAS; z++) {
+        configuracion->perfil_zona[z] = PERFIL_GENERAL;
+        if(perfiles_asignados[z][0] == '\0') continue;
+        for(int p = 0; p < configuracion->num_perfiles; p++) {
+            if(strcmp(configuracion->perfiles[p].nombre, perfiles_asignados[z]) == 0) {
+                configuracion->perfil_zona[z] = p + 1;
+            }
+        }
+        if(configuracion->perfil_zona[z] == PERFIL_GENERAL) {
+            printf("%s: la zona %d usa el perfil '%s', que no esta definido\n", nombre_archivo, z + 1,
+                   perfiles_asignados[z]);
+            errores++;
+        }
+    }
+    return errores;
+}
+
+// Arma una configuración nueva desde el archivo y la publica si no tiene errores.
+// Retorna 1 si se publicó; si no, la configuración vigente no cambia.
+int cargarConfiguracion(char *nombre_archivo) {
+    ConfiguracionSistema *nueva = malloc(sizeof(ConfiguracionSistema));
+    if(nueva == NULL) {
+        return 0;
+    }
+    *nueva = CONFIGURACION_POR_DEFECTO;
+    
+    int errores = leerArchivoConfiguracion(nombre_archivo, nueva);
+    if(errores != 0) {
+        if(errores < 0) {
+            printf("INFO: No se encontro %s; se mantienen los limites %s.\n", nombre_archivo,
+                   configuracion_vigente == &CONFIGURACION_POR_DEFECTO ? "por defecto" : "vigentes");
+        } else {
+            printf("ERROR: %d error(es) en %s; se mantienen los limites vigentes.\n", errores, nombre_archivo);
+        }
+        free(nueva);
+        return 0;
+    }
+    
+    const ConfiguracionSistema *anterior = configuracion_vigente;
+    configuracion_vigente = nueva;
+    if(anterior != &CONFIGURACION_POR_DEFECTO) {
+        free((void *)anterior);
+    }
+    return 1;
+}
+
+// Copia en la zona los límites de su perfil (o los generales), de modo que clasificar
+// una lectura sea comparar contra zona->limites[c] sin buscar el perfil
+void resolverLimitesZona(ZonaUrbana *zona) {
+    const ConfiguracionSistema *config = configuracionActual();
+    int perfil = PERFIL_GENERAL;
+    if(zona->id_zona >= 1 && zona->id_zona <= MAX_ZONAS) {
+        perfil = config->perfil_zona[zona->id_zona - 1];
+    }
+    for(int c = 0; c < 4; c++) {
+        zona->limites[c] = perfil == PERFIL_GENERAL ? obtenerLimiteOMS(c) : config->perfiles[perfil - 1].limites[c];
+    }
+    strcpy(zona->perfil, perfil == PERFIL_GENERAL ? "general" : config->perfiles[perfil - 1].nombre);
+}
+
+// Los mapas de excesos y los derivados dependen de los límites: se rehacen y se publican
+// instantáneas nuevas
+void aplicarConfiguracionZonas(ZonaUrbana zonas[]) {
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        if(zonas[i].id_zona == 0) continue;
+        resolverLimitesZona(&zonas[i]);
+        recalcularMapaExcesos(&zonas[i]);
+        invalidarDerivados(&zonas[i], TODOS_LOS_DERIVADOS);
+        if(zonas[i].dias_registrados > 0) {
+            publicarInstantaneaZona(&zonas[i]);
+        }
+    }
+}
+
+void recargarConfiguracion(ZonaUrbana zonas[]) {
+    if(cargarConfiguracion(ARCHIVO_CONFIGURACION)) {
+        aplicarConfiguracionZonas(zonas);
+        printf("Configuracion recargada desde %s.\n", ARCHIVO_CONFIGURACION);
+    }
+}
+
+// Manejador de SIGHUP: solo anota el pedido, la recarga se hace fuera de la señal
+void manejarSenalRecarga(int senal) {
+    recarga_configuracion_pendiente = 1;
+    signal(senal, manejarSenalRecarga);
+}
+
+// SIGHUP no existe en Windows: ahí la recarga se pide desde el menú
+void instalarRecargaConfiguracion(void) {
+#ifdef SIGHUP
+    signal(SIGHUP, manejarSenalRecarga);
+#endif
+}
+
+// Punto seguro del bucle principal para aplicar una recarga pedida con SIGHUP
+void atenderRecargaConfiguracion(ZonaUrbana zonas[]) {
+    if(recarga_configuracion_pendiente) {
+        recarga_configuracion_pendiente = 0;
+        printf("\nSIGHUP recibido: ");
+        recargarConfiguracion(zonas);
+    }
+}
+
+void mostrarConfiguracion(ZonaUrbana zonas[]) {
+    char respuesta;
+    
+    printf("\n=======================================================\n");
+    printf("            CONFIGURACION DE LIMITES Y ALERTAS         \n");
+    printf("=======================================================\n");
+    printf("Archivo: %s\n\n", ARCHIVO_CONFIGURACION);
+    
+    const ConfiguracionSistema *config = configuracionActual();
+    for(int k = 0; k < NUM_CLAVES_CONFIGURACION; k++) {
+        printf("%-26s %10.2f\n", CLAVES_CONFIGURACION[k].clave,
+               *(const float *)((const char *)config + CLAVES_CONFIGURACION[k].desplazamiento));
+    }
+    
+    printf("\nPERFILES DE UMBRALES (CO2 / SO2 / NO2 / PM2.5):\n");
+    if(config->num_perfiles == 0) {
+        printf("  (ninguno; todas las zonas usan los limites generales)\n");
+    }
+    for(int p = 0; p < config->num_perfiles; p++) {
+        printf("  %-20s %8.2f %8.2f %8.2f %8.2f\n", config->perfiles[p].nombre,
+               config->perfiles[p].limites[0], config->perfiles[p].limites[1],
+               config->perfiles[p].limites[2], config->perfiles[p].limites[3]);
+    }
+    printf("\nPERFIL POR ZONA:\n");
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        if(zonas[i].id_zona == 0) continue;
+        printf("  %-20s %s\n", zonas[i].nombre, zonas[i].perfil);
+    }
+#ifdef SIGHUP
+    printf("\nTambien se recarga al recibir SIGHUP.\n");
+#endif
+    
+    do {
+        printf("\n¿Recargar la configuracion ahora? (s/n): ");
+        scanf(" %c", &respuesta);
+        fflush(stdin);
+    } while(respuesta != 's' && respuesta != 'S' && respuesta != 'n' && respuesta != 'N');
+    if(respuesta == 's' || respuesta == 'S') {
+        recargarConfiguracion(zonas);
+    }
+    
+    printf("\nPresione Enter para continuar...");
+    getchar();
+}
+
+
+// ============= FUNCIONES DEL INDICE DE CALIDAD DEL AIRE (ICA) =============
+// Índice por tramos lineales de la EPA. Las tablas de SO2 y NO2 están en ppb y se
+// convierten desde ug/m3 a 25 °C; el CO2 no tiene índice oficial y no participa.
+
+static const TablaICA TABLAS_ICA[4][NUM_PERIODOS_ICA] = {
+    // CO2: sin tabla
+    {{{0}, {0}, {0}, {0}, 0, 1.0, 1.0}, {{0}, {0}, {0}, {0}, 0, 1.0, 1.0}},
+    // SO2 1 hora; sobre 304 ppb la EPA usa los cortes de 24 horas
+    {{{0, 36, 76, 186, 305, 605, CORTE_SIN_USO, CORTE_SIN_USO},
+      {35, 75, 185, 304, 604, 1004, CORTE_SIN_USO, CORTE_SIN_USO},
+      {0, 51, 101, 151, 201, 301, 0, 0},
+      {50, 100, 150, 200, 300, 500, 0, 0}, 6, 2.62, 1.0},
+    // SO2 24 horas
+     {{0, 35, 145, 225, 305, 605, 805, CORTE_SIN_USO},
+      {34, 144, 224, 304, 604, 804, 1004, CORTE_SIN_USO},
+      {0, 51, 101, 151, 201, 301, 401, 0},
+      {50, 100, 150, 200, 300, 400, 500, 0}, 7, 2.62, 1.0}},
+    // NO2 1 hora; no hay tabla de 24 horas
+    {{{0, 54, 101, 361, 650, 1250, CORTE_SIN_USO, CORTE_SIN_USO},
+      {53, 100, 360, 649, 1249, 2049, CORTE_SIN_USO, CORTE_SIN_USO},
+      {0, 51, 101, 151, 201, 301, 0, 0},
+      {50, 100, 150, 200, 300, 500, 0, 0}, 6, 1.88, 1.0},
+     {{0}, {0}, {0}, {0}, 0, 1.0, 1.0}},
+    // PM2.5 24 horas (revisión 2024); no hay tabla de 1 hora
+    {{{0}, {0}, {0}, {0}, 0, 1.0, 1.0},
+     {{0, 9.1, 35.5, 55.5, 125.5, 225.5, CORTE_SIN_USO, CORTE_SIN_USO},
+      {9.0, 35.4, 55.4, 125.4, 225.4, 325.4, CORTE_SIN_USO, CORTE_SIN_USO},
+      {0, 51, 101, 151, 201, 301, 0, 0},
+      {50, 100, 150, 200, 300, 500, 0, 0}, 6, 1.0, 0.1}}
+};
+
+static char *nombres_categoria_ica[NUM_CATEGORIAS_ICA] = {
+    "BUENO", "MODERADO", "DANINO PARA SENSIBLES", "DANINO", "MUY DANINO", "PELIGROSO"};
+static char *colores_categoria_ica[NUM_CATEGORIAS_ICA] = {
+    "VERDE", "AMARILLO", "NARANJA", "ROJO", "MORADO", "GRANATE"};
+
+// Tabla del periodo pedido; si el contaminante no tiene tabla para ese periodo se usa
+// la del otro (NO2 solo tiene 1 hora y PM2.5 solo 24 horas). NULL si no tiene ninguna.
+const TablaICA *tablaICA(int tipo_contaminante, int periodo) {
+    if(tipo_contaminante < 0 || tipo_contaminante > 3 || periodo < 0 || periodo >= NUM_PERIODOS_ICA) {
+        return NULL;
+    }
+    const TablaICA *tabla = &TABLAS_ICA[tipo_contaminante][periodo];
+    if(tabla->tramos == 0) {
+        tabla = &TABLAS_ICA[tipo_contaminante][1 - periodo];
+    }
+    return tabla->tramos > 0 ? tabla : NULL;
+}
+
+// Subíndice de una concentración en ug/m3. El tramo se busca con una búsqueda binaria
+// sin saltos: cada paso suma la mitad restante si el corte siguiente no supera el valor.
+int indiceDeTabla(const TablaICA *tabla, float concentracion) {
+    float c = concentracion / tabla->microgramos_por_unidad;
+    if(c < 0) c = 0;
+    // La EPA trunca (no redondea) a la resolución de la tabla; el margen evita que
+    // 9.1 / 0.1 = 90.99999 caiga en el tramo anterior
+    c = (long)(c / tabla->resolucion + 0.001) * tabla->resolucion;
+    
+    int k = 0;
+    for(int paso = TAM_TABLA_ICA / 2; paso > 0; paso /= 2) {
+        k += (tabla->concentracion_baja[k + paso] <= c) * paso;
+    }
+    
+    int ultimo = tabla->tramos - 1;
+    if(c > tabla->concentracion_alta[ultimo]) {
+        return ICA_MAXIMO; // Fuera de la escala
+    }
+    float indice = tabla->indice_bajo[k] + (tabla->indice_alto[k] - tabla->indice_bajo[k]) *
+                   (c - tabla->concentracion_baja[k]) /
+                   (tabla->concentracion_alta[k] - tabla->concentracion_baja[k]);
+    return (int)(indice + 0.5);
+}
+
+// Subíndices de una serie de concentraciones de un mismo contaminante (-1 sin tabla)
+void calcularICALote(const float *concentraciones, int cantidad, int tipo_contaminante, int periodo,
+                     short *indices) {
+    const TablaICA *tabla = tablaICA(tipo_contaminante, periodo);
+    if(tabla == NULL) {
+        for(int i = 0; i < cantidad; i++) indices[i] = -1;
+        return;
+    }
+    for(int i = 0; i < cantidad; i++) {
+        indices[i] = (short)indiceDeTabla(tabla, concentraciones[i]);
+    }
+}
+
+int categoriaICA(int indice) {
+    return (indice > 50) + (indice > 100) + (indice > 150) + (indice > 200) + (indice > 300);
+}
+
+const char *nombreCategoriaICA(int categoria) {
+    return nombres_categoria_ica[categoria];
+}
+
+const char *colorCategoriaICA(int categoria) {
+    return colores_categoria_ica[categoria];
+}
+
+void calcularICA(NivelesContaminacion niveles, int periodo, ResultadoICA *resultado) {
+    resultado->indice = 0;
+    resultado->contaminante_principal = -1;
+    for(int c = 0; c < 4; c++) {
+        const TablaICA *tabla = tablaICA(c, periodo);
+        int subindice = tabla != NULL ? indiceDeTabla(tabla, obtenerNivelContaminante(niveles, c)) : -1;
+        resultado->subindices[c] = subindice;
+        if(subindice > resultado->indice || (subindice >= 0 && resultado->contaminante_principal < 0)) {
+            resultado->indice = subindice;
+            resultado->contaminante_principal = c;
+        }
+    }
+    resultado->categoria = categoriaICA(resultado->indice);
+}
+
+// Exporta el ICA diario (24 horas) de todo el histórico en memoria de todas las zonas.
+// Cada zona se procesa por columnas: se juntan las concentraciones de cada contaminante
+// (SO2, NO2 y PM2.5) y los subíndices se calculan en lote antes de escribir las filas.
+// Devuelve las filas escritas o -1.
+int exportarSerieICA(ZonaUrbana zonas[], char *nombre_archivo) {
+    char *claves[] = {"co2", "so2", "no2", "pm25"};
+    ArenaTemporal *arena = arenaReportes();
+    int filas = 0;
+    
+    FILE *archivo = fopen(nombre_archivo, "w");
+    if(archivo == NULL) {
+        return -1;
+    }
+    BufferSalida salida;
+    iniciarBufferSalida(&salida, arena, TAM_BUFFER_SALIDA, archivo);
+    agregarTexto(&salida, "zona,fecha,ica_so2,ica_no2,ica_pm25,ica,principal,categoria\n");
+    
+    for(int z = 0; z < MAX_ZONAS; z++) {
+        ZonaUrbana *zona = &zonas[z];
+        int total = diasTotalesZona(zona);
+        if(zona->id_zona < 1 || total == 0) continue;
+        
+        // Del día más antiguo al más reciente, solo lecturas reales
+        MarcaArena marca = marcaArena(arena);
+        Fecha *fechas = reservarArena(arena, total * sizeof(Fecha));
+        float *valores = reservarArena(arena, 4 * total * sizeof(float));
+        short *indices = reservarArena(arena, 4 * total * sizeof(short));
+        if(fechas == NULL || valores == NULL || indices == NULL) {
+            restaurarArena(arena, marca);
+            filas = -1;
+            break;
+        }
+        int dias = 0;
+        for(int d = total - 1; d >= 0; d--) {
+            if(d < zona->dias_registrados && (diaImputado(zona, d) || diaDuplicado(zona, d))) continue;
+            RegistroHistorico registro = d < zona->dias_registrados ? registroDeZona(zona, d)
+                                                                      : registroHistoricoCompleto(zona, d);
+            fechas[dias] = registro.fecha;
+            for(int c = 1; c < 4; c++) {
+                valores[c * total + dias] = obtenerNivelContaminante(registro.niveles, c);
+            }
+            dias++;
+        }
+        for(int c = 1; c < 4; c++) {
+            calcularICALote(&valores[c * total], dias, c, PERIODO_ICA_24H, &indices[c * total]);
+        }
+        
+        for(int i = 0; i < dias; i++) {
+            int indice = 0, principal = 1;
+            for(int c = 1; c < 4; c++) {
+                if(indices[c * total + i] > indice) {
+                    indice = indices[c * total + i];
+                    principal = c;
+                }
+            }
+            agregarEntero(&salida, zona->id_zona, 0, ' ');
+            agregarTexto(&salida, ",");
+            agregarEntero(&salida, fechas[i].dia, 2, '0');
+            agregarTexto(&salida, "/");
+            agregarEntero(&salida, fechas[i].mes, 2, '0');
+            agregarTexto(&salida, "/");
+            agregarEntero(&salida, fechas[i].año, 4, '0');
+            for(int c = 1; c < 4; c++) {
+                agregarTexto(&salida, ",");
+                agregarEntero(&salida, indices[c * total + i], 0, ' ');
+            }
+            agregarTexto(&salida, ",");
+            agregarEntero(&salida, indice, 0, ' ');
+            agregarTexto(&salida, ",");
+            agregarTexto(&salida, claves[principal]);
+            agregarTexto(&salida, ",");
+            agregarTexto(&salida, nombreCategoriaICA(categoriaICA(indice)));
+            agregarTexto(&salida, "\n");
+            filas++;
+        }
+        restaurarArena(arena, marca);
+    }
+    vaciarBufferSalida(&salida);
+    if(fclose(archivo) != 0) {
+        filas = -1;
+    }
+    liberarArena(arena);
+    return filas;
+}
+
+// ============= FUNCIONES DE PRONOSTICO MULTI-HORIZONTE =============
+
+// Pronóstico a 24h, 48h, 72h y 7 días con el modelo de Holt ajustado de cada
+// contaminante (nivel + tendencia * días), ajustado por el clima predicho a 24h.
+// Retorna 1 si hay datos suficientes (3 días distintos), 0 en caso contrario.
+int calcularPronosticoMultiHorizonte(ZonaUrbana *zona, PronosticoZona *pronostico) {
+    const int horizontes[NUM_HORIZONTES] = {1, 2, 3, MAX_HORIZONTE_DIAS};
+    
+    memset(pronostico, 0, sizeof(PronosticoZona));
+    pronostico->zona_id = zona->id_zona;
+    for(int h = 0; h < NUM_HORIZONTES; h++) {
+        pronostico->dias_horizonte[h] = horizontes[h];
+    }
+    
+    // Los registros repetidos de una misma fecha no cuentan como días distintos
+    int num_dias = 0;
+    for(int i = 0; i < zona->dias_registrados && num_dias < 3; i++) {
+        if(!diaDuplicado(zona, i)) num_dias++;
+    }
+    if(num_dias < 3) {
+        return 0;
+    }
+    if(!zona->modelos_ajustados) {
+        ajustarModelosZona(zona);
+    }
+    
+    // El clima predicho a 24h se mantiene para todo el horizonte
+    pronostico->clima_predicho = predecirClima24h(zona);
+    float factor_clima = ajustarPorClima(1.0, pronostico->clima_predicho);
+    
+    for(int h = 0; h < NUM_HORIZONTES; h++) {
+        int alerta = ALERTA_VERDE;
+        for(int c = 0; c < 4; c++) {
+            pronostico->niveles[h][c] = pronosticoHolt(&zona->modelos[c], horizontes[h], NULL) * factor_clima;
+            int alerta_c = determinarNivelAlerta(pronostico->niveles[h][c], zona->limites[c]);
+            if(alerta_c > alerta) alerta = alerta_c;
+        }
+        pronostico->nivel_alerta[h] = alerta;
+    }
+    return 1;
+}
+
+// Calcula el pronóstico de todas las zonas con datos suficientes.
+// Retorna el número de zonas pronosticadas.
+int calcularPronosticoTodasLasZonas(ZonaUrbana zonas[], PronosticoZona pronosticos[]) {
+    int zonas_pronosticadas = 0;
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        const PronosticoZona *pronostico = obtenerPronosticoZona(&zonas[i]);
+        if(pronostico != NULL) {
+            pronosticos[i] = *pronostico;
+            zonas_pronosticadas++;
+        } else {
+            memset(&pronosticos[i], 0, sizeof(PronosticoZona));
+            pronosticos[i].zona_id = zonas[i].id_zona;
+        }
+    }
+    return zonas_pronosticadas;
+}
+
+// ================ FUNCIONES PARA VALORES DERIVADOS ================
+// Promedios, estadísticas, pronóstico y alertas de cada zona se guardan en la zona y se
+// recalculan solo al pedirlos después de un cambio en los datos de los que dependen.
+// Un día nuevo invalida todo; corregir un día solo invalida los derivados que lo leyeron.
+
+static const NodoDerivado GRAFO_DERIVADOS[NUM_DERIVADOS] = {
+    {ENTRADA_CONTAMINANTES, 0},                               // DERIVADO_PROMEDIO_30
+    {ENTRADA_CONTAMINANTES, 0},                               // DERIVADO_ESTADISTICAS
+    {ENTRADA_CONTAMINANTES | ENTRADA_CLIMA, 0},               // DERIVADO_PRONOSTICO
+    {ENTRADA_CONTAMINANTES, 1 << DERIVADO_PRONOSTICO},        // DERIVADO_ALERTAS
+};
+
+// Marca los derivados indicados y, en cadena, todos los que dependen de ellos
+void invalidarDerivados(ZonaUrbana *zona, int derivados) {
+    int pendientes = zona->derivados_pendientes | derivados;
+    int anteriores;
+    do {
+        anteriores = pendientes;
+        for(int n = 0; n < NUM_DERIVADOS; n++) {
+            if(GRAFO_DERIVADOS[n].depende_de & pendientes) {
+                pendientes |= 1 << n;
+            }
+        }
+    } while(pendientes != anteriores);
+    zona->derivados_pendientes = pendientes;
+}
+
+// Un día de la ventana cambió en sus contaminantes y/o su clima
+void registrarCambioDia(ZonaUrbana *zona, int dia, int entradas) {
+    int afectados = 0;
+    for(int n = 0; n < NUM_DERIVADOS; n++) {
+        if((GRAFO_DERIVADOS[n].entradas & entradas) && dia < zona->alcance_derivados[n]) {
+            afectados |= 1 << n;
+        }
+    }
+    invalidarDerivados(zona, afectados);
+}
+
+// Promedio de las últimas DIAS_PROMEDIO_MOVIL lecturas propias de la ventana (días
+// distintos, sin imputados)
+const float *obtenerPromedio30Dias(ZonaUrbana *zona) {
+    if(zona->derivados_pendientes & (1 << DERIVADO_PROMEDIO_30)) {
+        float suma[4] = {0.0, 0.0, 0.0, 0.0};
+        int dias = 0, i;
+        for(i = 0; i < zona->dias_registrados && dias < DIAS_PROMEDIO_MOVIL; i++) {
+            if(diaExcluidoDeAnalisis(zona, i)) continue;
+            for(int c = 0; c < 4; c++) {
+                suma[c] += obtenerNivelContaminante(zona->historico[i], c);
+            }
+            dias++;
+        }
+        for(int c = 0; c < 4; c++) {
+            zona->promedio_30_dias[c] = dias > 0 ? suma[c] / dias : 0.0;
+        }
+        zona->alcance_derivados[DERIVADO_PROMEDIO_30] = i;
+        zona->derivados_pendientes &= ~(1 << DERIVADO_PROMEDIO_30);
+    }
+    return zona->promedio_30_dias;
+}
+
+// Promedio, máximo y mínimo de las lecturas propias de la ventana (sin días
+// imputados ni duplicados)
+const EstadisticasVentana *obtenerEstadisticasVentana(ZonaUrbana *zona) {
+    if(zona->derivados_pendientes & (1 << DERIVADO_ESTADISTICAS)) {
+        EstadisticasVentana *estadisticas = &zona->estadisticas;
+        float suma[4] = {0.0, 0.0, 0.0, 0.0};
+        int dias = 0;
+        for(int c = 0; c < 4; c++) {
+            estadisticas->maximo[c] = 0.0;
+            estadisticas->minimo[c] = 999999;
+        }
+        for(int i = 0; i < zona->dias_registrados; i++) {
+            if(diaExcluidoDeAnalisis(zona, i)) continue;
+            dias++;
+            for(int c = 0; c < 4; c++) {
+                float valor = obtenerNivelContaminante(zona->historico[i], c);
+                suma[c] += valor;
+                if(valor > estadisticas->maximo[c]) estadisticas->maximo[c] = valor;
+                if(valor < estadisticas->minimo[c]) estadisticas->minimo[c] = valor;
+            }
+        }
+        for(int c = 0; c < 4; c++) {
+            estadisticas->promedio[c] = dias > 0 ? suma[c] / dias : 0.0;
+        }
+        zona->alcance_derivados[DERIVADO_ESTADISTICAS] = zona->dias_registrados;
+        zona->derivados_pendientes &= ~(1 << DERIVADO_ESTADISTICAS);
+    }
+    return &zona->estadisticas;
+}
+
+// Pronóstico multi-horizonte de la zona; NULL si no hay 3 días distintos
+const PronosticoZona *obtenerPronosticoZona(ZonaUrbana *zona) {
+    if(zona->derivados_pendientes & (1 << DERIVADO_PRONOSTICO)) {
+        zona->pronostico_disponible = calcularPronosticoMultiHorizonte(zona, &zona->pronostico);
+        zona->alcance_derivados[DERIVADO_PRONOSTICO] = zona->dias_registrados;
+        zona->derivados_pendientes &= ~(1 << DERIVADO_PRONOSTICO);
+    }
+    return zona->pronostico_disponible ? &zona->pronostico : NULL;
+}
+
+// Alertas de los niveles actuales (historico[0]) y alerta pronosticada a 24h
+const AlertasZona *obtenerAlertasZona(ZonaUrbana *zona) {
+    if(zona->derivados_pendientes & (1 << DERIVADO_ALERTAS)) {
+        AlertasZona *alertas = &zona->alertas;
+        alertas->general = ALERTA_VERDE;
+        for(int c = 0; c < 4; c++) {
+            alertas->nivel[c] = determinarNivelAlerta(obtenerNivelContaminante(zona->niveles_actuales, c), zona->limites[c]);
+            if(alertas->nivel[c] > alertas->general) alertas->general = alertas->nivel[c];
+        }
+        calcularICA(zona->niveles_actuales, PERIODO_ICA_24H, &alertas->ica);
+        
+        const PronosticoZona *pronostico = obtenerPronosticoZona(zona);
+        alertas->general_24h = pronostico != NULL ? pronostico->nivel_alerta[0] : -1;
+        zona->alcance_derivados[DERIVADO_ALERTAS] = 1;
+        zona->derivados_pendientes &= ~(1 << DERIVADO_ALERTAS);
+    }
+    return &zona->alertas;
+}
+
+void pronosticoMultiHorizonte(ZonaUrbana zonas[]) {
+    PronosticoZona pronosticos[MAX_ZONAS];
+    char *niveles[] = {"VERDE", "AMARILLO", "NARANJA", "ROJO"};
+    char *etiquetas[] = {"24h", "48h", "72h", "7d"};
+    
+    printf("\n=======================================================\n");
+    printf("        PRONOSTICO MULTI-DIA (24h, 48h, 72h, 7d)       \n");
+    printf("=======================================================\n");
+    
+    clock_t inicio = clock();
+    int zonas_pronosticadas = calcularPronosticoTodasLasZonas(zonas, pronosticos);
+    double milisegundos = (double)(clock() - inicio) * 1000.0 / CLOCKS_PER_SEC;
+    
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        printf("\n%s (ID: %d)\n", zonas[i].nombre, zonas[i].id_zona);
+        printf("-------------------------------------------------------\n");
+        
+        if(zonas[i].dias_registrados < 3) {
+            printf("Datos insuficientes (se requieren al menos 3 dias).\n");
+            continue;
+        }
+        
+        printf("Horizonte | CO2    | SO2    | NO2    | PM2.5  | Alerta\n");
+        for(int h = 0; h < NUM_HORIZONTES; h++) {
+            printf("%-9s | %-6.1f | %-6.1f | %-6.1f | %-6.1f | %s\n",
+                   etiquetas[h],
+                   pronosticos[i].niveles[h][0], pronosticos[i].niveles[h][1],
+                   pronosticos[i].niveles[h][2], pronosticos[i].niveles[h][3],
+                   niveles[pronosticos[i].nivel_alerta[h]]);
+        }
+    }
+    
+    printf("\n%d zona(s) pronosticadas en %.3f ms\n", zonas_pronosticadas, milisegundos);
+    printf("=======================================================\n");
+    
+    printf("\nPresione Enter para continuar...");
+    getchar();
+}
+
+// ============= FUNCIONES DEL MODELO ESTADISTICO (HOLT) =============
+
+// Rejilla de parámetros: el candidato k usa alfa[k / NUM_CANDIDATOS_BETA] y beta[k % NUM_CANDIDATOS_BETA]
+static const float ALFAS_HOLT[NUM_CANDIDATOS_ALFA] = {0.1, 0.3, 0.5, 0.7, 0.9};
+static const float BETAS_HOLT[NUM_CANDIDATOS_BETA] = {0.05, 0.1, 0.2, 0.3, 0.5};
+
+// Incorpora una nueva lectura al modelo en O(candidatos), sin recorrer el histórico.
+// Cada candidato acumula su error de predicción a 1 día y el modelo usa el menor.
+void actualizarModeloHolt(ModeloHolt *modelo, float valor) {
+    if(modelo->observaciones == 0) {
+        for(int k = 0; k < NUM_CANDIDATOS_HOLT; k++) {
+            modelo->candidatos[k].nivel = valor;
+            modelo->candidatos[k].tendencia = 0.0;
+            modelo->candidatos[k].error_cuadratico = 0.0;
+        }
+        modelo->mejor = 0;
+    } else if(modelo->observaciones == 1) {
+        // Con la segunda lectura se inicializa la tendencia
+        for(int k = 0; k < NUM_CANDIDATOS_HOLT; k++) {
+            modelo->candidatos[k].tendencia = valor - modelo->candidatos[k].nivel;
+            modelo->candidatos[k].nivel = valor;
+        }
+    } else {
+        // Media móvil exponencial del error con ventana VENTANA_ERROR_HOLT
+        int errores = modelo->observaciones - 1;
+        float peso_error = 1.0 / (errores < VENTANA_ERROR_HOLT ? errores : VENTANA_ERROR_HOLT);
+        
+        for(int k = 0; k < NUM_CANDIDATOS_HOLT; k++) {
+            EstadoHolt *estado = &modelo->candidatos[k];
+            float alfa = ALFAS_HOLT[k / NUM_CANDIDATOS_BETA];
+            float beta = BETAS_HOLT[k % NUM_CANDIDATOS_BETA];
+            
+            float prediccion = estado->nivel + estado->tendencia;
+            float error = valor - prediccion;
+            float nivel_anterior = estado->nivel;
+            
+            estado->nivel = alfa * valor + (1 - alfa) * prediccion;
+            estado->tendencia = beta * (estado->nivel - nivel_anterior) + (1 - beta) * estado->tendencia;
+            estado->error_cuadratico += (error * error - estado->error_cuadratico) * peso_error;
+        }
+        
+        int mejor = 0;
+        for(int k = 1; k < NUM_CANDIDATOS_HOLT; k++) {
+            if(modelo->candidatos[k].error_cuadratico < modelo->candidatos[mejor].error_cuadratico) {
+                mejor = k;
+            }
+        }
+        modelo->mejor = mejor;
+    }
+    modelo->observaciones++;
+}
+
+// Ajuste completo con todo el histórico (del día más antiguo al más reciente).
+// Solo se usa cuando no hay modelo guardado o el histórico fue corregido. El modelo
+// se deriva de los datos: no marca la zona como modificada (se guarda con el próximo
+// cambio de datos y, si no, se vuelve a ajustar al cargar).
+void ajustarModelosZona(ZonaUrbana *zona) {
+    memset(zona->modelos, 0, sizeof(zona->modelos));
+    
+    for(int i = zona->dias_registrados - 1; i >= 0; i--) {
+        if(diaExcluidoDeAnalisis(zona, i)) continue;
+        actualizarModeloHolt(&zona->modelos[0], zona->historico[i].co2);
+        actualizarModeloHolt(&zona->modelos[1], zona->historico[i].so2);
+        actualizarModeloHolt(&zona->modelos[2], zona->historico[i].no2);
+        actualizarModeloHolt(&zona->modelos[3], zona->historico[i].pm25);
+    }
+    zona->modelos_ajustados = 1;
+}
+
+// Actualiza los modelos con una lectura nueva que ya está en historico[0]
+void actualizarModelosZona(ZonaUrbana *zona, NivelesContaminacion niveles) {
+    if(!zona->modelos_ajustados) {
+        ajustarModelosZona(zona);
+        return;
+    }
+    actualizarModeloHolt(&zona->modelos[0], niveles.co2);
+    actualizarModeloHolt(&zona->modelos[1], niveles.so2);
+    actualizarModeloHolt(&zona->modelos[2], niveles.no2);
+    actualizarModeloHolt(&zona->modelos[3], niveles.pm25);
+}
+
+// Pronóstico a 'dias' días del mejor candidato. La desviación del error crece con la
+// raíz del horizonte a partir del error cuadrático medio a 1 día.
+float pronosticoHolt(ModeloHolt *modelo, int dias, float *desviacion) {
+    EstadoHolt *estado = &modelo->candidatos[modelo->mejor];
+    
+    if(desviacion != NULL) {
+        *desviacion = raizCuadrada(estado->error_cuadratico * dias);
+    }
+    float prediccion = estado->nivel + estado->tendencia * dias;
+    return prediccion > 0 ? prediccion : 0.0;
+}
+
+// Probabilidad de que el valor real supere el límite, suponiendo error normal
+float probabilidadExceder(float prediccion, float desviacion, float limite) {
+    if(desviacion <= 0) {
+        return prediccion > limite ? 1.0 : 0.0;
+    }
+    return 1.0 - normalAcumulada((limite - prediccion) / desviacion);
+}
+
+void mostrarModeloEstadistico(ZonaUrbana zonas[]) {
+    char *nombres_cont[] = {"CO2", "SO2", "NO2", "PM2.5"};
+    
+    printf("\n=======================================================\n");
+    printf("        MODELO ESTADISTICO (SUAVIZADO DE HOLT)         \n");
+    printf("=======================================================\n");
+    
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        ZonaUrbana *zona = &zonas[i];
+        printf("\n%s (ID: %d)\n", zona->nombre, zona->id_zona);
+        printf("-------------------------------------------------------\n");
+        
+        if(zona->dias_registrados < 3) {
+            printf("Datos insuficientes (se requieren al menos 3 dias).\n");
+            continue;
+        }
+        if(!zona->modelos_ajustados) {
+            ajustarModelosZona(zona);
+        }
+        
+        printf("Contam. | Alfa | Beta | Pred. 24h | Intervalo 95%%     | P(exceder)\n");
+        for(int c = 0; c < 4; c++) {
+            ModeloHolt *modelo = &zona->modelos[c];
+            float desviacion;
+            float prediccion = pronosticoHolt(modelo, 1, &desviacion);
+            float inferior = prediccion - 1.96 * desviacion;
+            if(inferior < 0) inferior = 0;
+            
+            printf("%-7s | %.2f | %.2f | %9.1f | %7.1f - %-7.1f | %5.1f%%\n",
+                   nombres_cont[c],
+                   ALFAS_HOLT[modelo->mejor / NUM_CANDIDATOS_BETA],
+                   BETAS_HOLT[modelo->mejor % NUM_CANDIDATOS_BETA],
+                   prediccion, inferior, prediccion + 1.96 * desviacion,
+                   probabilidadExceder(prediccion, desviacion, zona->limites[c]) * 100);
+        }
+    }
+    
+    // Comparación del costo de ajuste: promedio ponderado vs. Holt (completo e incremental)
+    const int repeticiones = 1000;
+    ZonaUrbana *zona_prueba = NULL;
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        if(zonas[i].dias_registrados >= 3 &&
+           (zona_prueba == NULL || zonas[i].dias_registrados > zona_prueba->dias_registrados)) {
+            zona_prueba = &zonas[i];
+        }
+    }
+    
+    if(zona_prueba != NULL) {
+        ArenaTemporal *arena = arenaReportes();
+        float *hist_co2 = reservarArena(arena, MAX_DIAS_HISTORICOS * sizeof(float));
+        ModeloHolt copia;
+        volatile float sumidero = 0;
+        int n = zona_prueba->dias_registrados;
+        
+        clock_t inicio = clock();
+        for(int r = 0; r < repeticiones; r++) {
+            for(int i = 0; i < n; i++) hist_co2[i] = zona_prueba->historico[n - 1 - i].co2;
+            sumidero += calcularPrediccion(hist_co2, n);
+        }
+        double us_ponderado = (double)(clock() - inicio) * 1e6 / CLOCKS_PER_SEC / repeticiones;
+        
+        inicio = clock();
+        for(int r = 0; r < repeticiones; r++) {
+            memset(&copia, 0, sizeof(copia));
+            for(int i = n - 1; i >= 0; i--) actualizarModeloHolt(&copia, zona_prueba->historico[i].co2);
+            sumidero += pronosticoHolt(&copia, 1, NULL);
+        }
+        double us_holt_completo = (double)(clock() - inicio) * 1e6 / CLOCKS_PER_SEC / repeticiones;
+        
+        inicio = clock();
+        for(int r = 0; r < repeticiones; r++) {
+            actualizarModeloHolt(&copia, zona_prueba->historico[r % n].co2);
+        }
+        double us_holt_incremental = (double)(clock() - inicio) * 1e6 / CLOCKS_PER_SEC / repeticiones;
+        
+        printf("\nCOSTO DE AJUSTE POR CONTAMINANTE (%s, %d dias):\n", zona_prueba->nombre, n);
+        printf("  Promedio ponderado (recalculo):   %8.3f us\n", us_ponderado);
+        printf("  Holt, ajuste completo:            %8.3f us\n", us_holt_completo);
+        printf("  Holt, actualizacion incremental:  %8.3f us\n", us_holt_incremental);
+        liberarArena(arena);
+    }
+    
+    printf("=======================================================\n");
+    printf("\nPresione Enter para continuar...");
+    getchar();
+}
+
+// ============= FUNCIONES DE DETECCION DE ANOMALIAS =============
+
+// Incorpora una lectura a la ventana: la más antigua sale del anillo y la copia
+// ordenada se corrige desplazando solo los valores entre la que sale y la que entra
+void agregarLecturaDetector(DetectorAnomalias *detector, float valor) {
+    int posicion;
+    
+    if(detector->cantidad > 0 && valor == detector->ultima_lectura) {
+        detector->lecturas_iguales++;
+    } else {
+        detector->lecturas_iguales = 1;
+    }
+    detector->ultima_lectura = valor;
+    
+    if(detector->cantidad < VENTANA_ANOMALIAS) {
+        detector->valores[(detector->inicio + detector->cantidad) % VENTANA_ANOMALIAS] = valor;
+        posicion = detector->cantidad++;
+    } else {
+        float saliente = detector->valores[detector->inicio];
+        detector->valores[detector->inicio] = valor;
+        detector->inicio = (detector->inicio + 1) % VENTANA_ANOMALIAS;
+        detector->suma -= saliente;
+        detector->suma_cuadrados -= (double)saliente * saliente;
+        
+        posicion = 0;
+        while(detector->ordenados[posicion] != saliente) posicion++;
+    }
+    
+    // El hueco en 'posicion' se mueve hasta el lugar que le corresponde a la nueva lectura
+    while(posicion > 0 && detector->ordenados[posicion - 1] > valor) {
+        detector->ordenados[posicion] = detector->ordenados[posicion - 1];
+        posicion--;
+    }
+    while(posicion < detector->cantidad - 1 && detector->ordenados[posicion + 1] < valor) {
+        detector->ordenados[posicion] = detector->ordenados[posicion + 1];
+        posicion++;
+    }
+    detector->ordenados[posicion] = valor;
+    
+    detector->suma += valor;
+    detector->suma_cuadrados += (double)valor * valor;
+}
+
+float medianaDetector(DetectorAnomalias *detector) {
+    int n = detector->cantidad;
+    if(n == 0) return 0.0;
+    if(n % 2 == 1) return detector->ordenados[n / 2];
+    return (detector->ordenados[n / 2 - 1] + detector->ordenados[n / 2]) / 2;
+}
+
+// Mediana de las desviaciones absolutas respecto de 'mediana'. Las desviaciones de
+// los valores menores y mayores ya están ordenadas, así que basta con mezclarlas.
+float madDetector(DetectorAnomalias *detector, float mediana) {
+    int n = detector->cantidad;
+    if(n == 0) return 0.0;
+    
+    int derecha = 0;
+    while(derecha < n && detector->ordenados[derecha] < mediana) derecha++;
+    int izquierda = derecha - 1;
+    
+    float central_inferior = 0.0, central_superior = 0.0;
+    for(int k = 0; k <= n / 2; k++) {
+        float desviacion;
+        if(derecha >= n || (izquierda >= 0 &&
+           mediana - detector->ordenados[izquierda] <= detector->ordenados[derecha] - mediana)) {
+            desviacion = mediana - detector->ordenados[izquierda--];
+        } else {
+            desviacion = detector->ordenados[derecha++] - mediana;
+        }
+        if(k == (n - 1) / 2) central_inferior = desviacion;
+        if(k == n / 2) central_superior = desviacion;
+    }
+    return (central_inferior + central_superior) / 2;
+}
+
+// Evalúa una lectura con la ventana anterior a ella (sin incorporarla). Devuelve el
+// tipo de anomalía o 0. Se usa el z robusto (0.6745 * desviación / MAD); si más de
+// la mitad de la ventana es igual la MAD es cero y se usa el z con media y desviación.
+int evaluarLecturaDetector(DetectorAnomalias *detector, float valor, AnomaliaDetectada *anomalia) {
+    int n = detector->cantidad;
+    
+    anomalia->tipo = 0;
+    anomalia->valor = valor;
+    anomalia->mediana = medianaDetector(detector);
+    anomalia->mad = madDetector(detector, anomalia->mediana);
+    anomalia->z = 0.0;
+    anomalia->lecturas_iguales = (n > 0 && valor == detector->ultima_lectura) ? detector->lecturas_iguales + 1 : 1;
+    
+    if(anomalia->lecturas_iguales >= DIAS_SENSOR_PLANO) {
+        anomalia->tipo = ANOMALIA_SENSOR_PLANO;
+        return anomalia->tipo;
+    }
+    if(n < MIN_LECTURAS_ANOMALIA) {
+        return 0;
+    }
+    
+    if(anomalia->mad > 0) {
+        anomalia->z = 0.6745 * (valor - anomalia->mediana) / anomalia->mad;
+        if(absoluto(anomalia->z) > UMBRAL_Z_ROBUSTO) anomalia->tipo = ANOMALIA_ATIPICA;
+    } else {
+        double media = detector->suma / n;
+        double varianza = detector->suma_cuadrados / n - media * media;
+        if(varianza > 0) {
+            anomalia->z = (valor - media) / raizCuadrada(varianza);
+            if(absoluto(anomalia->z) > UMBRAL_Z_CLASICO) anomalia->tipo = ANOMALIA_ATIPICA;
+        }
+    }
+    return anomalia->tipo;
+}
+
+// Prepara los detectores con las lecturas de la ventana a partir del día 'desde'
+// (las VENTANA_ANOMALIAS más recientes, de la más antigua a la más nueva), sin los
+// días imputados ni duplicados
+void prepararDetectoresZona(ZonaUrbana *zona, int desde) {
+    int dias[VENTANA_ANOMALIAS];
+    int num_dias = 0;
+    memset(zona->detectores, 0, sizeof(zona->detectores));
+    
+    for(int i = desde; i < zona->dias_registrados && num_dias < VENTANA_ANOMALIAS; i++) {
+        if(!diaExcluidoDeAnalisis(zona, i)) dias[num_dias++] = i;
+    }
+    for(int d = num_dias - 1; d >= 0; d--) {
+        int i = dias[d];
+        agregarLecturaDetector(&zona->detectores[0], zona->historico[i].co2);
+        agregarLecturaDetector(&zona->detectores[1], zona->historico[i].so2);
+        agregarLecturaDetector(&zona->detectores[2], zona->historico[i].no2);
+        agregarLecturaDetector(&zona->detectores[3], zona->historico[i].pm25);
+    }
+    zona->detectores_listos = 1;
+}
+
+// Agrega las anomalías de una lectura al final de ARCHIVO_ANOMALIAS
+void registrarAnomaliasEnLog(ZonaUrbana *zona, Fecha fecha, AnomaliaDetectada anomalias[], int num_anomalias) {
+    char *nombres_cont[] = {"CO2", "SO2", "NO2", "PM2.5"};
+    FILE *log = fopen(ARCHIVO_ANOMALIAS, "a");
+    if(log == NULL) {
+        printf("ADVERTENCIA: No se pudo abrir %s para registrar las anomalias.\n", ARCHIVO_ANOMALIAS);
+        return;
+    }
+    
+    for(int i = 0; i < num_anomalias; i++) {
+        AnomaliaDetectada *anomalia = &anomalias[i];
+        fprintf(log, "%02d/%02d/%04d | %-20s | %-5s | ", fecha.dia, fecha.mes, fecha.año,
+                zona->nombre, nombres_cont[anomalia->contaminante]);
+        if(anomalia->tipo == ANOMALIA_SENSOR_PLANO) {
+            fprintf(log, "SENSOR PLANO | valor %.1f repetido %d lecturas seguidas\n",
+                    anomalia->valor, anomalia->lecturas_iguales);
+        } else {
+            fprintf(log, "ATIPICO      | valor %.1f, mediana %.1f, MAD %.1f, z %.2f\n",
+                    anomalia->valor, anomalia->mediana, anomalia->mad, anomalia->z);
+        }
+    }
+    fclose(log);
+}
+
+// Evalúa la lectura recién registrada en historico[0] y la incorpora a los detectores
+// en O(VENTANA_ANOMALIAS), sin recorrer el histórico. Devuelve el número de anomalías.
+int detectarAnomaliasZona(ZonaUrbana *zona) {
+    char *nombres_cont[] = {"CO2", "SO2", "NO2", "PM2.5"};
+    NivelesContaminacion *niveles = &zona->historico[0];
+    float valores[4] = {niveles->co2, niveles->so2, niveles->no2, niveles->pm25};
+    AnomaliaDetectada anomalias[4];
+    int num_anomalias = 0;
+    
+    if(!zona->detectores_listos) {
+        prepararDetectoresZona(zona, 1);
+    }
+    
+    for(int c = 0; c < 4; c++) {
+        if(evaluarLecturaDetector(&zona->detectores[c], valores[c], &anomalias[num_anomalias])) {
+            anomalias[num_anomalias].contaminante = c;
+            num_anomalias++;
+        }
+        agregarLecturaDetector(&zona->detectores[c], valores[c]);
+    }
+    
+    if(num_anomalias > 0) {
+        registrarAnomaliasEnLog(zona, zona->historico_fechas[0].fecha, anomalias, num_anomalias);
+        for(int i = 0; i < num_anomalias; i++) {
+            if(anomalias[i].tipo == ANOMALIA_SENSOR_PLANO) {
+                printf("ADVERTENCIA: %s repite %.1f por %d lecturas seguidas (posible sensor trabado).\n",
+                       nombres_cont[anomalias[i].contaminante], anomalias[i].valor, anomalias[i].lecturas_iguales);
+            } else {
+                printf("ADVERTENCIA: %s = %.1f es atipico (mediana reciente %.1f, z = %.1f).\n",
+                       nombres_cont[anomalias[i].contaminante], anomalias[i].valor,
+                       anomalias[i].mediana, anomalias[i].z);
+            }
+        }
+        printf("Anomalias registradas en %s para revision.\n", ARCHIVO_ANOMALIAS);
+    }
+    return num_anomalias;
+}
+
+// ============= FUNCIONES DE EVALUACION DEL PRONOSTICO (BACKTEST) =============
+
+// Conjuntos de pesos comparados; el primero es el del sistema (PESO_DIA_1..PESO_RESTO)
+static const PesosPrediccion CONJUNTOS_PESOS[NUM_CONJUNTOS_PESOS] = {
+    {PESO_DIA_1, PESO_DIA_2, PESO_DIA_3, PESO_RESTO},
+    {0.50, 0.30, 0.15, 0.05},
+    {0.60, 0.25, 0.10, 0.05},
+    {0.25, 0.25, 0.25, 0.25},
+    {0.30, 0.20, 0.10, 0.40},
+    {1.00, 0.00, 0.00, 0.00}   // Persistencia: mañana igual que hoy
+};
+
+// Recorre todo el histórico de la zona (archivado y ventana) del día más antiguo al más
+// reciente: con los datos hasta el día t predice el día t+1 (promedio ponderado + ajuste
+// por el clima predicho con los mismos datos) y lo compara con el valor registrado.
+// Los días imputados o duplicados no se usan ni para predecir ni como valor real.
+// Las ventanas de contaminantes y clima se desplazan en O(1) por día.
+void ejecutarBacktestZona(ZonaUrbana *zona, ResultadoBacktest *resultado) {
+    int total = diasTotalesZona(zona);
+    
+    // Canales 0-3: contaminantes (pesos evaluados); 4-7: clima (pesos del sistema)
+    float reciente_1[8], reciente_2[8], reciente_3[8], suma_resto[8];
+    float peso_1[8], peso_2[8], peso_3[8], peso_r[8];
+    
+    for(int c = 0; c < 8; c++) {
+        PesosPrediccion pesos = (c < 4) ? resultado->pesos : CONJUNTOS_PESOS[0];
+        peso_1[c] = pesos.dia_1;
+        peso_2[c] = pesos.dia_2;
+        peso_3[c] = pesos.dia_3;
+        peso_r[c] = pesos.resto;
+        suma_resto[c] = 0.0;
+    }
+    
+    float normalizar_clima = 1.0 / (PESO_DIA_1 + PESO_DIA_2 + PESO_DIA_3);
+    int dias_vistos = 0;
+    
+    // El índice total - 1 es el primer día registrado
+    for(int indice = total - 1; indice >= 0; indice--) {
+        if(diaExcluidoDeAnalisis(zona, indice)) continue;
+        
+        RegistroHistorico registro = registroHistoricoCompleto(zona, indice);
+        float real[8] = {registro.niveles.co2, registro.niveles.so2, registro.niveles.no2,
+                         registro.niveles.pm25, registro.clima.temperatura,
+                         registro.clima.velocidad_viento, registro.clima.humedad,
+                         registro.clima.presion_atmosferica};
+        
+        // Se necesitan 3 días para predecir el siguiente
+        if(dias_vistos >= 3) {
+            int dias_resto = dias_vistos - 3;
+            float prediccion[8];
+            
+            for(int c = 0; c < 8; c++) {
+                prediccion[c] = reciente_1[c] * peso_1[c] + reciente_2[c] * peso_2[c] +
+                                reciente_3[c] * peso_3[c];
+                if(dias_resto > 0) {
+                    prediccion[c] += suma_resto[c] / dias_resto * peso_r[c];
+                }
+            }
+            if(dias_resto == 0) {
+                for(int c = 4; c < 8; c++) prediccion[c] *= normalizar_clima;
+            }
+            
+            DatosClimaticos clima_predicho;
+            clima_predicho.temperatura = prediccion[4];
+            clima_predicho.velocidad_viento = prediccion[5];
+            clima_predicho.humedad = prediccion[6];
+            clima_predicho.presion_atmosferica = prediccion[7];
+            float factor_clima = ajustarPorClima(1.0, clima_predicho);
+            
+            for(int c = 0; c < 4; c++) {
+                float predicho = prediccion[c] * factor_clima;
+                float error = predicho - real[c];
+                
+                resultado->predicciones[c]++;
+                resultado->suma_error_absoluto[c] += absoluto(error);
+                resultado->suma_error_cuadratico[c] += error * error;
+                resultado->confusion[c][determinarNivelAlerta(real[c], zona->limites[c])]
+                                       [determinarNivelAlerta(predicho, zona->limites[c])]++;
+            }
+        }
+        
+        // Desplazar la ventana con el valor real del día
+        for(int c = 0; c < 8; c++) {
+            if(dias_vistos >= 3) suma_resto[c] += reciente_3[c];
+            reciente_3[c] = reciente_2[c];
+            reciente_2[c] = reciente_1[c];
+            reciente_1[c] = real[c];
+        }
+        dias_vistos++;
+    }
+}
+
+void evaluarPronosticoHistorico(ZonaUrbana zonas[]) {
+    ResultadoBacktest resultados[NUM_CONJUNTOS_PESOS];
+    char *nombres_cont[] = {"CO2", "SO2", "NO2", "PM2.5"};
+    char *niveles[] = {"VERDE", "AMARILLO", "NARANJA", "ROJO"};
+    
+    printf("\n=======================================================\n");
+    printf("      EVALUACION DEL PRONOSTICO SOBRE EL HISTORICO     \n");
+    printf("=======================================================\n");
+    
+    clock_t inicio = clock();
+    for(int p = 0; p < NUM_CONJUNTOS_PESOS; p++) {
+        memset(&resultados[p], 0, sizeof(ResultadoBacktest));
+        resultados[p].pesos = CONJUNTOS_PESOS[p];
+        for(int i = 0; i < MAX_ZONAS; i++) {
+            ejecutarBacktestZona(&zonas[i], &resultados[p]);
+        }
+    }
+    double milisegundos = (double)(clock() - inicio) * 1000.0 / CLOCKS_PER_SEC;
+    
+    if(resultados[0].predicciones[0] == 0) {
+        printf("Datos insuficientes (se requieren al menos 4 dias en alguna zona).\n");
+        printf("\nPresione Enter para continuar...");
+        getchar();
+        return;
+    }
+    
+    // Error por conjunto de pesos; el mejor minimiza el RMSE relativo al límite OMS
+    printf("\nERROR DE LA PREDICCION 24H POR CONJUNTO DE PESOS (%d predicciones):\n",
+           resultados[0].predicciones[0]);
+    printf("Pesos               | Contam. | MAE      | RMSE\n");
+    printf("--------------------|---------|----------|----------\n");
+    
+    int mejor = 0;
+    float mejor_error = 0;
+    for(int p = 0; p < NUM_CONJUNTOS_PESOS; p++) {
+        float error_relativo = 0;
+        for(int c = 0; c < 4; c++) {
+            int n = resultados[p].predicciones[c];
+            float mae = resultados[p].suma_error_absoluto[c] / n;
+            float rmse = raizCuadrada(resultados[p].suma_error_cuadratico[c] / n);
+            error_relativo += rmse / obtenerLimiteOMS(c);
+            
+            if(c == 0) {
+                printf("%.2f/%.2f/%.2f/%.2f | ", resultados[p].pesos.dia_1, resultados[p].pesos.dia_2,
+                       resultados[p].pesos.dia_3, resultados[p].pesos.resto);
+            } else {
+                printf("                    | ");
+            }
+            printf("%-7s | %8.2f | %8.2f\n", nombres_cont[c], mae, rmse);
+        }
+        printf("--------------------|---------|----------|----------\n");
+        
+        if(p == 0 || error_relativo < mejor_error) {
+            mejor = p;
+            mejor_error = error_relativo;
+        }
+    }
+    
+    printf("\nMEJORES PESOS: %.2f/%.2f/%.2f/%.2f%s\n",
+           resultados[mejor].pesos.dia_1, resultados[mejor].pesos.dia_2,
+           resultados[mejor].pesos.dia_3, resultados[mejor].pesos.resto,
+           mejor == 0 ? " (pesos actuales del sistema)" : "");
+    
+    // Matrices de confusión de niveles de alerta para los mejores pesos
+    printf("\nMATRICES DE CONFUSION DE ALERTAS (filas: real, columnas: predicho):\n");
+    for(int c = 0; c < 4; c++) {
+        printf("\n%s\n", nombres_cont[c]);
+        printf("          | VERDE | AMAR. | NARAN.| ROJO  |\n");
+        int aciertos = 0;
+        for(int real = 0; real < 4; real++) {
+            printf("%-9s |", niveles[real]);
+            for(int predicho = 0; predicho < 4; predicho++) {
+                printf(" %5d |", resultados[mejor].confusion[c][real][predicho]);
+            }
+            printf("\n");
+            aciertos += resultados[mejor].confusion[c][real][real];
+        }
+        printf("Aciertos de nivel: %.1f%%\n",
+               (float)aciertos / resultados[mejor].predicciones[c] * 100);
+    }
+    
+    printf("\n%d conjuntos de pesos x %d zonas evaluados en %.3f ms\n",
+           NUM_CONJUNTOS_PESOS, MAX_ZONAS, milisegundos);
+    printf("=======================================================\n");
+    printf("\nPresione Enter para continuar...");
+    getchar();
+}
+
+// Función principal para predecir clima a 24h a partir del clima registrado cada día
+// (historico_fechas[i].clima, i = 0 es el día más reciente). Usa la misma ponderación
+// que la contaminación y acumula las cuatro variables en una sola pasada por el histórico.
+DatosClimaticos predecirClima24h(ZonaUrbana *zona) {
+    int n = zona->dias_registrados;
+    if(n < 3) {
+        return zona->clima_actual;
+    }
+    
+    RegistroHistorico *hist = zona->historico_fechas;
+    const float pesos[3] = {PESO_DIA_1, PESO_DIA_2, PESO_DIA_3};
+    DatosClimaticos clima_predicho = {0.0, 0.0, 0.0, 0.0};
+    DatosClimaticos suma_resto = {0.0, 0.0, 0.0, 0.0};
+    
+    // Días más recientes con su peso individual
+    for(int i = 0; i < 3; i++) {
+        clima_predicho.temperatura += hist[i].clima.temperatura * pesos[i];
+        clima_predicho.velocidad_viento += hist[i].clima.velocidad_viento * pesos[i];
+        clima_predicho.humedad += hist[i].clima.humedad * pesos[i];
+        clima_predicho.presion_atmosferica += hist[i].clima.presion_atmosferica * pesos[i];
+    }
+    
+    // Días anteriores comparten PESO_RESTO
+    for(int i = 3; i < n; i++) {
+        suma_resto.temperatura += hist[i].clima.temperatura;
+        suma_resto.velocidad_viento += hist[i].clima.velocidad_viento;
+        suma_resto.humedad += hist[i].clima.humedad;
+        suma_resto.presion_atmosferica += hist[i].clima.presion_atmosferica;
+    }
+    
+    if(n > 3) {
+        float peso_resto = PESO_RESTO / (n - 3);
+        clima_predicho.temperatura += suma_resto.temperatura * peso_resto;
+        clima_predicho.velocidad_viento += suma_resto.velocidad_viento * peso_resto;
+        clima_predicho.humedad += suma_resto.humedad * peso_resto;
+        clima_predicho.presion_atmosferica += suma_resto.presion_atmosferica * peso_resto;
+    } else {
+        // Con solo 3 días se normaliza para que los pesos sumen 1
+        float normalizar = 1.0 / (PESO_DIA_1 + PESO_DIA_2 + PESO_DIA_3);
+        clima_predicho.temperatura *= normalizar;
+        clima_predicho.velocidad_viento *= normalizar;
+        clima_predicho.humedad *= normalizar;
+        clima_predicho.presion_atmosferica *= normalizar;
+    }
+    
+    // Validar rangos finales de las predicciones
+    if(clima_predicho.temperatura < -20.0) clima_predicho.temperatura = -20.0;
+    if(clima_predicho.temperatura > 50.0) clima_predicho.temperatura = 50.0;
+    if(clima_predicho.velocidad_viento < 0.0) clima_predicho.velocidad_viento = 0.0;
+    if(clima_predicho.velocidad_viento > 120.0) clima_predicho.velocidad_viento = 120.0;
+    if(clima_predicho.humedad < 0.0) clima_predicho.humedad = 0.0;
+    if(clima_predicho.humedad > 100.0) clima_predicho.humedad = 100.0;
+    if(clima_predicho.presion_atmosferica < 900.0) clima_predicho.presion_atmosferica = 900.0;
+    if(clima_predicho.presion_atmosferica > 1100.0) clima_predicho.presion_atmosferica = 1100.0;
+    
+    return clima_predicho;
+}
+
+void mostrarRecomendaciones(int nivel_alerta, char *contaminante) {
+    switch(nivel_alerta) {
+        case ALERTA_VERDE:
+            printf("> Condiciones normales - Calidad del aire buena\n");
+            printf("> Actividades al aire libre sin restricciones\n");
+            printf("> Ideal para ejercicio y deportes al exterior\n");
+            printf("> Mantener monitoreo regular\n");
+            printf("> Ventilar espacios cerrados normalmente\n");
+            break;
+            
+        case ALERTA_AMARILLA:
+            printf("> Personas sensibles deben limitar actividades prolongadas al aire libre\n");
+            printf("> Reducir ejercicio intenso en exteriores\n");
+            printf("> Preferir transporte publico o bicicleta\n");
+            printf("> Ventilar espacios cerrados en horas de menor contaminacion\n");
+            printf("> Grupos vulnerables: ninos, ancianos y personas con asma deben tomar precauciones\n");
+            break;
+            
+        case ALERTA_NARANJA:
+            printf("> Evitar actividades fisicas intensas al aire libre\n");
+            printf("> Usar mascarilla si es necesario salir por periodos prolongados\n");
+            printf("> Mantener ventanas cerradas durante el dia\n");
+            printf("> Personas con problemas respiratorios deben evitar exposicion\n");
+            printf("> Postponer actividades deportivas al exterior\n");
+            printf("> Usar purificadores de aire en espacios cerrados\n");
+            break;
+            
+        case ALERTA_ROJA:
+            printf("> EVITAR SALIR SI ES POSIBLE - PERMANECER EN INTERIORES\n");
+            printf("> Usar mascarilla N95 obligatoriamente al salir\n");
+            printf("> Mantener espacios cerrados y filtrar el aire\n");
+            printf("> Personas vulnerables deben quedarse en casa\n");
+            printf("> Contactar servicios medicos si hay sintomas respiratorios\n");
+            printf("> Suspender todas las actividades al aire libre\n");
+            printf("> Considerar evacuar a zonas con mejor calidad del aire\n");
+            break;
+    }
+    
+    // Recomendaciones adicionales generales
+    printf("\nRECOMENDACIONES ADICIONALES:\n");
+    switch(nivel_alerta) {
+        case ALERTA_VERDE:
+            printf("- Aprovechar para actividades al aire libre\n");
+            printf("- Mantener rutinas normales de ejercicio\n");
+            break;
+        case ALERTA_AMARILLA:
+            printf("- Revisar pronostico antes de planificar actividades\n");
+            printf("- Tener medicamentos para asma a la mano\n");
+            break;
+        case ALERTA_NARANJA:
+            printf("- Informar a grupos vulnerables sobre riesgos\n");
+            printf("- Evitar areas de trafico pesado\n");
+            break;
+        case ALERTA_ROJA:
+            printf("- Contactar autoridades de salud publica\n");
+            printf("- Activar protocolos de emergencia ambiental\n");
+            break;
+    }
+}
+
+// ============== FUNCIONES PARA TRANSACCIONES DE CORRECCION ==============
+
+// Nombres, claves CSV y rangos válidos de cada campo (índice = CAMPO_*)
+static char *nombres_campos_correccion[] = {"", "CO2 (ppm)", "SO2 (ug/m3)", "NO2 (ug/m3)", "PM2.5 (ug/m3)",
+                                            "Temperatura (C)", "Viento (km/h)", "Humedad (%)", "Presion (hPa)"};
+static char *claves_campos_correccion[] = {"", "co2", "so2", "no2", "pm25",
+                                           "temperatura", "viento", "humedad", "presion"};
+static float rango_minimo_campo[] = {0, 0.0, 0.0, 0.0, 0.0, -20.0, 0.0, 0.0, 900.0};
+static float rango_maximo_campo[] = {0, 1000.0, 500.0, 300.0, 200.0, 50.0, 120.0, 100.0, 1100.0};
+
+void iniciarTransaccion(TransaccionCorrecciones *transaccion) {
+    transaccion->correcciones = NULL;
+    transaccion->num_correcciones = 0;
+    transaccion->capacidad = 0;
+}
+
+void liberarTransaccion(TransaccionCorrecciones *transaccion) {
+    free(transaccion->correcciones);
+    iniciarTransaccion(transaccion);
+}
+
+// Campo por su clave CSV (co2, so2, no2, pm25, temperatura, viento, humedad, presion)
+// o por su número del editor; 0 si no existe
+int campoDeCorreccion(const char *nombre) {
+    int numero;
+    char resto;
+    if(sscanf(nombre, "%d%c", &numero, &resto) == 1) {
+        return (numero >= 1 && numero <= NUM_CAMPOS_CORRECCION) ? numero : 0;
+    }
+    for(int campo = 1; campo <= NUM_CAMPOS_CORRECCION; campo++) {
+        if(strcmp(nombre, claves_campos_correccion[campo]) == 0) {
+            return campo;
+        }
+    }
+    if(strcmp(nombre, "pm2.5") == 0) {
+        return CAMPO_PM25;
+    }
+    return 0;
+}
+
+// Prepara una corrección sin tocar la zona. Devuelve 0 si la zona, el campo o el
+// valor no son válidos.
+int agregarCorreccion(TransaccionCorrecciones *transaccion, int id_zona, Fecha fecha, int posicion,
+                      int campo, float valor) {
+    if(id_zona < 1 || id_zona > MAX_ZONAS || campo < 1 || campo > NUM_CAMPOS_CORRECCION ||
+       valor < rango_minimo_campo[campo] || valor > rango_maximo_campo[campo]) {
+        return 0;
+    }
+    if(transaccion->num_correcciones == transaccion->capacidad) {
+        int nueva_capacidad = transaccion->capacidad > 0 ? transaccion->capacidad * 2 : 16;
+        CorreccionDato *nuevas = realloc(transaccion->correcciones, nueva_capacidad * sizeof(CorreccionDato));
+        if(nuevas == NULL) {
+            return 0;
+        }
+        transaccion->correcciones = nuevas;
+        transaccion->capacidad = nueva_capacidad;
+    }
+    
+    CorreccionDato *correccion = &transaccion->correcciones[transaccion->num_correcciones++];
+    correccion->id_zona = id_zona;
+    correccion->fecha = fecha;
+    correccion->posicion = posicion;
+    correccion->campo = campo;
+    correccion->valor = valor;
+    return 1;
+}
+
+// Aplica un valor en memoria al día 'dia' del histórico completo (ventana o archivados)
+// y actualiza lo que depende de él. No guarda la zona.
+void aplicarCorreccionDia(ZonaUrbana *zona, int dia, int campo, float valor) {
+    RegistroHistorico *registro;
+    if(dia < zona->dias_registrados) {
+        registro = &zona->historico_fechas[dia];
+    } else {
+        registro = registroArchivado(&zona->archivado, diasTotalesZona(zona) - 1 - dia);
+    }
+    
+    switch(campo) {
+        case CAMPO_CO2: registro->niveles.co2 = valor; break;
+        case CAMPO_SO2: registro->niveles.so2 = valor; break;
+        case CAMPO_NO2: registro->niveles.no2 = valor; break;
+        case CAMPO_PM25: registro->niveles.pm25 = valor; break;
+        case CAMPO_TEMPERATURA: registro->clima.temperatura = valor; break;
+        case CAMPO_VIENTO: registro->clima.velocidad_viento = valor; break;
+        case CAMPO_HUMEDAD: registro->clima.humedad = valor; break;
+        case CAMPO_PRESION: registro->clima.presion_atmosferica = valor; break;
+    }
+    
+    int era_imputado = diaImputado(zona, dia);
+    if(dia < zona->dias_registrados) {
+        // Un día completado por interpolación y corregido pasa a ser un dato real
+        marcarBitDeMapa(zona->dias_imputados, dia, 0);
+        switch(campo) {
+            case CAMPO_CO2: zona->historico[dia].co2 = valor; break;
+            case CAMPO_SO2: zona->historico[dia].so2 = valor; break;
+            case CAMPO_NO2: zona->historico[dia].no2 = valor; break;
+            case CAMPO_PM25: zona->historico[dia].pm25 = valor; break;
+        }
+        // El día más reciente es también el estado actual de la zona
+        if(dia == 0) {
+            zona->niveles_actuales = zona->historico[0];
+            zona->clima_actual = registro->clima;
+        }
+        // El modelo estadístico y los detectores de anomalías dependen de la ventana (y
+        // de qué días cuentan como lecturas propias)
+        if(campo <= CAMPO_PM25 || era_imputado) {
+            zona->modelos_ajustados = 0;
+            zona->detectores_listos = 0;
+        }
+    }
+    if(campo <= CAMPO_PM25 || era_imputado) {
+        marcarExcesosDia(zona, dia, dia < zona->dias_registrados ? zona->historico[dia] : registro->niveles);
+    }
+    if(dia < zona->dias_registrados) {
+        registrarCambioDia(zona, dia, campo <= CAMPO_PM25 || era_imputado ? ENTRADA_CONTAMINANTES | ENTRADA_CLIMA
+                                                                          : ENTRADA_CLIMA);
+    }
+    zona->modificada = 1;
+}
+
+// Confirma las correcciones: por cada zona se toma el bloqueo, se cargan los cambios de
+// otras instancias, se aplican todas sus correcciones y se escribe el archivo una sola vez.
+// Devuelve el número de correcciones aplicadas.
+int confirmarTransaccion(ZonaUrbana zonas[], TransaccionCorrecciones *transaccion) {
+    int aplicadas = 0;
+    ArenaTemporal *arena = arenaReportes();
+    
+    for(int z = 0; z < MAX_ZONAS; z++) {
+        ZonaUrbana *zona = &zonas[z];
+        int pendientes = 0;
+        for(int i = 0; i < transaccion->num_correcciones; i++) {
+            if(transaccion->correcciones[i].id_zona == z + 1) pendientes++;
+        }
+        if(pendientes == 0) continue;
+        if(zona->id_zona == 0) {
+            printf("ERROR: La zona %d no se cargo; %d correccion(es) sin aplicar.\n", z + 1, pendientes);
+            continue;
+        }
+        
+        if(!bloquearZona(zona->id_zona)) {
+            printf("ERROR: La zona %s esta bloqueada por otra instancia; %d correccion(es) sin aplicar.\n",
+                   zona->nombre, pendientes);
+            continue;
+        }
+        // Si otra instancia guardó la zona, las correcciones se aplican sobre sus datos
+        refrescarZona(zona);
+        
+        // Índice de fechas para las correcciones cuya posición ya no corresponde
+        MarcaArena marca = marcaArena(arena);
+        VistaHistorial vista;
+        int con_indice = diasTotalesZona(zona) > 0 &&
+                         abrirVistaHistorial(&vista, zona, diasTotalesZona(zona), arena);
+        int aplicadas_zona = 0, sin_dia = 0;
+        int anios_corregidos[MAX_ANIOS_RESUMEN], num_anios_corregidos = 0;
+        
+        for(int i = 0; i < transaccion->num_correcciones; i++) {
+            CorreccionDato *correccion = &transaccion->correcciones[i];
+            if(correccion->id_zona != zona->id_zona) continue;
+            
+            int dia = correccion->posicion;
+            if(dia < 0 || dia >= diasTotalesZona(zona) ||
+               compararFechas(registroHistoricoCompleto(zona, dia).fecha, correccion->fecha) != 0) {
+                int exacta = 0;
+                dia = con_indice ? buscarDiaPorFecha(&vista, correccion->fecha, &exacta) : -1;
+                if(!exacta) dia = -1;
+            }
+            if(dia < 0) {
+                sin_dia++;
+                continue;
+            }
+            aplicarCorreccionDia(zona, dia, correccion->campo, correccion->valor);
+            aplicadas_zona++;
+            
+            int año = registroHistoricoCompleto(zona, dia).fecha.año, ya_anotado = 0;
+            for(int a = 0; a < num_anios_corregidos; a++) {
+                if(anios_corregidos[a] == año) ya_anotado = 1;
+            }
+            if(correccion->campo <= CAMPO_PM25 && !ya_anotado && num_anios_corregidos < MAX_ANIOS_RESUMEN) {
+                anios_corregidos[num_anios_corregidos++] = año;
+            }
+        }
+        restaurarArena(arena, marca);
+        
+        // Los percentiles de un año corregido se recalculan si todo el año sigue en
+        // memoria; si parte ya se compactó en disco, su resumen conserva el valor anterior
+        for(int a = 0; a < num_anios_corregidos; a++) {
+            if(anioCompletoEnMemoria(zona, anios_corregidos[a])) {
+                reconstruirCuantilesZona(zona, anios_corregidos[a]);
+            }
+        }
+        
+        if(aplicadas_zona > 0) {
+            publicarInstantaneaZona(zona);
+            if(!guardarZonaBloqueada(zona)) {
+                printf("ERROR: No se pudieron guardar las correcciones de %s.\n", zona->nombre);
+                aplicadas_zona = 0;
+            }
+        }
+        desbloquearZona(zona->id_zona);
+        
+        printf("  %s: %d correccion(es) aplicada(s)", zona->nombre, aplicadas_zona);
+        if(sin_dia > 0) {
+            printf(", %d sin dia registrado con esa fecha", sin_dia);
+        }
+        printf("\n");
+        aplicadas += aplicadas_zona;
+    }
+    return aplicadas;
+}
+
+// Aplica un archivo CSV de correcciones con líneas "zona,dd/mm/aaaa,campo,valor" (se
+// ignoran líneas vacías, comentarios con '#' y el encabezado). Si alguna línea es
+// inválida no se aplica ninguna. Devuelve las correcciones aplicadas o -1.
+int aplicarCorreccionesCSV(ZonaUrbana zonas[], char *nombre_archivo) {
+    FILE *archivo = fopen(nombre_archivo, "r");
+    if(archivo == NULL) {
+        printf("ERROR: No se pudo abrir %s\n", nombre_archivo);
+        return -1;
+    }
+    
+    TransaccionCorrecciones transaccion;
+    iniciarTransaccion(&transaccion);
+    char linea[256];
+    int num_linea = 0, errores = 0;
+    
+    while(fgets(linea, sizeof(linea), archivo) != NULL) {
+        int id_zona;
+        Fecha fecha;
+        char campo_texto[32];
+        float valor;
+        
+        num_linea++;
+        char *inicio = linea;
+        while(*inicio == ' ' || *inicio == '\t') inicio++;
+        if(*inicio == '\0' || *inicio == '\n' || *inicio == '\r' || *inicio == '#' ||
+           strncmp(inicio, "zona", 4) == 0) {
+            continue;
+        }
+        
+        if(sscanf(inicio, "%d ,%d/%d/%d , %31[^, \t] ,%f", &id_zona, &fecha.dia, &fecha.mes, &fecha.año,
+                  campo_texto, &valor) != 6) {
+            printf("Linea %d: formato invalido (zona,dd/mm/aaaa,campo,valor)\n", num_linea);
+            errores++;
+            continue;
+        }
+        int campo = campoDeCorreccion(campo_texto);
+        if(campo == 0) {
+            printf("Linea %d: campo desconocido '%s'\n", num_linea, campo_texto);
+            errores++;
+        } else if(!agregarCorreccion(&transaccion, id_zona, fecha, -1, campo, valor)) {
+            printf("Linea %d: zona o valor fuera de rango (%s: %.1f a %.1f)\n", num_linea,
+                   nombres_campos_correccion[campo], rango_minimo_campo[campo], rango_maximo_campo[campo]);
+            errores++;
+        }
+    }
+    fclose(archivo);
+    
+    int aplicadas = -1;
+    if(errores > 0) {
+        printf("No se aplico ninguna correccion: %d linea(s) con errores.\n", errores);
+    } else {
+        printf("Aplicando %d correccion(es) de %s:\n", transaccion.num_correcciones, nombre_archivo);
+        aplicadas = confirmarTransaccion(zonas, &transaccion);
+    }
+    liberarTransaccion(&transaccion);
+    return aplicadas;
+}
+
+// ================= FUNCION DE CORRECCION DE DATOS INGRESADOS MEJORADA =================
+void corregirDatosIngresados(ZonaUrbana zonas[]) {
+    int id_zona, val, dia;
+    char continuar_editando = 's';
+    int cambios_realizados = 0;
+    TransaccionCorrecciones transaccion;
+
+    // Mostrar zonas disponibles
+    recargarZonasModificadasExternamente(zonas);
+    printf("\n=== EDITOR AVANZADO DE DATOS HISTORICOS ===\n");
+    printf("ZONAS DISPONIBLES PARA EDICION:\n");
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        printf("%d. %s (%d dias de datos)\n", zonas[i].id_zona, zonas[i].nombre, zonas[i].dias_registrados);
+    }
+
+    // Seleccionar zona
+    do {
+        printf("\nSeleccione la zona a editar (1-%d): ", MAX_ZONAS);
+        val = scanf("%d", &id_zona);
+        fflush(stdin);
+        if(val != 1 || id_zona < 1 || id_zona > MAX_ZONAS) {
+            printf("ERROR: Opcion invalida. Intente de nuevo.\n");
+        }
+    } while(val != 1 || id_zona < 1 || id_zona > MAX_ZONAS);
+
+    ZonaUrbana *zona = &zonas[id_zona-1];
+    if(zona->dias_registrados == 0) {
+        printf("ERROR: No hay datos registrados para esta zona.\n");
+        return;
+    }
+
+    printf("\n=== EDITANDO ZONA: %s ===\n", zona->nombre);
+    
+    // Los cambios se ven de inmediato en memoria y se guardan juntos al terminar la zona
+    iniciarTransaccion(&transaccion);
+    
+    // Los días editables se recorren por páginas (también por fecha)
+    ArenaTemporal *arena = arenaReportes();
+    MarcaArena marca = marcaArena(arena);
+    VistaHistorial vista;
+    if(!abrirVistaHistorial(&vista, zona, zona->dias_registrados, arena)) {
+        printf("ERROR: Memoria insuficiente para listar los dias.\n");
+        restaurarArena(arena, marca);
+        return;
+    }
+    
+    // BUCLE PRINCIPAL: SELECCIÓN DE DÍA Y EDICIÓN
+    do {
+        // Seleccionar día: 0 abre la navegación entre páginas
+        do {
+            int desde = vista.pagina * FILAS_POR_PAGINA;
+            int hasta = desde + FILAS_POR_PAGINA;
+            if(hasta > vista.total_dias) hasta = vista.total_dias;
+            
+            printf("\nDIAS DISPONIBLES PARA EDICION:\n");
+            printf("=================================================================\n");
+            printf("Dia    Fecha      CO2     SO2     NO2     PM2.5\n");
+            printf("-----------------------------------------------------------------\n");
+            for(int i = desde; i < hasta; i++) {
+                printf("%-6d %02d/%02d/%02d %7.1f %7.1f %7.1f %7.1f\n", 
+                       i+1,
+                       zona->historico_fechas[i].fecha.dia,
+                       zona->historico_fechas[i].fecha.mes,
+                       zona->historico_fechas[i].fecha.año % 100, // Solo últimos 2 dígitos del año
+                       zona->historico[i].co2, zona->historico[i].so2, 
+                       zona->historico[i].no2, zona->historico[i].pm25);
+            }
+            printf("=================================================================\n");
+            printf("(Pagina %d de %d, %d dias disponibles)\n", vista.pagina + 1, vista.num_paginas,
+                   zona->dias_registrados);
+            
+            printf("Seleccione el dia a editar (1-%d, 0 para cambiar de pagina): ", zona->dias_registrados);
+            val = scanf("%d", &dia);
+            fflush(stdin);
+            if(val != 1 || dia < 0 || dia > zona->dias_registrados) {
+                printf("ERROR: Dia invalido. Intente de nuevo.\n");
+            } else if(dia == 0) {
+                navegarVistaHistorial(&vista);
+            }
+        } while(val != 1 || dia < 1 || dia > zona->dias_registrados);
+        dia--; // convertir a índice
+
+        // BUCLE DE EDICIÓN MÚLTIPLE PARA EL DÍA SELECCIONADO
+        int cambios_dia = 0;
+        do {
+            int subop;
+            float nuevo_valor;
+            char confirmacion;
+            
+            // Mostrar panel de edición
+            printf("\nEDITOR - DIA %d de %s\n", dia + 1, zona->nombre);
+            printf("=======================================================\n");
+            printf("CONTAMINANTES ACTUALES:\n");
+            printf("  1. CO2:\t%6.1f ppm\n", zona->historico[dia].co2);
+            printf("  2. SO2:\t%6.1f ug/m3\n", zona->historico[dia].so2);
+            printf("  3. NO2:\t%6.1f ug/m3\n", zona->historico[dia].no2);
+            printf("  4. PM2.5:\t%6.1f ug/m3\n", zona->historico[dia].pm25);
+            printf("\nDATOS CLIMATICOS DEL DIA:\n");
+            printf("  5. Temperatura:\t%6.1f C\n", zona->historico_fechas[dia].clima.temperatura);
+            printf("  6. Viento:\t\t%6.1f km/h\n", zona->historico_fechas[dia].clima.velocidad_viento);
+            printf("  7. Humedad:\t\t%6.1f %%\n", zona->historico_fechas[dia].clima.humedad);
+            printf("  8. Presion:\t\t%6.1f hPa\n", zona->historico_fechas[dia].clima.presion_atmosferica);
+            printf("=======================================================\n");
+            printf("  9. Edicion rapida (todos los contaminantes)\n");
+            printf("  0. Terminar edicion de este dia\n");
+            
+            do {
+                printf("\nSeleccione el campo a editar (0-9): ");
+                val = scanf("%d", &subop);
+                fflush(stdin);
+                if(val != 1 || subop < 0 || subop > 9) {
+                    printf("ERROR: Opcion invalida. Intente de nuevo.\n");
+                }
+            } while(val != 1 || subop < 0 || subop > 9);
+            
+            if(subop == 0) {
+                break; // Terminar edición de este día
+            }
+            
+            // Edición rápida de todos los contaminantes
+            if(subop == 9) {
+                printf("\nEDICION RAPIDA - TODOS LOS CONTAMINANTES\n");
+                printf("Valores actuales: CO2=%.1f, SO2=%.1f, NO2=%.1f, PM2.5=%.1f\n",
+                       zona->historico[dia].co2, zona->historico[dia].so2, 
+                       zona->historico[dia].no2, zona->historico[dia].pm25);
+                       
+                float nuevos_valores[4];
+                
+                printf("Ingrese los nuevos valores:\n");
+                for(int i = 0; i < 4; i++) {
+                    funcionValidarDatosdeRegistro(&nuevos_valores[i], nombres_campos_correccion[CAMPO_CO2 + i], 
+                                                 rango_minimo_campo[CAMPO_CO2 + i], rango_maximo_campo[CAMPO_CO2 + i]);
+                }
+                
+                // Confirmar cambios masivos
+                printf("\nRESUMEN DE CAMBIOS:\n");
+                printf("CO2:\t%.1f\t-->\t%.1f ppm\n", zona->historico[dia].co2, nuevos_valores[0]);
+                printf("SO2:\t%.1f\t-->\t%.1f ug/m3\n", zona->historico[dia].so2, nuevos_valores[1]);
+                printf("NO2:\t%.1f\t-->\t%.1f ug/m3\n", zona->historico[dia].no2, nuevos_valores[2]);
+                printf("PM2.5:\t%.1f\t-->\t%.1f ug/m3\n", zona->historico[dia].pm25, nuevos_valores[3]);
+                
+                do {
+                    printf("¿Confirma TODOS estos cambios? (s/n): ");
+                    scanf(" %c", &confirmacion);
+                    fflush(stdin);
+                } while(confirmacion != 's' && confirmacion != 'S' && confirmacion != 'n' && confirmacion != 'N');
+                
+                if(confirmacion == 's' || confirmacion == 'S') {
+                    // Se aplica en memoria (ventana, niveles actuales y modelo) y queda en la transacción
+                    for(int i = 0; i < 4; i++) {
+                        agregarCorreccion(&transaccion, zona->id_zona, zona->historico_fechas[dia].fecha, dia,
+                                          CAMPO_CO2 + i, nuevos_valores[i]);
+                        aplicarCorreccionDia(zona, dia, CAMPO_CO2 + i, nuevos_valores[i]);
+                    }
+                    
+                    printf("EXITO: Todos los contaminantes actualizados exitosamente.\n");
+                    cambios_dia += 4;
+                } else {
+                    printf("ERROR: Cambios cancelados.\n");
+                }
+                continue;
+            }
+            
+            // Edición individual
+            char **nombres = nombres_campos_correccion;
+            
+            printf("\nEDITANDO: %s\n", nombres[subop]);
+            printf("Valor actual: ");
+            switch(subop) {
+                case 1: printf("%.1f ppm\n", zona->historico[dia].co2); break;
+                case 2: printf("%.1f ug/m3\n", zona->historico[dia].so2); break;
+                case 3: printf("%.1f ug/m3\n", zona->historico[dia].no2); break;
+                case 4: printf("%.1f ug/m3\n", zona->historico[dia].pm25); break;
+                case 5: printf("%.1f C\n", zona->historico_fechas[dia].clima.temperatura); break;
+                case 6: printf("%.1f km/h\n", zona->historico_fechas[dia].clima.velocidad_viento); break;
+                case 7: printf("%.1f%%\n", zona->historico_fechas[dia].clima.humedad); break;
+                case 8: printf("%.1f hPa\n", zona->historico_fechas[dia].clima.presion_atmosferica); break;
+            }
+            
+            funcionValidarDatosdeRegistro(&nuevo_valor, nombres[subop], 
+                                         rango_minimo_campo[subop], rango_maximo_campo[subop]);
+
+            // Confirmar cambio individual
+            do {
+                printf("¿Confirma el cambio de %s? (s/n): ", nombres[subop]);
+                scanf(" %c", &confirmacion);
+                fflush(stdin);
+            } while(confirmacion != 's' && confirmacion != 'S' && confirmacion != 'n' && confirmacion != 'N');
+
+            if(confirmacion == 's' || confirmacion == 'S') {
+                agregarCorreccion(&transaccion, zona->id_zona, zona->historico_fechas[dia].fecha, dia,
+                                  subop, nuevo_valor);
+                aplicarCorreccionDia(zona, dia, subop, nuevo_valor);
+                
+                // Si editamos el día más reciente (día 1 = índice 0), también cambian los niveles actuales
+                if(dia == 0 && subop <= 4) {
+                    printf("INFO: Niveles actuales actualizados (día más reciente modificado).\n");
+                }
+                
+                printf("EXITO: Cambio aplicado exitosamente.\n");
+                cambios_dia++;
+            } else {
+                printf("ERROR: Cambio cancelado.\n");
+            }
+                
+        } while(1); // El bucle se rompe con subop == 0
+
+        // Resumen de cambios del día
+        if(cambios_dia > 0) {
+            printf("\nRESUMEN: %d cambio(s) realizado(s) en el dia %d\n", cambios_dia, dia + 1);
+            cambios_realizados += cambios_dia;
+        }
+        
+        // Preguntar si quiere editar otro día
+        do {
+            printf("\n¿Desea editar otro dia de esta zona? (s/n): ");
+            scanf(" %c", &continuar_editando);
+            fflush(stdin);
+        } while(continuar_editando != 's' && continuar_editando != 'S' && 
+                continuar_editando != 'n' && continuar_editando != 'N');
+                
+    } while(continuar_editando == 's' || continuar_editando == 'S');
+
+    restaurarArena(arena, marca);
+    
+    // Guardar cambios si se realizaron: una sola escritura de la zona para toda la sesión
+    if(cambios_realizados > 0) {
+        printf("\nGuardando correcciones...\n");
+        if(confirmarTransaccion(zonas, &transaccion) > 0) {
+            printf("DATOS GUARDADOS: %d cambio(s) total(es) en %s\n", 
+                   cambios_realizados, zona->nombre);
+        }
+    }
+    liberarTransaccion(&transaccion);
+    
+    // Preguntar si quiere editar otra zona
+    do {
+        printf("\n¿Desea editar datos de otra zona? (s/n): ");
+        scanf(" %c", &continuar_editando);
+        fflush(stdin);
+    } while(continuar_editando != 's' && continuar_editando != 'S' && 
+            continuar_editando != 'n' && continuar_editando != 'N');
+    
+    if(continuar_editando == 's' || continuar_editando == 'S') {
+        corregirDatosIngresados(zonas);
+    }
+    
+    printf("\nEditor finalizado. Total de cambios realizados: %d\n", cambios_realizados);
+}
+
+
+
+// ===== FUNCIONES PARA MANEJO DE FECHAS =====
+
+void mostrarFecha(Fecha fecha) {
+    printf("%02d/%02d/%04d", fecha.dia, fecha.mes, fecha.año);
+}
+
+int compararFechas(Fecha f1, Fecha f2) {
+    if (f1.año != f2.año) return f1.año - f2.año;
+    if (f1.mes != f2.mes) return f1.mes - f2.mes;
+    return f1.dia - f2.dia;
+}
+
+void mostrarHistorialConFechas(ZonaUrbana zonas[]) {
+    printf("\n");
+    printf("=======================================================\n");
+    printf("           HISTORIAL DE DATOS CON FECHAS              \n");
+    printf("=======================================================\n\n");
+    
+    int zona_seleccionada, val;
+    
+    // Mostrar zonas disponibles
+    printf("ZONAS DISPONIBLES:\n");
+    printf("-------------------------------------------------------\n");
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        printf("  %d. %-25s", zonas[i].id_zona, zonas[i].nombre);
+        if(zonas[i].dias_registrados > 0) {
+            printf("(%d dias registrados)\n", zonas[i].dias_registrados);
+        } else {
+            printf("(Sin datos)\n");
+        }
+    }
+    printf("-------------------------------------------------------\n");
+    
+    // Seleccionar zona
+    do {
+        printf("\nSeleccione la zona para ver historial (1-%d): ", MAX_ZONAS);
+        val = scanf("%d", &zona_seleccionada);
+        fflush(stdin);
+        
+        if(val != 1 || zona_seleccionada < 1 || zona_seleccionada > MAX_ZONAS) {
+            printf("ERROR: Opcion invalida. Por favor, intente de nuevo.\n");
+        }
+    } while(val != 1 || zona_seleccionada < 1 || zona_seleccionada > MAX_ZONAS);
+    
+    zona_seleccionada--;
+    
+    if(zonas[zona_seleccionada].dias_registrados == 0) {
+        printf("\nERROR: La zona '%s' no tiene datos registrados.\n", 
+               zonas[zona_seleccionada].nombre);
+        printf("       Registre datos primero usando la opcion 1 del menu.\n");
+        return;
+    }
+    
+    // El visor solo lee la página visible; el índice de fechas y los acumulados
+    // se preparan una vez al abrirlo
+    ArenaTemporal *arena = arenaReportes();
+    VistaHistorial vista;
+    if(!abrirVistaHistorial(&vista, &zonas[zona_seleccionada], diasTotalesZona(&zonas[zona_seleccionada]), arena)) {
+        printf("\nERROR: Memoria insuficiente para mostrar el historial.\n");
+        liberarArena(arena);
+        return;
+    }
+    
+    printf("\n");
+    printf("=======================================================\n");
+    printf("  HISTORIAL DETALLADO: %s\n", zonas[zona_seleccionada].nombre);
+    printf("=======================================================\n");
+    printf("Total de registros: %d dias\n", vista.total_dias);
+    printf("=======================================================\n\n");
+    
+    do {
+        mostrarPaginaHistorial(&vista);
+    } while(navegarVistaHistorial(&vista));
+    
+    // Resumen estadístico de todo el historial, a partir de los acumulados
+    printf("\nRESUMEN ESTADISTICO:\n");
+    printf("-------------------------------------------------------\n");
+    
+    AcumuladoHistorial total;
+    resumenRangoHistorial(&vista, 0, vista.total_dias, &total);
+    
+    printf("  Dias buenos:     %2d (%.1f%%)\n", total.dias_por_estado[0], 
+           (float)total.dias_por_estado[0] / vista.total_dias * 100);
+    printf("  Dias moderados:  %2d (%.1f%%)\n", total.dias_por_estado[1],
+           (float)total.dias_por_estado[1] / vista.total_dias * 100);
+    printf("  Dias daninos:    %2d (%.1f%%)\n", total.dias_por_estado[2],
+           (float)total.dias_por_estado[2] / vista.total_dias * 100);
+    printf("  Dias peligrosos: %2d (%.1f%%)\n", total.dias_por_estado[3],
+           (float)total.dias_por_estado[3] / vista.total_dias * 100);
+    
+    printf("-------------------------------------------------------\n");
+    printf("LIMITES DE REFERENCIA (perfil %s):\n", vista.zona->perfil);
+    printf("  CO2: %.1f ppm | SO2: %.1f ug/m3 | NO2: %.1f ug/m3 | PM2.5: %.1f ug/m3\n",
+           vista.zona->limites[0], vista.zona->limites[1], vista.zona->limites[2], vista.zona->limites[3]);
+    printf("=======================================================\n");
+    liberarArena(arena);
+    
+    printf("\nPresione Enter para continuar...");
+    getchar();
+}
+
+// ===== FUNCIONES PARA EL VISOR PAGINADO DEL HISTORIAL =====
+
+// Estado general de un día según cuántos contaminantes exceden el límite OMS
+// (0 = Bueno, 1 = Moderado, 2 = Danino, 3 = Peligroso)
+int estadoDeRegistro(const RegistroHistorico *registro, const float *limites) {
+    int excesos = contarBitsPalabra(excesosDeNiveles(registro->niveles, limites));
+    return excesos > 3 ? 3 : excesos;
+}
+
+// Orden del índice: por fecha y, en la misma fecha, por posición (la más reciente primero)
+int compararEntradasIndice(const void *a, const void *b) {
+    const EntradaIndiceFechas *x = a;
+    const EntradaIndiceFechas *y = b;
+    if(x->numero_dia != y->numero_dia) {
+        return x->numero_dia < y->numero_dia ? -1 : 1;
+    }
+    return x->posicion - y->posicion;
+}
+
+// Prepara el visor sobre los 'total_dias' más recientes de la zona: un recorrido para el
+// índice de fechas y los acumulados, y después cada página lee solo sus filas
+int abrirVistaHistorial(VistaHistorial *vista, ZonaUrbana *zona, int total_dias, ArenaTemporal *arena) {
+    vista->zona = zona;
+    vista->total_dias = total_dias;
+    vista->pagina = 0;
+    vista->num_paginas = (total_dias + FILAS_POR_PAGINA - 1) / FILAS_POR_PAGINA;
+    vista->indice_fechas = reservarArena(arena, (total_dias + 1) * sizeof(EntradaIndiceFechas));
+    vista->acumulados = reservarArena(arena, (total_dias + 1) * sizeof(AcumuladoHistorial));
+    if(vista->indice_fechas == NULL || vista->acumulados == NULL) {
+        return 0;
+    }
+    
+    memset(&vista->acumulados[0], 0, sizeof(AcumuladoHistorial));
+    for(int i = 0; i < total_dias; i++) {
+        RegistroHistorico registro = registroHistoricoCompleto(zona, i);
+        AcumuladoHistorial *siguiente = &vista->acumulados[i + 1];
+        
+        *siguiente = vista->acumulados[i];
+        siguiente->suma[0] += registro.niveles.co2;
+        siguiente->suma[1] += registro.niveles.so2;
+        siguiente->suma[2] += registro.niveles.no2;
+        siguiente->suma[3] += registro.niveles.pm25;
+        siguiente->dias_por_estado[estadoDeRegistro(&registro, zona->limites)]++;
+        
+        vista->indice_fechas[i].numero_dia = numeroDeDia(registro.fecha);
+        vista->indice_fechas[i].posicion = i;
+    }
+    qsort(vista->indice_fechas, total_dias, sizeof(EntradaIndiceFechas), compararEntradasIndice);
+    return 1;
+}
+
+// Resumen de los días [desde, hasta) como diferencia de dos acumulados
+void resumenRangoHistorial(VistaHistorial *vista, int desde, int hasta, AcumuladoHistorial *resumen) {
+    for(int c = 0; c < 4; c++) {
+        resumen->suma[c] = vista->acumulados[hasta].suma[c] - vista->acumulados[desde].suma[c];
+        resumen->dias_por_estado[c] = vista->acumulados[hasta].dias_por_estado[c] -
+                                      vista->acumulados[desde].dias_por_estado[c];
+    }
+}
+
+// Posición del día con esa fecha (búsqueda binaria en el índice). Si no está registrada
+// devuelve el día anterior más cercano, o el más antiguo posterior; *exacta indica el caso.
+int buscarDiaPorFecha(VistaHistorial *vista, Fecha fecha, int *exacta) {
+    long buscado = numeroDeDia(fecha);
+    int inferior = 0, superior = vista->total_dias;
+    
+    while(inferior < superior) {
+        int medio = (inferior + superior) / 2;
+        if(vista->indice_fechas[medio].numero_dia < buscado) {
+            inferior = medio + 1;
+        } else {
+            superior = medio;
+        }
+    }
+    
+    *exacta = inferior < vista->total_dias && vista->indice_fechas[inferior].numero_dia == buscado;
+    if(*exacta) {
+        return vista->indice_fechas[inferior].posicion;
+    }
+    if(inferior > 0) {
+        return vista->indice_fechas[inferior - 1].posicion;
+    }
+    return vista->indice_fechas[0].posicion;
+}
+
+// Tabla de la página actual con su resumen
+void mostrarPaginaHistorial(VistaHistorial *vista) {
+    int desde = vista->pagina * FILAS_POR_PAGINA;
+    int hasta = desde + FILAS_POR_PAGINA;
+    if(hasta > vista->total_dias) hasta = vista->total_dias;
+    
+    // Encabezados de tabla mejorados
+    printf("+-----------+--------+--------+--------+--------+---------------+\n");
+    printf("| Fecha     |  CO2   |  SO2   |  NO2   | PM2.5  | Estado General|\n");
+    printf("| (dd/mm/aa)| (ppm)  |(ug/m3) |(ug/m3) |(ug/m3) |               |\n");
+    printf("+-----------+--------+--------+--------+--------+---------------+\n");
+    
+    // Las filas se arman en memoria y se escriben juntas
+    ArenaTemporal *arena = arenaReportes();
+    MarcaArena marca = marcaArena(arena);
+    BufferSalida salida;
+    iniciarBufferSalida(&salida, arena, TAM_BUFFER_SALIDA, stdout);
+    int imputados = 0;
+    for(int i = desde; i < hasta; i++) {
+        RegistroHistorico registro = registroHistoricoCompleto(vista->zona, i);
+        int imputado = diaImputado(vista->zona, i);
+        agregarFilaHistorial(&salida, &registro, imputado, vista->zona->limites);
+        imputados += imputado;
+        
+        // Separador entre filas cada 5 registros para mejor legibilidad
+        if((i - desde + 1) % 5 == 0 && i < hasta - 1) {
+            agregarTexto(&salida, "+-----------+--------+--------+--------+--------+---------------+\n");
+        }
+    }
+    vaciarBufferSalida(&salida);
+    restaurarArena(arena, marca);
+    
+    printf("+-----------+--------+--------+--------+--------+---------------+\n");
+    if(imputados > 0) {
+        printf("* Dia faltante completado por interpolacion\n");
+    }
+    
+    AcumuladoHistorial resumen;
+    resumenRangoHistorial(vista, desde, hasta, &resumen);
+    int dias = hasta - desde;
+    printf("Pagina %d de %d (dias %d-%d de %d)\n", vista->pagina + 1, vista->num_paginas,
+           desde + 1, hasta, vista->total_dias);
+    printf("  Promedios: CO2 %.1f | SO2 %.1f | NO2 %.1f | PM2.5 %.1f\n",
+           resumen.suma[0] / dias, resumen.suma[1] / dias, resumen.suma[2] / dias, resumen.suma[3] / dias);
+    printf("  Buenos: %d | Moderados: %d | Daninos: %d | Peligrosos: %d\n",
+           resumen.dias_por_estado[0], resumen.dias_por_estado[1],
+           resumen.dias_por_estado[2], resumen.dias_por_estado[3]);
+}
+
+// Pide una fecha dd/mm/aaaa válida
+void leerFecha(Fecha *fecha) {
+    int val;
+    do {
+        printf("Ingrese la fecha (dd/mm/aaaa): ");
+        val = scanf("%d/%d/%d", &fecha->dia, &fecha->mes, &fecha->año);
+        fflush(stdin);
+        
+        if(val != 3 || fecha->dia < 1 || fecha->dia > 31 || fecha->mes < 1 || fecha->mes > 12 || fecha->año < 1900) {
+            printf("ERROR: Fecha invalida. Intente de nuevo.\n");
+            val = 0;
+        }
+    } while(val != 3);
+}
+
+// Menú de navegación del visor. Devuelve 0 cuando el usuario elige salir.
+int navegarVistaHistorial(VistaHistorial *vista) {
+    int opcion, val;
+    
+    printf("\n1. Pagina siguiente (dias mas antiguos)\n");
+    printf("2. Pagina anterior (dias mas recientes)\n");
+    printf("3. Ir a una fecha\n");
+    printf("4. Ir a una pagina\n");
+    printf("0. Volver\n");
+    do {
+        printf("Seleccione una opcion (0-4): ");
+        val = scanf("%d", &opcion);
+        fflush(stdin);
+        
+        if(val != 1 || opcion < 0 || opcion > 4) {
+            printf("ERROR: Opcion invalida. Intente de nuevo.\n");
+        }
+    } while(val != 1 || opcion < 0 || opcion > 4);
+    
+    if(opcion == 1) {
+        if(vista->pagina < vista->num_paginas - 1) {
+            vista->pagina++;
+        } else {
+            printf("Ya se muestra la pagina mas antigua.\n");
+        }
+    } else if(opcion == 2) {
+        if(vista->pagina > 0) {
+            vista->pagina--;
+        } else {
+            printf("Ya se muestra la pagina mas reciente.\n");
+        }
+    } else if(opcion == 3) {
+        Fecha fecha;
+        int exacta;
+        leerFecha(&fecha);
+        
+        int posicion = buscarDiaPorFecha(vista, fecha, &exacta);
+        RegistroHistorico registro = registroHistoricoCompleto(vista->zona, posicion);
+        if(!exacta) {
+            printf("No hay datos del %02d/%02d/%04d; se muestra el dia mas cercano (%02d/%02d/%04d).\n",
+                   fecha.dia, fecha.mes, fecha.año,
+                   registro.fecha.dia, registro.fecha.mes, registro.fecha.año);
+        }
+        vista->pagina = posicion / FILAS_POR_PAGINA;
+    } else if(opcion == 4) {
+        int pagina;
+        do {
+            printf("Ingrese la pagina (1-%d): ", vista->num_paginas);
+            val = scanf("%d", &pagina);
+            fflush(stdin);
+            
+            if(val != 1 || pagina < 1 || pagina > vista->num_paginas) {
+                printf("ERROR: Pagina invalida. Intente de nuevo.\n");
+            }
+        } while(val != 1 || pagina < 1 || pagina > vista->num_paginas);
+        vista->pagina = pagina - 1;
+    }
+    return opcion != 0;
+}
+
+// ===== FUNCIONES PARA EXPORTACIÓN DE REPORTES =====
+
+void exportarReportePorZona(ZonaUrbana zonas[], int zona_id) {
+    if (zona_id < 1 || zona_id > MAX_ZONAS) {
+        printf("ID de zona invalido.\n");
+        return;
+    }
+    
+    // El reporte se escribe desde una instantánea fija de la zona
+    InstantaneaZona *zona = fijarInstantanea(zona_id);
+    if (zona == NULL) {
+        printf("La zona %s no esta disponible.\n", zonas[zona_id - 1].nombre);
+        return;
+    }
+    
+    ArenaTemporal *arena = arenaReportes();
+    char *nombre_archivo = formatearEnArena(arena, "reporte_zona_%d_%s.txt", zona_id, zona->nombre);
+    
+    FILE *archivo = nombre_archivo != NULL ? fopen(nombre_archivo, "w") : NULL;
+    if (archivo == NULL) {
+        printf("Error al crear el archivo de reporte.\n");
+        liberarInstantanea(zona);
+        liberarArena(arena);
+        return;
+    }
+    
+    /* Obtener fecha actual para el reporte */
+    time_t tiempo_actual = time(NULL);
+    struct tm *tiempo_local = localtime(&tiempo_actual);
+    
+    /* Arte ASCII mejorado y encabezado visual - VERSION LIMPIA SIN SOMBRAS */
+    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "║      █████  ██ ██████       ██████  ██   ██  █████  ██      ██ ████████ ██   ██  ║\n");
+    fprintf(archivo, "║     ██   ██ ██ ██   ██     ██    ██ ██   ██ ██   ██ ██      ██    ██     ██ ██   ║\n");
+    fprintf(archivo, "║     ███████ ██ ██████      ██    ██ ██   ██ ███████ ██      ██    ██      ███    ║\n");
+    fprintf(archivo, "║     ██   ██ ██ ██   ██     ██ ██ ██ ██   ██ ██   ██ ██      ██    ██      ██     ║\n");
+    fprintf(archivo, "║     ██   ██ ██ ██   ██      ██████   █████  ██   ██ ███████ ██    ██      ██     ║\n");
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "║            ███    ███  ██████  ███    ██ ██ ████████  ██████  ██████            ║\n");
+    fprintf(archivo, "║            ████  ████ ██    ██ ████   ██ ██    ██    ██    ██ ██   ██           ║\n");
+    fprintf(archivo, "║            ██ ████ ██ ██    ██ ██ ██  ██ ██    ██    ██    ██ ██████            ║\n");
+    fprintf(archivo, "║            ██  ██  ██ ██    ██ ██  ██ ██ ██    ██    ██    ██ ██   ██           ║\n");
+    fprintf(archivo, "║            ██      ██  ██████  ██   ████ ██    ██     ██████  ██   ██           ║\n");
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "║                   ╔═══════════════════════════════════════════════╗              ║\n");
+    fprintf(archivo, "║                   ║          MONITOREO AMBIENTAL QUITO           ║              ║\n");
+    fprintf(archivo, "║                   ║           SISTEMA DE CALIDAD DEL AIRE         ║              ║\n");
+    fprintf(archivo, "║                   ║               ECUADOR - 2025                  ║              ║\n");
+    fprintf(archivo, "║                   ║            REPORTE PROFESIONAL               ║              ║\n");
+    fprintf(archivo, "║                   ╚═══════════════════════════════════════════════╝              ║\n");
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n");
+    fprintf(archivo, "                                                                                    \n");
+    fprintf(archivo, "    ╔═══════════════════════════════════════════════════════════════════════════╗  \n");
+    fprintf(archivo, "    ║    SISTEMA PROFESIONAL DE MONITOREO ATMOSFERICO - ESTILO AIRNOW EPA    ║  \n");
+    fprintf(archivo, "    ║                          Compatible con Estandares OMS                   ║  \n");
+    fprintf(archivo, "    ╚═══════════════════════════════════════════════════════════════════════════╝  \n");
+    fprintf(archivo, "                                                                                    \n");
+    
+    /* Indice de Calidad del Aire (tablas de 24 horas de la EPA) */
+    ResultadoICA ica;
+    calcularICA(zona->niveles_actuales, PERIODO_ICA_24H, &ica);
+    const char *categoria_aqi = nombreCategoriaICA(ica.categoria);
+    const char *color_aqi = colorCategoriaICA(ica.categoria);
+    int valor_aqi = ica.indice;
+    
+    /* Contaminantes sobre el limite OMS (recomendaciones y comparacion con el pronostico) */
+    int excesos_actuales = 0;
+    if(zona->niveles_actuales.co2 > zona->limites[0]) excesos_actuales++;
+    if(zona->niveles_actuales.so2 > zona->limites[1]) excesos_actuales++;
+    if(zona->niveles_actuales.no2 > zona->limites[2]) excesos_actuales++;
+    if(zona->niveles_actuales.pm25 > zona->limites[3]) excesos_actuales++;
+    
+    // ENCABEZADO DEL REPORTE
+    fprintf(archivo, "┌─────────────────────────────────────────────────────────────────────────────┐\n");
+    fprintf(archivo, "│                           REPORTE DE CALIDAD DEL AIRE                      │\n");
+    fprintf(archivo, "├─────────────────────────────────────────────────────────────────────────────┤\n");
+    fprintf(archivo, "│  Zona: %-30s                                      │\n", zona->nombre);
+    fprintf(archivo, "│  ID de Zona: %-3d                                                         │\n", zona->id_zona);
+    fprintf(archivo, "│  Fecha: %02d/%02d/%04d a las %02d:%02d                                          │\n", 
+            tiempo_local->tm_mday, tiempo_local->tm_mon + 1, tiempo_local->tm_year + 1900,
+            tiempo_local->tm_hour, tiempo_local->tm_min);
+    fprintf(archivo, "│  Dias monitoreados: %-3d                                                   │\n", zona->dias_registrados);
+    fprintf(archivo, "└─────────────────────────────────────────────────────────────────────────────┘\n\n");
+    
+    // ÍNDICE DE CALIDAD DEL AIRE PRINCIPAL
+    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
+    fprintf(archivo, "║                            INDICE DE CALIDAD DEL AIRE                           ║\n");
+    fprintf(archivo, "╠══════════════════════════════════════════════════════════════════════════════════╣\n");
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "║                                 AQI: %3d                                       ║\n", valor_aqi);
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "║                               %s                                               ║\n", categoria_aqi);
+    fprintf(archivo, "║                                Nivel: %s                                       ║\n", color_aqi);
+    fprintf(archivo, "║           Subindices: SO2 %3d | NO2 %3d | PM2.5 %3d                             ║\n",
+            ica.subindices[1], ica.subindices[2], ica.subindices[3]);
+    fprintf(archivo, "║                                                                                  ║\n");
+    
+    if(ica.categoria == 0) {
+        fprintf(archivo, "║    ┌─────────────────────────────────────────────────────────────────────────┐    ║\n");
+        fprintf(archivo, "║    │ * AIRE LIMPIO Y SALUDABLE - CONDICIONES OPTIMAS PARA TODOS            │    ║\n");
+        fprintf(archivo, "║    └─────────────────────────────────────────────────────────────────────────┘    ║\n");
+    } else if(ica.categoria == 1) {
+        fprintf(archivo, "║    ┌─────────────────────────────────────────────────────────────────────────┐    ║\n");
+        fprintf(archivo, "║    │ ! CALIDAD ACEPTABLE - PRECAUCION PARA GRUPOS SENSIBLES                │    ║\n");
+        fprintf(archivo, "║    └─────────────────────────────────────────────────────────────────────────┘    ║\n");
+    } else if(ica.categoria == 2) {
+        fprintf(archivo, "║    ┌─────────────────────────────────────────────────────────────────────────┐    ║\n");
+        fprintf(archivo, "║    │ !! DANINO PARA GRUPOS SENSIBLES - LIMITE ACTIVIDADES EXTERIORES        │    ║\n");
+        fprintf(archivo, "║    └─────────────────────────────────────────────────────────────────────────┘    ║\n");
+    } else if(ica.categoria == 3) {
+        fprintf(archivo, "║    ┌─────────────────────────────────────────────────────────────────────────┐    ║\n");
+        fprintf(archivo, "║    │ !!! AIRE DANINO - TODOS DEBEN REDUCIR EXPOSICION EXTERIOR                │    ║\n");
+        fprintf(archivo, "║    └─────────────────────────────────────────────────────────────────────────┘    ║\n");
+    } else {
+        fprintf(archivo, "║    ┌─────────────────────────────────────────────────────────────────────────┐    ║\n");
+        fprintf(archivo, "║    │ !!!! PELIGROSO - EVITAR COMPLETAMENTE ACTIVIDADES AL AIRE LIBRE            │    ║\n");
+        fprintf(archivo, "║    └─────────────────────────────────────────────────────────────────────────┘    ║\n");
+    }
+    
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n\n");
+    
+    /* NIVELES ACTUALES */
+    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
+    fprintf(archivo, "║                       NIVELES ACTUALES DE CONTAMINANTES                         ║\n");
+    fprintf(archivo, "╠══════════════════════════════════════════════════════════════════════════════════╣\n");
+    fprintf(archivo, "║  Perfil de umbrales: %-58s  ║\n", zona->perfil);
+    fprintf(archivo, "║                                                                                  ║\n");
+    
+    fprintf(archivo, "║  CO2:    %6.1f ppm      │ Limite OMS: %6.1f │ ", zona->niveles_actuales.co2, zona->limites[0]);
+    if(zona->niveles_actuales.co2 <= zona->limites[0]) {
+        fprintf(archivo, "* NORMAL         ║\n");
+    } else {
+        fprintf(archivo, "! EXCEDIDO %.1f%%   ║\n", 
+                (zona->niveles_actuales.co2 / zona->limites[0] - 1) * 100);
+    }
+    
+    fprintf(archivo, "║  SO2:    %6.1f ug/m3   │ Limite OMS: %6.1f │ ", zona->niveles_actuales.so2, zona->limites[1]);
+    if(zona->niveles_actuales.so2 <= zona->limites[1]) {
+        fprintf(archivo, "* NORMAL         ║\n");
+    } else {
+        fprintf(archivo, "! EXCEDIDO %.1f%%   ║\n", 
+                (zona->niveles_actuales.so2 / zona->limites[1] - 1) * 100);
+    }
+    
+    fprintf(archivo, "║  NO2:    %6.1f ug/m3   │ Limite OMS: %6.1f │ ", zona->niveles_actuales.no2, zona->limites[2]);
+    if(zona->niveles_actuales.no2 <= zona->limites[2]) {
+        fprintf(archivo, "* NORMAL         ║\n");
+    } else {
+        fprintf(archivo, "! EXCEDIDO %.1f%%   ║\n", 
+                (zona->niveles_actuales.no2 / zona->limites[2] - 1) * 100);
+    }
+    
+    fprintf(archivo, "║  PM2.5:  %6.1f ug/m3   │ Limite OMS: %6.1f │ ", zona->niveles_actuales.pm25, zona->limites[3]);
+    if(zona->niveles_actuales.pm25 <= zona->limites[3]) {
+        fprintf(archivo, "* NORMAL         ║\n");
+    } else {
+        fprintf(archivo, "! EXCEDIDO %.1f%%   ║\n", 
+                (zona->niveles_actuales.pm25 / zona->limites[3] - 1) * 100);
+    }
+    
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n");
+    fprintf(archivo, "\n");
+    
+    /* CONDICIONES CLIMATICAS */
+    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
+    fprintf(archivo, "║                        CONDICIONES CLIMATICAS ACTUALES                          ║\n");
+    fprintf(archivo, "╠══════════════════════════════════════════════════════════════════════════════════╣\n");
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "║  Temperatura:          %6.1f°C     │   Humedad:             %6.1f%%     ║\n", 
+            zona->clima_actual.temperatura, zona->clima_actual.humedad);
+    fprintf(archivo, "║                                     │                                       ║\n");
+    fprintf(archivo, "║  Velocidad del viento: %6.1f km/h  │   Presion atmosferica: %6.1f hPa  ║\n", 
+            zona->clima_actual.velocidad_viento, zona->clima_actual.presion_atmosferica);
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n\n");
+    
+    /* RECOMENDACIONES DE SALUD */
+    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
+    fprintf(archivo, "║                           RECOMENDACIONES DE SALUD                              ║\n");
+    fprintf(archivo, "╠══════════════════════════════════════════════════════════════════════════════════╣\n");
+    fprintf(archivo, "║                                                                                  ║\n");
+    
+    if(excesos_actuales == 0) {
+        fprintf(archivo, "║  POBLACION GENERAL:                                                            ║\n");
+        fprintf(archivo, "║    * Excelente dia para actividades al aire libre                              ║\n");
+        fprintf(archivo, "║    * Ideal para ejercicio y deportes                                            ║\n");
+        fprintf(archivo, "║    * Perfecto para que los ninos jueguen afuera                                ║\n");
+        fprintf(archivo, "║                                                                                  ║\n");
+        fprintf(archivo, "║  GRUPOS SENSIBLES:                                                             ║\n");
+        fprintf(archivo, "║    * Sin restricciones                                                          ║\n");
+        fprintf(archivo, "║    * Condiciones optimas para personas con asma                                ║\n");
+        fprintf(archivo, "║    * Seguro para adultos mayores y ninos pequenos                              ║\n");
+    } else if(excesos_actuales <= 1) {
+        fprintf(archivo, "║  POBLACION GENERAL:                                                            ║\n");
+        fprintf(archivo, "║    * Actividades al aire libre son aceptables                                  ║\n");
+        fprintf(archivo, "║    ! Considere reducir ejercicio intenso prolongado                            ║\n");
+        fprintf(archivo, "║    * Condiciones normales para la mayoria de personas                          ║\n");
+        fprintf(archivo, "║                                                                                  ║\n");
+        fprintf(archivo, "║  GRUPOS SENSIBLES:                                                             ║\n");
+        fprintf(archivo, "║    ! Personas con asma: limite actividades prolongadas                         ║\n");
+        fprintf(archivo, "║    ! Adultos mayores: prefiera actividades en interiores                       ║\n");
+        fprintf(archivo, "║    ! Ninos: reduzca tiempo de juego al aire libre                              ║\n");
+    } else if(excesos_actuales <= 2) {
+        fprintf(archivo, "║  POBLACION GENERAL:                                                            ║\n");
+        fprintf(archivo, "║    ! Reduzca actividades al aire libre prolongadas                             ║\n");
+        fprintf(archivo, "║    ! Evite ejercicio intenso al aire libre                                     ║\n");
+        fprintf(archivo, "║    ! Use mascarilla si es sensible a la contaminacion                          ║\n");
+        fprintf(archivo, "║                                                                                  ║\n");
+        fprintf(archivo, "║  GRUPOS SENSIBLES:                                                             ║\n");
+        fprintf(archivo, "║    ! Evite actividades al aire libre                                           ║\n");
+        fprintf(archivo, "║    ! Permanezca en interiores cuando sea posible                               ║\n");
+        fprintf(archivo, "║    ! Tenga medicamentos de emergencia a mano                                   ║\n");
+    } else {
+        fprintf(archivo, "║  POBLACION GENERAL:                                                            ║\n");
+        fprintf(archivo, "║    ! Evite todas las actividades al aire libre                                 ║\n");
+        fprintf(archivo, "║    ! Permanezca en interiores                                                   ║\n");
+        fprintf(archivo, "║    ! Use mascarilla si debe salir                                               ║\n");
+        fprintf(archivo, "║    ! Cancele eventos deportivos al aire libre                                   ║\n");
+        fprintf(archivo, "║                                                                                  ║\n");
+        fprintf(archivo, "║  GRUPOS SENSIBLES:                                                             ║\n");
+        fprintf(archivo, "║    !! ALERTA MEDICA: Permanezca en interiores                                   ║\n");
+        fprintf(archivo, "║    !! Tenga medicamentos listos                                                  ║\n");
+        fprintf(archivo, "║    !! Contacte a su medico si presenta sintomas                                  ║\n");
+        fprintf(archivo, "║    !! Busque atencion medica si tiene dificultad respiratoria                   ║\n");
+    }
+    
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n\n");
+    
+    /* PRONOSTICO DE 24 HORAS */
+    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
+    fprintf(archivo, "║                          PRONOSTICO PARA LAS PROXIMAS 24 HORAS                 ║\n");
+    fprintf(archivo, "╠══════════════════════════════════════════════════════════════════════════════════╣\n");
+    fprintf(archivo, "║                                                                                  ║\n");
+    
+    /* Calcular pronostico simple basado en tendencia historica */
+    if(zona->dias_registrados >= 3) {
+        float tendencia_co2 = (registroInstantanea(zona, 0)->niveles.co2 - registroInstantanea(zona, 2)->niveles.co2) / 2.0;
+        float tendencia_so2 = (registroInstantanea(zona, 0)->niveles.so2 - registroInstantanea(zona, 2)->niveles.so2) / 2.0;
+        float tendencia_no2 = (registroInstantanea(zona, 0)->niveles.no2 - registroInstantanea(zona, 2)->niveles.no2) / 2.0;
+        float tendencia_pm25 = (registroInstantanea(zona, 0)->niveles.pm25 - registroInstantanea(zona, 2)->niveles.pm25) / 2.0;
+        
+        float pronostico_co2 = zona->niveles_actuales.co2 + tendencia_co2;
+        float pronostico_so2 = zona->niveles_actuales.so2 + tendencia_so2;
+        float pronostico_no2 = zona->niveles_actuales.no2 + tendencia_no2;
+        float pronostico_pm25 = zona->niveles_actuales.pm25 + tendencia_pm25;
+        
+        fprintf(archivo, "║  NIVELES ESPERADOS:                                                            ║\n");
+        fprintf(archivo, "║                                                                                  ║\n");
+        
+        fprintf(archivo, "║  CO2:   %6.1f ppm     │ Tendencia: ", pronostico_co2);
+        if(tendencia_co2 > 0) {
+            fprintf(archivo, "* SUBIENDO +%5.1f            ║\n", tendencia_co2);
+        } else {
+            fprintf(archivo, "* BAJANDO %6.1f            ║\n", tendencia_co2);
+        }
+        
+        fprintf(archivo, "║  SO2:   %6.1f ug/m3  │ Tendencia: ", pronostico_so2);
+        if(tendencia_so2 > 0) {
+            fprintf(archivo, "* SUBIENDO +%5.1f            ║\n", tendencia_so2);
+        } else {
+            fprintf(archivo, "* BAJANDO %6.1f            ║\n", tendencia_so2);
+        }
+        
+        fprintf(archivo, "║  NO2:   %6.1f ug/m3  │ Tendencia: ", pronostico_no2);
+        if(tendencia_no2 > 0) {
+            fprintf(archivo, "* SUBIENDO +%5.1f            ║\n", tendencia_no2);
+        } else {
+            fprintf(archivo, "* BAJANDO %6.1f            ║\n", tendencia_no2);
+        }
+        
+        fprintf(archivo, "║  PM2.5: %6.1f ug/m3  │ Tendencia: ", pronostico_pm25);
+        if(tendencia_pm25 > 0) {
+            fprintf(archivo, "* SUBIENDO +%5.1f            ║\n", tendencia_pm25);
+        } else {
+            fprintf(archivo, "* BAJANDO %6.1f            ║\n", tendencia_pm25);
+        }
+        
+        /* Calcular excesos proyectados */
+        int excesos_pronostico = 0;
+        if(pronostico_co2 > zona->limites[0]) excesos_pronostico++;
+        if(pronostico_so2 > zona->limites[1]) excesos_pronostico++;
+        if(pronostico_no2 > zona->limites[2]) excesos_pronostico++;
+        if(pronostico_pm25 > zona->limites[3]) excesos_pronostico++;
+        
+        fprintf(archivo, "║                                                                                  ║\n");
+        fprintf(archivo, "║  EXPECTATIVA DE CALIDAD:                                                       ║\n");
+        if(excesos_pronostico < excesos_actuales) {
+            fprintf(archivo, "║    * MEJORANDO - Se espera mejoria en las condiciones                           ║\n");
+        } else if(excesos_pronostico > excesos_actuales) {
+            fprintf(archivo, "║    ! EMPEORANDO - Se espera deterioro en las condiciones                       ║\n");
+        } else {
+            fprintf(archivo, "║    = ESTABLE - Condiciones similares esperadas                                 ║\n");
+        }
+    } else {
+        fprintf(archivo, "║ ! Datos insuficientes para generar pronostico confiable                        ║\n");
+        fprintf(archivo, "║    (Se requieren al menos 3 dias de datos historicos)                           ║\n");
+    }
+    
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n\n");
+    
+    /* RESUMEN ESTADISTICO */
+    if (zona->dias_registrados > 0) {
+        fprintf(archivo, "RESUMEN ESTADISTICO DEL PERIODO:\n");
+        fprintf(archivo, "===============================================================================\n");
+        
+        /* Promedios y extremos calculados al publicar la instantanea */
+        const EstadisticasVentana *estadisticas = &zona->estadisticas;
+        int dias_exceso = contarDiasConExcesosEnPlanos(zona->excesos[0], PALABRAS_MAPA_DIAS, 0,
+                                                       zona->dias_registrados, 1);
+        int dias_buenos = zona->dias_registrados - dias_exceso;
+        float max_co2 = estadisticas->maximo[0], min_co2 = estadisticas->minimo[0];
+        float max_so2 = estadisticas->maximo[1], min_so2 = estadisticas->minimo[1];
+        float max_no2 = estadisticas->maximo[2], min_no2 = estadisticas->minimo[2];
+        float max_pm25 = estadisticas->maximo[3], min_pm25 = estadisticas->minimo[3];
+        int i;
+        
+        fprintf(archivo, "PROMEDIOS DE LOS ULTIMOS %d DIAS:\n",
+                zona->dias_registrados < DIAS_PROMEDIO_MOVIL ? zona->dias_registrados : DIAS_PROMEDIO_MOVIL);
+        fprintf(archivo, "   CO2:   %.1f ppm\n", zona->promedio_30_dias[0]);
+        fprintf(archivo, "   SO2:   %.1f ug/m3\n", zona->promedio_30_dias[1]);
+        fprintf(archivo, "   NO2:   %.1f ug/m3\n", zona->promedio_30_dias[2]);
+        fprintf(archivo, "   PM2.5: %.1f ug/m3\n\n", zona->promedio_30_dias[3]);
+        
+        fprintf(archivo, "PROMEDIOS DEL PERIODO (%d dias):\n", zona->dias_registrados);
+        fprintf(archivo, "   CO2:   %.1f ppm\n", estadisticas->promedio[0]);
+        fprintf(archivo, "   SO2:   %.1f ug/m3\n", estadisticas->promedio[1]);
+        fprintf(archivo, "   NO2:   %.1f ug/m3\n", estadisticas->promedio[2]);
+        fprintf(archivo, "   PM2.5: %.1f ug/m3\n\n", estadisticas->promedio[3]);
+        
+        fprintf(archivo, "VALORES MAXIMOS REGISTRADOS:\n");
+        fprintf(archivo, "   CO2:   %.1f ppm\n", max_co2);
+        fprintf(archivo, "   SO2:   %.1f ug/m3\n", max_so2);
+        fprintf(archivo, "   NO2:   %.1f ug/m3\n", max_no2);
+        fprintf(archivo, "   PM2.5: %.1f ug/m3\n\n", max_pm25);
+        
+        fprintf(archivo, "VALORES MINIMOS REGISTRADOS:\n");
+        fprintf(archivo, "   CO2:   %.1f ppm\n", min_co2);
+        fprintf(archivo, "   SO2:   %.1f ug/m3\n", min_so2);
+        fprintf(archivo, "   NO2:   %.1f ug/m3\n", min_no2);
+        fprintf(archivo, "   PM2.5: %.1f ug/m3\n\n", min_pm25);
+        
+        /* Percentiles de todo el historico (resumenes anuales de la zona) */
+        char *unidades[] = {"ppm", "ug/m3", "ug/m3", "ug/m3"};
+        char *etiquetas[] = {"CO2:  ", "SO2:  ", "NO2:  ", "PM2.5:"};
+        fprintf(archivo, "PERCENTILES 95 / 99 DE TODO EL HISTORICO:\n");
+        for (i = 0; i < 4; i++) {
+            DigestCuantiles digest;
+            combinarCuantilesZonas(zonas, zona_id, 0, 9999, i, &digest);
+            float p95 = cuantilDigest(&digest, 0.95);
+            fprintf(archivo, "   %s %.1f / %.1f %s (%.0f lecturas)\n", etiquetas[i], p95,
+                    cuantilDigest(&digest, 0.99), unidades[i], digest.total);
+        }
+        fprintf(archivo, "\n");
+        
+        fprintf(archivo, "ANALISIS DE CALIDAD:\n");
+        fprintf(archivo, "   Dias con buena calidad:    %2d de %2d (%.1f%%)\n", 
+                dias_buenos, zona->dias_registrados, 
+                (float)dias_buenos / zona->dias_registrados * 100.0);
+        fprintf(archivo, "   Dias con excesos OMS:      %2d de %2d (%.1f%%)\n", 
+                dias_exceso, zona->dias_registrados, 
+                (float)dias_exceso / zona->dias_registrados * 100.0);
+        
+        if(dias_exceso == 0) {
+            fprintf(archivo, "   EXCELENTE: Sin dias con excesos registrados\n");
+        } else if(dias_exceso <= zona->dias_registrados * 0.1) {
+            fprintf(archivo, "   BUENO: Muy pocos dias con excesos\n");
+        } else if(dias_exceso <= zona->dias_registrados * 0.3) {
+            fprintf(archivo, "   MODERADO: Algunos dias con excesos\n");
+        } else {
+            fprintf(archivo, "   PREOCUPANTE: Muchos dias con excesos\n");
+        }
+    }
+    
+    fprintf(archivo, "\n");
+    
+    /* PIE DEL REPORTE */
+    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
+    fprintf(archivo, "║                              INFORMACION ADICIONAL                              ║\n");
+    fprintf(archivo, "╠══════════════════════════════════════════════════════════════════════════════════╣\n");
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "║  Para actualizaciones en tiempo real:    www.airnow-quito.gov.ec             ║\n");
+    fprintf(archivo, "║  Emergencias ambientales:                911                                  ║\n");
+    fprintf(archivo, "║  Salud respiratoria MSP:                  171                                  ║\n");
+    fprintf(archivo, "║  Los limites utilizados corresponden a las Guias OMS 2021                     ║\n");
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "║                Cuidemos juntos la calidad del aire de Quito                   ║\n");
+    fprintf(archivo, "║                                                                                  ║\n");
+    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n");
+    fprintf(archivo, "                                                                                    \n");
+    fprintf(archivo, "              ███████ ███  ██ ██████   █████  ███████  ██████  ███████ ██████   █████  ██████  ████████\n");
+    fprintf(archivo, "              ██      ████ ██ ██   ██ ██   ██ ██      ██   ██ ██      ██   ██ ██   ██ ██   ██    ██   \n");
+    fprintf(archivo, "              █████   ██ ████ ██   ██ ██   ██ █████   ██████  █████   ██████  ██   ██ ██████     ██   \n");
+    fprintf(archivo, "              ██      ██  ███ ██   ██ ██   ██ ██      ██   ██ ██      ██      ██   ██ ██   ██    ██   \n");
+    fprintf(archivo, "              ███████ ██   ██ ██████   █████  ██      ██   ██ ███████ ██       █████  ██   ██    ██   \n");
+    fprintf(archivo, "                                                                                    \n");
+    
+    fclose(archivo);
+    liberarInstantanea(zona);
+    printf("Reporte AirQuality exportado exitosamente: %s\n", nombre_archivo);
+    liberarArena(arena);
+}
 
-        // Resumen de cambios del día
-        if(cambios_dia > 0) {
-            printf("\nRESUMEN: %d cambio(s) realizado(s) en el dia %d\n", cambios_dia, dia + 1);
-            cambios_realizados += cambios_dia;
+void menuExportarReportes(ZonaUrbana zonas[]) {
+    printf("=== EXPORTAR REPORTES ===\n");
+    printf("==========================\n\n");
+    
+    int tipo_reporte, val;
+    printf("1. Reporte de una zona\n");
+    printf("2. Serie historica del ICA (todas las zonas, CSV)\n");
+    do {
+        printf("Seleccione el tipo de reporte (1-2): ");
+        val = scanf("%d", &tipo_reporte);
+        fflush(stdin);
+        if(val != 1 || tipo_reporte < 1 || tipo_reporte > 2) {
+            printf("Opcion invalida. Por favor, intente de nuevo.\n");
         }
-        
-        // Preguntar si quiere editar otro día
-        do {
-            printf("\n¿Desea editar otro dia de esta zona? (s/n): ");
-            scanf(" %c", &continuar_editando);
-            fflush(stdin);
-        } while(continuar_editando != 's' && continuar_editando != 'S' && 
-                continuar_editando != 'n' && continuar_editando != 'N');
-                
-    } while(continuar_editando == 's' || continuar_editando == 'S');
-
-    // Guardar cambios si se realizaron
-    if(cambios_realizados > 0) {
-        guardarZona(zona);
-        printf("\nDATOS GUARDADOS: %d cambio(s) total(es) en %s\n", 
-               cambios_realizados, zona->nombre);
+    } while(val != 1 || tipo_reporte < 1 || tipo_reporte > 2);
+    
+    if(tipo_reporte == 2) {
+        double inicio = milisegundosActuales();
+        int filas = exportarSerieICA(zonas, ARCHIVO_SERIE_ICA);
+        if(filas < 0) {
+            printf("Error al exportar la serie del ICA.\n");
+        } else {
+            printf("Serie del ICA exportada en %s: %d dia(s) en %.2f ms\n", ARCHIVO_SERIE_ICA, filas,
+                   milisegundosActuales() - inicio);
+        }
+        printf("\nPresione Enter para continuar...");
+        getchar();
+        return;
     }
     
-    // Preguntar si quiere editar otra zona
+    printf("\nZonas disponibles:\n");
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        printf("%d. %s\n", zonas[i].id_zona, zonas[i].nombre);
+    }
+    
+    int zona_id;
     do {
-        printf("\n¿Desea editar datos de otra zona? (s/n): ");
-        scanf(" %c", &continuar_editando);
+        printf("\nIngrese el ID de la zona (1-%d): ", MAX_ZONAS);
+        val = scanf("%d", &zona_id);
         fflush(stdin);
-    } while(continuar_editando != 's' && continuar_editando != 'S' && 
-            continuar_editando != 'n' && continuar_editando != 'N');
+        
+        if(val != 1 || zona_id < 1 || zona_id > MAX_ZONAS) {
+            printf("ID de zona inválido. Por favor, intente de nuevo.\n");
+        }
+    } while(val != 1 || zona_id < 1 || zona_id > MAX_ZONAS);
     
-    if(continuar_editando == 's' || continuar_editando == 'S') {
-        corregirDatosIngresados(zonas);
-    }
+    exportarReportePorZona(zonas, zona_id);
     
-    printf("\nEditor finalizado. Total de cambios realizados: %d\n", cambios_realizados);
+    printf("\nPresione Enter para continuar...");
+    getchar();
 }
 
 
+// ===== FUNCIONES PARA MALLA DE CONTAMINACION DE LA CIUDAD =====
 
-// ===== FUNCIONES PARA MANEJO DE FECHAS =====
+// Coordenadas de las estaciones de monitoreo de Quito (grados decimales)
+CoordenadasZona coordenadasPorDefecto(int id_zona) {
+    CoordenadasZona coordenadas;
+    switch(id_zona) {
+        case 1: coordenadas.latitud = -0.2202; coordenadas.longitud = -78.5123; break; // Centro Historico
+        case 2: coordenadas.latitud = -0.1807; coordenadas.longitud = -78.4847; break; // La Carolina
+        case 3: coordenadas.latitud = -0.2950; coordenadas.longitud = -78.5530; break; // Quitumbe
+        case 4: coordenadas.latitud = -0.3070; coordenadas.longitud = -78.4460; break; // Los Chillos
+        case 5: coordenadas.latitud = -0.2050; coordenadas.longitud = -78.4200; break; // Cumbaya - Tumbaco
+        default: coordenadas.latitud = -0.2202; coordenadas.longitud = -78.5123; break;
+    }
+    return coordenadas;
+}
 
-void mostrarFecha(Fecha fecha) {
-    printf("%02d/%02d/%04d", fecha.dia, fecha.mes, fecha.año);
+// Obtiene el nivel de un contaminante por tipo (0=CO2, 1=SO2, 2=NO2, 3=PM2.5)
+float obtenerNivelContaminante(NivelesContaminacion niveles, int tipo_contaminante) {
+    switch(tipo_contaminante) {
+        case 0: return niveles.co2;
+        case 1: return niveles.so2;
+        case 2: return niveles.no2;
+        case 3: return niveles.pm25;
+        default: return 0.0;
+    }
 }
 
-int compararFechas(Fecha f1, Fecha f2) {
-    if (f1.año != f2.año) return f1.año - f2.año;
-    if (f1.mes != f2.mes) return f1.mes - f2.mes;
-    return f1.dia - f2.dia;
+// Coseno aproximado por serie de Taylor sin usar math.h (válido para |x| <= pi/2)
+float cosenoAproximado(float x) {
+    float x2 = x * x;
+    return 1.0 - x2 / 2.0 * (1.0 - x2 / 12.0 * (1.0 - x2 / 30.0 * (1.0 - x2 / 56.0)));
 }
 
-void mostrarHistorialConFechas(ZonaUrbana zonas[]) {
-    printf("\n");
-    printf("=======================================================\n");
-    printf("           HISTORIAL DE DATOS CON FECHAS              \n");
-    printf("=======================================================\n\n");
+// Genera un ráster PGM (P5, 8 bits) de la ciudad interpolando los valores de todas las
+// zonas con peso inverso al cuadrado de la distancia (IDW, potencia 2).
+// La escala del gris va de 0 a 2 veces el límite OMS (umbral de alerta roja).
+// Retorna 1 si el archivo se generó, 0 en caso de error.
+int generarMallaContaminacion(ZonaUrbana zonas[], int tipo_contaminante, int usar_prediccion,
+                              int filas, int columnas, char *nombre_archivo) {
+    float lat_estacion[MAX_ZONAS], lon_estacion[MAX_ZONAS], valor_estacion[MAX_ZONAS];
+    int num_estaciones = 0;
+    
+    // Valores de cada estación (actuales o predichos a 24h)
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        if(zonas[i].dias_registrados == 0) continue;
+        
+        NivelesContaminacion niveles = zonas[i].niveles_actuales;
+        if(usar_prediccion && zonas[i].dias_registrados >= 3) {
+            niveles = predecirNivelesZona24h(&zonas[i], NULL);
+        }
+        lat_estacion[num_estaciones] = zonas[i].ubicacion.latitud;
+        lon_estacion[num_estaciones] = zonas[i].ubicacion.longitud;
+        valor_estacion[num_estaciones] = obtenerNivelContaminante(niveles, tipo_contaminante);
+        num_estaciones++;
+    }
     
-    int zona_seleccionada, val;
+    if(num_estaciones == 0 || filas <= 0 || columnas <= 0) {
+        return 0;
+    }
     
-    // Mostrar zonas disponibles
-    printf("ZONAS DISPONIBLES:\n");
-    printf("-------------------------------------------------------\n");
+    // Área cubierta: estaciones más un margen
+    float lat_min = lat_estacion[0], lat_max = lat_estacion[0];
+    float lon_min = lon_estacion[0], lon_max = lon_estacion[0];
+    for(int z = 1; z < num_estaciones; z++) {
+        if(lat_estacion[z] < lat_min) lat_min = lat_estacion[z];
+        if(lat_estacion[z] > lat_max) lat_max = lat_estacion[z];
+        if(lon_estacion[z] < lon_min) lon_min = lon_estacion[z];
+        if(lon_estacion[z] > lon_max) lon_max = lon_estacion[z];
+    }
+    lat_min -= MARGEN_MALLA; lat_max += MARGEN_MALLA;
+    lon_min -= MARGEN_MALLA; lon_max += MARGEN_MALLA;
+    
+    float paso_lat = (lat_max - lat_min) / filas;
+    float paso_lon = (lon_max - lon_min) / columnas;
+    
+    // Un grado de longitud mide cos(latitud) grados de latitud
+    float factor_lon = cosenoAproximado((lat_min + lat_max) / 2.0 * 3.14159265 / 180.0);
+    
+    // Distancias al cuadrado precalculadas por fila y por columna, con las estaciones
+    // contiguas en memoria para que el bucle interno recorra posiciones consecutivas
+    float *dy2 = malloc((size_t)filas * num_estaciones * sizeof(float));
+    float *dx2 = malloc((size_t)columnas * num_estaciones * sizeof(float));
+    unsigned char *franja = malloc((size_t)TAM_BLOQUE_MALLA * columnas);
+    
+    if(dy2 == NULL || dx2 == NULL || franja == NULL) {
+        free(dy2); free(dx2); free(franja);
+        return 0;
+    }
+    
+    for(int fila = 0; fila < filas; fila++) {
+        float lat = lat_max - (fila + 0.5) * paso_lat; // Fila 0 = norte
+        for(int z = 0; z < num_estaciones; z++) {
+            float d = lat - lat_estacion[z];
+            dy2[fila * num_estaciones + z] = d * d;
+        }
+    }
+    for(int col = 0; col < columnas; col++) {
+        float lon = lon_min + (col + 0.5) * paso_lon;
+        for(int z = 0; z < num_estaciones; z++) {
+            float d = (lon - lon_estacion[z]) * factor_lon;
+            dx2[col * num_estaciones + z] = d * d;
+        }
+    }
+    
+    FILE *archivo = fopen(nombre_archivo, "wb");
+    if(archivo == NULL) {
+        free(dy2); free(dx2); free(franja);
+        return 0;
+    }
+    
+    float limite = obtenerLimiteOMS(tipo_contaminante);
+    float escala = 255.0 / (2.0 * limite);
+    
+    fprintf(archivo, "P5\n");
+    fprintf(archivo, "# Malla IDW - contaminante %d - %s\n", tipo_contaminante,
+            usar_prediccion ? "prediccion 24h" : "niveles actuales");
+    fprintf(archivo, "# lat %.4f a %.4f, lon %.4f a %.4f, gris 255 = %.1f\n",
+            lat_max, lat_min, lon_min, lon_max, 2.0 * limite);
+    fprintf(archivo, "%d %d\n255\n", columnas, filas);
+    
+    // Recorrido por bloques: cada franja de TAM_BLOQUE_MALLA filas se procesa en
+    // bloques cuadrados para reutilizar en caché las distancias de sus columnas
+    for(int fila_inicio = 0; fila_inicio < filas; fila_inicio += TAM_BLOQUE_MALLA) {
+        int fila_fin = fila_inicio + TAM_BLOQUE_MALLA;
+        if(fila_fin > filas) fila_fin = filas;
+        
+        for(int col_inicio = 0; col_inicio < columnas; col_inicio += TAM_BLOQUE_MALLA) {
+            int col_fin = col_inicio + TAM_BLOQUE_MALLA;
+            if(col_fin > columnas) col_fin = columnas;
+            
+            for(int fila = fila_inicio; fila < fila_fin; fila++) {
+                float *dy2_fila = &dy2[fila * num_estaciones];
+                unsigned char *salida = &franja[(fila - fila_inicio) * columnas];
+                
+                for(int col = col_inicio; col < col_fin; col++) {
+                    float *dx2_col = &dx2[col * num_estaciones];
+                    float suma_pesos = 0.0, suma_valores = 0.0;
+                    float valor = -1.0;
+                    
+                    for(int z = 0; z < num_estaciones; z++) {
+                        float distancia2 = dy2_fila[z] + dx2_col[z];
+                        if(distancia2 <= 0.0) {
+                            valor = valor_estacion[z]; // Celda sobre la estación
+                            break;
+                        }
+                        float peso = 1.0 / distancia2;
+                        suma_pesos += peso;
+                        suma_valores += peso * valor_estacion[z];
+                    }
+                    if(valor < 0.0) {
+                        valor = suma_valores / suma_pesos;
+                    }
+                    
+                    float gris = valor * escala + 0.5;
+                    if(gris > 255.0) gris = 255.0;
+                    if(gris < 0.0) gris = 0.0;
+                    salida[col] = (unsigned char)gris;
+                }
+            }
+        }
+        
+        fwrite(franja, 1, (size_t)(fila_fin - fila_inicio) * columnas, archivo);
+    }
+    
+    fclose(archivo);
+    free(dy2);
+    free(dx2);
+    free(franja);
+    return 1;
+}
+
+void menuMallaContaminacion(ZonaUrbana zonas[]) {
+    printf("=== MAPA DE CONTAMINACION DE LA CIUDAD ===\n");
+    printf("===========================================\n\n");
+    
+    printf("Estaciones de monitoreo:\n");
     for(int i = 0; i < MAX_ZONAS; i++) {
-        printf("  %d. %-25s", zonas[i].id_zona, zonas[i].nombre);
-        if(zonas[i].dias_registrados > 0) {
-            printf("(%d dias registrados)\n", zonas[i].dias_registrados);
-        } else {
-            printf("(Sin datos)\n");
+        printf("%d. %-22s (%.4f, %.4f)", zonas[i].id_zona, zonas[i].nombre,
+               zonas[i].ubicacion.latitud, zonas[i].ubicacion.longitud);
+        if(zonas[i].dias_registrados == 0) {
+            printf(" - Sin datos");
         }
+        printf("\n");
     }
-    printf("-------------------------------------------------------\n");
     
-    // Seleccionar zona
+    int contaminante, fuente, filas, columnas, val;
+    
+    printf("\nContaminantes: 1. CO2  2. SO2  3. NO2  4. PM2.5\n");
     do {
-        printf("\nSeleccione la zona para ver historial (1-%d): ", MAX_ZONAS);
-        val = scanf("%d", &zona_seleccionada);
+        printf("Seleccione el contaminante (1-4): ");
+        val = scanf("%d", &contaminante);
         fflush(stdin);
-        
-        if(val != 1 || zona_seleccionada < 1 || zona_seleccionada > MAX_ZONAS) {
-            printf("ERROR: Opcion invalida. Por favor, intente de nuevo.\n");
+        if(val != 1 || contaminante < 1 || contaminante > 4) {
+            printf("Opcion invalida. Por favor, intente de nuevo.\n");
         }
-    } while(val != 1 || zona_seleccionada < 1 || zona_seleccionada > MAX_ZONAS);
+    } while(val != 1 || contaminante < 1 || contaminante > 4);
     
-    zona_seleccionada--;
+    do {
+        printf("Valores a interpolar (1. Actuales  2. Prediccion 24h): ");
+        val = scanf("%d", &fuente);
+        fflush(stdin);
+        if(val != 1 || fuente < 1 || fuente > 2) {
+            printf("Opcion invalida. Por favor, intente de nuevo.\n");
+        }
+    } while(val != 1 || fuente < 1 || fuente > 2);
     
-    if(zonas[zona_seleccionada].dias_registrados == 0) {
-        printf("\nERROR: La zona '%s' no tiene datos registrados.\n", 
-               zonas[zona_seleccionada].nombre);
-        printf("       Registre datos primero usando la opcion 1 del menu.\n");
-        return;
+    do {
+        printf("Filas del mapa (10-%d): ", MAX_DIMENSION_MALLA);
+        val = scanf("%d", &filas);
+        fflush(stdin);
+        if(val != 1 || filas < 10 || filas > MAX_DIMENSION_MALLA) {
+            printf("Valor invalido. Por favor, intente de nuevo.\n");
+        }
+    } while(val != 1 || filas < 10 || filas > MAX_DIMENSION_MALLA);
+    
+    do {
+        printf("Columnas del mapa (10-%d): ", MAX_DIMENSION_MALLA);
+        val = scanf("%d", &columnas);
+        fflush(stdin);
+        if(val != 1 || columnas < 10 || columnas > MAX_DIMENSION_MALLA) {
+            printf("Valor invalido. Por favor, intente de nuevo.\n");
+        }
+    } while(val != 1 || columnas < 10 || columnas > MAX_DIMENSION_MALLA);
+    
+    char *nombres[] = {"CO2", "SO2", "NO2", "PM25"};
+    char nombre_archivo[100];
+    sprintf(nombre_archivo, "mapa_%s_%s.pgm", nombres[contaminante - 1],
+            fuente == 2 ? "prediccion" : "actual");
+    
+    clock_t inicio = clock();
+    int generado = generarMallaContaminacion(zonas, contaminante - 1, fuente == 2,
+                                             filas, columnas, nombre_archivo);
+    double segundos = (double)(clock() - inicio) / CLOCKS_PER_SEC;
+    
+    if(generado) {
+        printf("\nMapa %dx%d exportado: %s (%.3f s)\n", columnas, filas, nombre_archivo, segundos);
+        printf("Escala de grises: negro = 0, blanco = 2x limite OMS (%.1f)\n",
+               2.0 * obtenerLimiteOMS(contaminante - 1));
+    } else {
+        printf("\nERROR: No se pudo generar el mapa (sin zonas con datos o sin memoria).\n");
     }
     
-    printf("\n");
-    printf("=======================================================\n");
-    printf("  HISTORIAL DETALLADO: %s\n", zonas[zona_seleccionada].nombre);
-    printf("=======================================================\n");
-    printf("Total de registros: %d dias\n", zonas[zona_seleccionada].dias_registrados);
-    printf("=======================================================\n\n");
+    printf("\nPresione Enter para continuar...");
+    getchar();
+}
+
+// ============ FUNCIONES PARA CORRELACIONES ENTRE VARIABLES Y ZONAS ============
+
+// Variable 0-3: contaminantes (CO2, SO2, NO2, PM2.5); 4-7: temperatura, viento,
+// humedad y presión
+float variableDeRegistro(const RegistroHistorico *registro, int variable) {
+    switch(variable) {
+        case 0: return registro->niveles.co2;
+        case 1: return registro->niveles.so2;
+        case 2: return registro->niveles.no2;
+        case 3: return registro->niveles.pm25;
+        case 4: return registro->clima.temperatura;
+        case 5: return registro->clima.velocidad_viento;
+        case 6: return registro->clima.humedad;
+        default: return registro->clima.presion_atmosferica;
+    }
+}
+
+// Arma las series de todas las zonas sobre el eje de fechas común (los últimos
+// MAX_DIAS_CORRELACION días) y sus sumas acumuladas. Devuelve 0 si ninguna zona
+// tiene datos o no hay memoria.
+int prepararSeriesCorrelacion(ZonaUrbana zonas[], SeriesCorrelacion *series, ArenaTemporal *arena) {
+    long mas_reciente = 0, mas_antiguo = 0;
+    int hay_datos = 0;
+    
+    memset(series, 0, sizeof(SeriesCorrelacion));
+    for(int z = 0; z < MAX_ZONAS; z++) {
+        int total = diasTotalesZona(&zonas[z]);
+        if(total == 0) continue;
+        long reciente = numeroDeDia(zonas[z].historico_fechas[0].fecha);
+        long antiguo = numeroDeDia(registroHistoricoCompleto(&zonas[z], total - 1).fecha);
+        if(!hay_datos || reciente > mas_reciente) mas_reciente = reciente;
+        if(!hay_datos || antiguo < mas_antiguo) mas_antiguo = antiguo;
+        hay_datos = 1;
+    }
+    if(!hay_datos || mas_antiguo > mas_reciente) {
+        return 0;
+    }
     
-    // Encabezados de tabla mejorados
-    printf("+-----------+--------+--------+--------+--------+---------------+\n");
-    printf("| Fecha     |  CO2   |  SO2   |  NO2   | PM2.5  | Estado General|\n");
-    printf("| (dd/mm/aa)| (ppm)  |(ug/m3) |(ug/m3) |(ug/m3) |               |\n");
-    printf("+-----------+--------+--------+--------+--------+---------------+\n");
+    int n = mas_reciente - mas_antiguo + 1;
+    if(n > MAX_DIAS_CORRELACION) n = MAX_DIAS_CORRELACION;
+    series->num_dias = n;
+    series->primer_dia = mas_reciente - n + 1;
+    series->valores = reservarArena(arena, (size_t)COLUMNAS_CORRELACION * n * sizeof(float));
+    series->sumas = reservarArena(arena, (size_t)COLUMNAS_CORRELACION * (n + 1) * sizeof(double));
+    series->sumas_cuadrados = reservarArena(arena, (size_t)COLUMNAS_CORRELACION * (n + 1) * sizeof(double));
+    unsigned char *presente = reservarArena(arena, n);
+    if(series->valores == NULL || series->sumas == NULL || series->sumas_cuadrados == NULL || presente == NULL) {
+        return 0;
+    }
+    memset(series->valores, 0, (size_t)COLUMNAS_CORRELACION * n * sizeof(float));
     
-    // Mostrar todos los días registrados
-    for(int i = 0; i < zonas[zona_seleccionada].dias_registrados; i++) {
-        // Contar excesos para determinar estado
-        int excesos = 0;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.co2 > LIMITE_CO2_OMS) excesos++;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.so2 > LIMITE_SO2_OMS) excesos++;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.no2 > LIMITE_NO2_OMS) excesos++;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.pm25 > LIMITE_PM25_OMS) excesos++;
+    for(int z = 0; z < MAX_ZONAS; z++) {
+        float *columnas = &series->valores[(size_t)z * VARIABLES_CORRELACION * n];
+        int primero = n, ultimo = -1;
         
-        char estado[16];
-        if(excesos == 0) {
-            strcpy(estado, "Bueno");
-        } else if(excesos == 1) {
-            strcpy(estado, "Moderado");
-        } else if(excesos == 2) {
-            strcpy(estado, "Danino");
+        // Del más reciente al más antiguo: si una fecha se repite, queda el registro más reciente
+        memset(presente, 0, n);
+        for(int d = 0; d < diasTotalesZona(&zonas[z]); d++) {
+            RegistroHistorico registro = registroHistoricoCompleto(&zonas[z], d);
+            long posicion = numeroDeDia(registro.fecha) - series->primer_dia;
+            if(posicion < 0 || posicion >= n || presente[posicion]) continue;
+            presente[posicion] = 1;
+            for(int v = 0; v < VARIABLES_CORRELACION; v++) {
+                columnas[v * n + posicion] = variableDeRegistro(&registro, v);
+            }
+            if(posicion < primero) primero = posicion;
+            if(posicion > ultimo) ultimo = posicion;
+        }
+        if(ultimo < 0) {
+            primero = ultimo = 0; // Columna vacía: inicio == fin
         } else {
-            strcpy(estado, "Peligroso");
+            ultimo++;
         }
         
-        // Mostrar fila de datos con formato alineado
-        printf("| %02d/%02d/%02d | %6.1f | %6.1f | %6.1f | %6.1f | %-13s |\n",
-               zonas[zona_seleccionada].historico_fechas[i].fecha.dia,
-               zonas[zona_seleccionada].historico_fechas[i].fecha.mes,
-               zonas[zona_seleccionada].historico_fechas[i].fecha.año % 100,
-               zonas[zona_seleccionada].historico_fechas[i].niveles.co2,
-               zonas[zona_seleccionada].historico_fechas[i].niveles.so2,
-               zonas[zona_seleccionada].historico_fechas[i].niveles.no2,
-               zonas[zona_seleccionada].historico_fechas[i].niveles.pm25,
-               estado);
-        
-        // Mostrar contaminantes que exceden límites en línea separada
-        if(excesos > 0) {
-            printf("|           |        |        |        |        | Exceden: ");
-            int primero = 1;
-            if(zonas[zona_seleccionada].historico_fechas[i].niveles.co2 > LIMITE_CO2_OMS) {
-                if(!primero) printf(", ");
-                printf("CO2");
-                primero = 0;
+        // Días intermedios sin lectura: interpolación lineal entre los vecinos con lectura
+        int anterior = primero;
+        for(int t = primero + 1; t < ultimo; t++) {
+            if(!presente[t]) continue;
+            for(int hueco = anterior + 1; hueco < t; hueco++) {
+                float peso = (float)(hueco - anterior) / (t - anterior);
+                for(int v = 0; v < VARIABLES_CORRELACION; v++) {
+                    float *columna = &columnas[v * n];
+                    columna[hueco] = interpolarLineal(columna[anterior], columna[t], peso);
+                }
+                series->interpolados++;
             }
-            if(zonas[zona_seleccionada].historico_fechas[i].niveles.so2 > LIMITE_SO2_OMS) {
-                if(!primero) printf(", ");
-                printf("SO2");
-                primero = 0;
+            anterior = t;
+        }
+        
+        for(int v = 0; v < VARIABLES_CORRELACION; v++) {
+            int c = z * VARIABLES_CORRELACION + v;
+            float *columna = &series->valores[(size_t)c * n];
+            double *suma = &series->sumas[(size_t)c * (n + 1)];
+            double *suma_cuadrados = &series->sumas_cuadrados[(size_t)c * (n + 1)];
+            
+            series->inicio[c] = primero;
+            series->fin[c] = ultimo;
+            suma[0] = suma_cuadrados[0] = 0.0;
+            for(int t = 0; t < n; t++) {
+                suma[t + 1] = suma[t] + columna[t];
+                suma_cuadrados[t + 1] = suma_cuadrados[t] + (double)columna[t] * columna[t];
             }
-            if(zonas[zona_seleccionada].historico_fechas[i].niveles.no2 > LIMITE_NO2_OMS) {
-                if(!primero) printf(", ");
-                printf("NO2");
-                primero = 0;
+        }
+    }
+    return 1;
+}
+
+// Correlación de Pearson entre x[t] e y[t + desfase] en los días que tienen en común,
+// a partir del producto cruzado y de las sumas acumuladas. Devuelve 0 si hay menos de
+// MIN_DIAS_CORRELACION días en común o alguna de las series es constante.
+int correlacionDeSumas(SeriesCorrelacion *series, int columna_x, int columna_y, int desfase,
+                       double producto, float *correlacion) {
+    int desde = series->inicio[columna_x];
+    int hasta = series->fin[columna_x];
+    if(series->inicio[columna_y] - desfase > desde) desde = series->inicio[columna_y] - desfase;
+    if(series->fin[columna_y] - desfase < hasta) hasta = series->fin[columna_y] - desfase;
+    int n = hasta - desde;
+    if(n < MIN_DIAS_CORRELACION) {
+        return 0;
+    }
+    
+    double *suma_x = &series->sumas[(size_t)columna_x * (series->num_dias + 1)];
+    double *suma_y = &series->sumas[(size_t)columna_y * (series->num_dias + 1)];
+    double *cuadrados_x = &series->sumas_cuadrados[(size_t)columna_x * (series->num_dias + 1)];
+    double *cuadrados_y = &series->sumas_cuadrados[(size_t)columna_y * (series->num_dias + 1)];
+    
+    double sx = suma_x[hasta] - suma_x[desde];
+    double sy = suma_y[hasta + desfase] - suma_y[desde + desfase];
+    double sxx = cuadrados_x[hasta] - cuadrados_x[desde];
+    double syy = cuadrados_y[hasta + desfase] - cuadrados_y[desde + desfase];
+    double varianza_x = n * sxx - sx * sx;
+    double varianza_y = n * syy - sy * sy;
+    if(varianza_x <= 0 || varianza_y <= 0) {
+        return 0;
+    }
+    
+    // Raíces por separado: el producto de las varianzas puede superar el rango en que
+    // raizCuadrada() converge en sus 30 iteraciones
+    float r = (n * producto - sx * sy) / (raizCuadrada(varianza_x) * raizCuadrada(varianza_y));
+    if(r > 1.0) r = 1.0;
+    if(r < -1.0) r = -1.0;
+    *correlacion = r;
+    return 1;
+}
+
+// Matriz de correlación (mismo día) de todas las columnas. Los productos cruzados se
+// acumulan por bloques de días para que las columnas del bloque sigan en caché
+// mientras se combinan todos los pares.
+void calcularMatrizCorrelacion(SeriesCorrelacion *series, float *matriz) {
+    int n = series->num_dias;
+    double productos[COLUMNAS_CORRELACION][COLUMNAS_CORRELACION];
+    memset(productos, 0, sizeof(productos));
+    
+    for(int bloque = 0; bloque < n; bloque += TAM_BLOQUE_CORRELACION) {
+        int fin_bloque = bloque + TAM_BLOQUE_CORRELACION;
+        if(fin_bloque > n) fin_bloque = n;
+        
+        for(int i = 0; i < COLUMNAS_CORRELACION; i++) {
+            if(series->inicio[i] == series->fin[i]) continue;
+            float *x = &series->valores[(size_t)i * n];
+            for(int j = i; j < COLUMNAS_CORRELACION; j++) {
+                if(series->inicio[j] == series->fin[j]) continue;
+                float *y = &series->valores[(size_t)j * n];
+                double acumulado = 0.0;
+                for(int t = bloque; t < fin_bloque; t++) {
+                    acumulado += (double)x[t] * y[t];
+                }
+                productos[i][j] += acumulado;
             }
-            if(zonas[zona_seleccionada].historico_fechas[i].niveles.pm25 > LIMITE_PM25_OMS) {
-                if(!primero) printf(", ");
-                printf("PM2.5");
+        }
+    }
+    
+    for(int i = 0; i < COLUMNAS_CORRELACION; i++) {
+        for(int j = i; j < COLUMNAS_CORRELACION; j++) {
+            float r;
+            if(!correlacionDeSumas(series, i, j, 0, productos[i][j], &r)) {
+                r = CORRELACION_NO_DISPONIBLE;
             }
-            
-            // Completar la línea con espacios
-            printf("%*s|\n", (int)(6 - strlen("Exceden: ")), "");
+            matriz[i * COLUMNAS_CORRELACION + j] = r;
+            matriz[j * COLUMNAS_CORRELACION + i] = r;
         }
+    }
+}
+
+// Correlaciones de x[t] con y[t + d] para d = -MAX_DESFASE_CORRELACION..+MAX_DESFASE_CORRELACION
+// (resultados[d + MAX_DESFASE_CORRELACION]). Todos los desfases se calculan sobre el mismo
+// bloque de días antes de pasar al siguiente.
+void correlacionesDesfasadas(SeriesCorrelacion *series, int columna_x, int columna_y, float resultados[]) {
+    int n = series->num_dias;
+    float *x = &series->valores[(size_t)columna_x * n];
+    float *y = &series->valores[(size_t)columna_y * n];
+    double productos[2 * MAX_DESFASE_CORRELACION + 1];
+    memset(productos, 0, sizeof(productos));
+    
+    for(int bloque = 0; bloque < n; bloque += TAM_BLOQUE_CORRELACION) {
+        int fin_bloque = bloque + TAM_BLOQUE_CORRELACION;
+        if(fin_bloque > n) fin_bloque = n;
         
-        // Separador entre filas cada 5 registros para mejor legibilidad
-        if((i + 1) % 5 == 0 && i < zonas[zona_seleccionada].dias_registrados - 1) {
-            printf("+-----------+--------+--------+--------+--------+---------------+\n");
+        for(int d = -MAX_DESFASE_CORRELACION; d <= MAX_DESFASE_CORRELACION; d++) {
+            int desde = bloque, hasta = fin_bloque;
+            if(desde + d < 0) desde = -d;
+            if(hasta + d > n) hasta = n - d;
+            double acumulado = 0.0;
+            for(int t = desde; t < hasta; t++) {
+                acumulado += (double)x[t] * y[t + d];
+            }
+            productos[d + MAX_DESFASE_CORRELACION] += acumulado;
         }
     }
     
-    printf("+-----------+--------+--------+--------+--------+---------------+\n");
+    for(int d = -MAX_DESFASE_CORRELACION; d <= MAX_DESFASE_CORRELACION; d++) {
+        float *r = &resultados[d + MAX_DESFASE_CORRELACION];
+        if(!correlacionDeSumas(series, columna_x, columna_y, d, productos[d + MAX_DESFASE_CORRELACION], r)) {
+            *r = CORRELACION_NO_DISPONIBLE;
+        }
+    }
+}
+
+// Matriz completa en CSV: una fila y una columna por zona y variable, celdas vacías
+// donde no hay datos suficientes
+int exportarMatrizCorrelacion(ZonaUrbana zonas[], float *matriz, char *nombre_archivo) {
+    char *nombres_var[] = {"CO2", "SO2", "NO2", "PM2.5", "Temperatura", "Viento", "Humedad", "Presion"};
+    FILE *archivo = fopen(nombre_archivo, "w");
+    if(archivo == NULL) {
+        return 0;
+    }
     
-    // Resumen estadístico al final
-    printf("\nRESUMEN ESTADISTICO:\n");
-    printf("-------------------------------------------------------\n");
+    fprintf(archivo, "Variable");
+    for(int j = 0; j < COLUMNAS_CORRELACION; j++) {
+        fprintf(archivo, ",%s %s", zonas[j / VARIABLES_CORRELACION].nombre, nombres_var[j % VARIABLES_CORRELACION]);
+    }
+    fprintf(archivo, "\n");
+    for(int i = 0; i < COLUMNAS_CORRELACION; i++) {
+        fprintf(archivo, "%s %s", zonas[i / VARIABLES_CORRELACION].nombre, nombres_var[i % VARIABLES_CORRELACION]);
+        for(int j = 0; j < COLUMNAS_CORRELACION; j++) {
+            float r = matriz[i * COLUMNAS_CORRELACION + j];
+            if(r == CORRELACION_NO_DISPONIBLE) {
+                fprintf(archivo, ",");
+            } else {
+                fprintf(archivo, ",%.4f", r);
+            }
+        }
+        fprintf(archivo, "\n");
+    }
+    return fclose(archivo) == 0;
+}
+
+void analisisCorrelaciones(ZonaUrbana zonas[]) {
+    char *nombres_cont[] = {"CO2", "SO2", "NO2", "PM2.5"};
+    ArenaTemporal *arena = arenaReportes();
+    SeriesCorrelacion series;
     
-    // Calcular días con problemas
-    int dias_buenos = 0, dias_moderados = 0, dias_daninos = 0, dias_peligrosos = 0;
+    printf("=== CORRELACIONES ENTRE VARIABLES Y ZONAS ===\n");
+    printf("=============================================\n\n");
     
-    for(int i = 0; i < zonas[zona_seleccionada].dias_registrados; i++) {
-        int excesos = 0;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.co2 > LIMITE_CO2_OMS) excesos++;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.so2 > LIMITE_SO2_OMS) excesos++;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.no2 > LIMITE_NO2_OMS) excesos++;
-        if(zonas[zona_seleccionada].historico_fechas[i].niveles.pm25 > LIMITE_PM25_OMS) excesos++;
-        
-        if(excesos == 0) dias_buenos++;
-        else if(excesos == 1) dias_moderados++;
-        else if(excesos == 2) dias_daninos++;
-        else dias_peligrosos++;
+    double inicio = milisegundosActuales();
+    float *matriz = reservarArena(arena, COLUMNAS_CORRELACION * COLUMNAS_CORRELACION * sizeof(float));
+    if(matriz == NULL || !prepararSeriesCorrelacion(zonas, &series, arena)) {
+        printf("ERROR: No hay datos suficientes o memoria para calcular correlaciones.\n");
+        liberarArena(arena);
+        printf("\nPresione Enter para continuar...");
+        getchar();
+        return;
     }
+    calcularMatrizCorrelacion(&series, matriz);
     
-    printf("  Dias buenos:     %2d (%.1f%%)\n", dias_buenos, 
-           (float)dias_buenos / zonas[zona_seleccionada].dias_registrados * 100);
-    printf("  Dias moderados:  %2d (%.1f%%)\n", dias_moderados,
-           (float)dias_moderados / zonas[zona_seleccionada].dias_registrados * 100);
-    printf("  Dias daninos:    %2d (%.1f%%)\n", dias_daninos,
-           (float)dias_daninos / zonas[zona_seleccionada].dias_registrados * 100);
-    printf("  Dias peligrosos: %2d (%.1f%%)\n", dias_peligrosos,
-           (float)dias_peligrosos / zonas[zona_seleccionada].dias_registrados * 100);
+    Fecha primer_dia = fechaDeNumeroDeDia(series.primer_dia);
+    Fecha ultimo_dia = fechaDeNumeroDeDia(series.primer_dia + series.num_dias - 1);
+    printf("Periodo analizado: %02d/%02d/%04d - %02d/%02d/%04d (%d dias, %d dias sin lectura interpolados)\n",
+           primer_dia.dia, primer_dia.mes, primer_dia.año, ultimo_dia.dia, ultimo_dia.mes, ultimo_dia.año,
+           series.num_dias, series.interpolados);
     
+    // 1. Cada contaminante contra cada variable climática de la misma zona
+    printf("\n1. CONTAMINANTES VS CLIMA (mismo dia)\n");
     printf("-------------------------------------------------------\n");
-    printf("LIMITES OMS DE REFERENCIA:\n");
-    printf("  CO2: %.1f ppm | SO2: %.1f ug/m3 | NO2: %.1f ug/m3 | PM2.5: %.1f ug/m3\n",
-           LIMITE_CO2_OMS, LIMITE_SO2_OMS, LIMITE_NO2_OMS, LIMITE_PM25_OMS);
-    printf("=======================================================\n");
+    for(int z = 0; z < MAX_ZONAS; z++) {
+        int base = z * VARIABLES_CORRELACION;
+        printf("%s\n", zonas[z].nombre);
+        if(series.inicio[base] == series.fin[base]) {
+            printf("  Sin datos\n");
+            continue;
+        }
+        printf("  %-6s  %7s  %7s  %7s  %7s\n", "", "Temp.", "Viento", "Humedad", "Presion");
+        for(int c = 0; c < 4; c++) {
+            printf("  %-6s", nombres_cont[c]);
+            for(int v = 4; v < VARIABLES_CORRELACION; v++) {
+                float r = matriz[(base + c) * COLUMNAS_CORRELACION + base + v];
+                if(r == CORRELACION_NO_DISPONIBLE) {
+                    printf("  %7s", "n/d");
+                } else {
+                    printf("  %7.2f", r);
+                }
+            }
+            printf("\n");
+        }
+    }
+    
+    // 2. El mismo contaminante en dos zonas, con la otra zona adelantada o atrasada
+    printf("\n2. CORRELACION CRUZADA ENTRE ZONAS (desfases de -%d a +%d dias)\n",
+           MAX_DESFASE_CORRELACION, MAX_DESFASE_CORRELACION);
+    printf("-------------------------------------------------------\n");
+    printf("Desfase +d: la primera zona se adelanta d dias a la segunda.\n");
+    for(int c = 0; c < 4; c++) {
+        printf("%s:\n", nombres_cont[c]);
+        for(int a = 0; a < MAX_ZONAS; a++) {
+            for(int b = a + 1; b < MAX_ZONAS; b++) {
+                float resultados[2 * MAX_DESFASE_CORRELACION + 1];
+                correlacionesDesfasadas(&series, a * VARIABLES_CORRELACION + c,
+                                        b * VARIABLES_CORRELACION + c, resultados);
+                
+                int mejor = -1;
+                for(int d = 0; d < 2 * MAX_DESFASE_CORRELACION + 1; d++) {
+                    if(resultados[d] != CORRELACION_NO_DISPONIBLE &&
+                       (mejor < 0 || resultados[d] > resultados[mejor])) {
+                        mejor = d;
+                    }
+                }
+                printf("  %-20.20s / %-20.20s ", zonas[a].nombre, zonas[b].nombre);
+                if(mejor < 0) {
+                    printf("sin dias suficientes en comun\n");
+                    continue;
+                }
+                float mismo_dia = resultados[MAX_DESFASE_CORRELACION];
+                if(mismo_dia == CORRELACION_NO_DISPONIBLE) {
+                    printf("r(0) =   n/d");
+                } else {
+                    printf("r(0) = %5.2f", mismo_dia);
+                }
+                printf("  maximo r = %5.2f con desfase %+d\n", resultados[mejor], mejor - MAX_DESFASE_CORRELACION);
+            }
+        }
+    }
+    double milisegundos = milisegundosActuales() - inicio;
+    
+    // 3. Matriz completa para análisis externo
+    char *nombre_archivo = ARCHIVO_MATRIZ_CORRELACION;
+    if(exportarMatrizCorrelacion(zonas, matriz, nombre_archivo)) {
+        printf("\nMatriz de correlacion %dx%d exportada: %s\n", COLUMNAS_CORRELACION, COLUMNAS_CORRELACION,
+               nombre_archivo);
+    } else {
+        printf("\nERROR: No se pudo crear %s\n", nombre_archivo);
+    }
+    printf("Tiempo de calculo: %.2f ms\n", milisegundos);
     
+    liberarArena(arena);
     printf("\nPresione Enter para continuar...");
     getchar();
 }
 
-// ===== FUNCIONES PARA EXPORTACIÓN DE REPORTES =====
+// ============ FUNCIONES PARA PERCENTILES (T-DIGEST) ============
+// Cada zona guarda un t-digest por año y contaminante, actualizado al registrar. Los
+// resúmenes se combinan entre sí, así que un percentil de varias zonas o varios años se
+// obtiene mezclando unos pocos cientos de centroides en lugar de ordenar el histórico.
 
-void exportarReportePorZona(ZonaUrbana zonas[], int zona_id) {
-    if (zona_id < 1 || zona_id > MAX_ZONAS) {
-        printf("ID de zona invalido.\n");
-        return;
+void iniciarDigest(DigestCuantiles *digest) {
+    memset(digest, 0, sizeof(DigestCuantiles));
+}
+
+// Agrupa una lista de centroides ordenada por media en el digest. Dos centroides
+// vecinos se unen si su peso conjunto no supera 4·N·q·(1-q)/COMPRESION_DIGEST (pocas
+// lecturas por centroide cerca de q = 0 y q = 1). El piso de 2·N/(MAX - 2) garantiza
+// que nunca queden más de MAX_CENTROIDES_DIGEST centroides.
+void agruparCentroidesDigest(DigestCuantiles *digest, CentroideDigest *lista, int cantidad) {
+    double total = 0;
+    for(int i = 0; i < cantidad; i++) {
+        total += lista[i].peso;
     }
+    double piso = 2.0 * total / (MAX_CENTROIDES_DIGEST - 2);
+    double acumulado = 0;
     
-    ZonaUrbana *zona = &zonas[zona_id - 1];
-    
-    char nombre_archivo[200];
-    sprintf(nombre_archivo, "reporte_zona_%d_%s.txt", zona_id, zona->nombre);
-    
-    FILE *archivo = fopen(nombre_archivo, "w");
-    if (archivo == NULL) {
-        printf("Error al crear el archivo de reporte.\n");
+    digest->num_centroides = 0;
+    if(cantidad == 0) {
         return;
     }
-    
-    /* Obtener fecha actual para el reporte */
-    time_t tiempo_actual = time(NULL);
-    struct tm *tiempo_local = localtime(&tiempo_actual);
-    
-    /* Arte ASCII mejorado y encabezado visual - VERSION LIMPIA SIN SOMBRAS */
-    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "║      █████  ██ ██████       ██████  ██   ██  █████  ██      ██ ████████ ██   ██  ║\n");
-    fprintf(archivo, "║     ██   ██ ██ ██   ██     ██    ██ ██   ██ ██   ██ ██      ██    ██     ██ ██   ║\n");
-    fprintf(archivo, "║     ███████ ██ ██████      ██    ██ ██   ██ ███████ ██      ██    ██      ███    ║\n");
-    fprintf(archivo, "║     ██   ██ ██ ██   ██     ██ ██ ██ ██   ██ ██   ██ ██      ██    ██      ██     ║\n");
-    fprintf(archivo, "║     ██   ██ ██ ██   ██      ██████   █████  ██   ██ ███████ ██    ██      ██     ║\n");
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "║            ███    ███  ██████  ███    ██ ██ ████████  ██████  ██████            ║\n");
-    fprintf(archivo, "║            ████  ████ ██    ██ ████   ██ ██    ██    ██    ██ ██   ██           ║\n");
-    fprintf(archivo, "║            ██ ████ ██ ██    ██ ██ ██  ██ ██    ██    ██    ██ ██████            ║\n");
-    fprintf(archivo, "║            ██  ██  ██ ██    ██ ██  ██ ██ ██    ██    ██    ██ ██   ██           ║\n");
-    fprintf(archivo, "║            ██      ██  ██████  ██   ████ ██    ██     ██████  ██   ██           ║\n");
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "║                   ╔═══════════════════════════════════════════════╗              ║\n");
-    fprintf(archivo, "║                   ║          MONITOREO AMBIENTAL QUITO           ║              ║\n");
-    fprintf(archivo, "║                   ║           SISTEMA DE CALIDAD DEL AIRE         ║              ║\n");
-    fprintf(archivo, "║                   ║               ECUADOR - 2025                  ║              ║\n");
-    fprintf(archivo, "║                   ║            REPORTE PROFESIONAL               ║              ║\n");
-    fprintf(archivo, "║                   ╚═══════════════════════════════════════════════╝              ║\n");
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n");
-    fprintf(archivo, "                                                                                    \n");
-    fprintf(archivo, "    ╔═══════════════════════════════════════════════════════════════════════════╗  \n");
-    fprintf(archivo, "    ║    SISTEMA PROFESIONAL DE MONITOREO ATMOSFERICO - ESTILO AIRNOW EPA    ║  \n");
-    fprintf(archivo, "    ║                          Compatible con Estandares OMS                   ║  \n");
-    fprintf(archivo, "    ╚═══════════════════════════════════════════════════════════════════════════╝  \n");
-    fprintf(archivo, "                                                                                    \n");
-    
-    /* Calcular Indice de Calidad del Aire (AQI simplificado) */
-    int excesos_actuales = 0;
-    if(zona->niveles_actuales.co2 > LIMITE_CO2_OMS) excesos_actuales++;
-    if(zona->niveles_actuales.so2 > LIMITE_SO2_OMS) excesos_actuales++;
-    if(zona->niveles_actuales.no2 > LIMITE_NO2_OMS) excesos_actuales++;
-    if(zona->niveles_actuales.pm25 > LIMITE_PM25_OMS) excesos_actuales++;
-    
-    char categoria_aqi[30];
-    char color_aqi[20];
-    int valor_aqi;
-    
-    if(excesos_actuales == 0) {
-        strcpy(categoria_aqi, "BUENO");
-        strcpy(color_aqi, "VERDE");
-        valor_aqi = 25;
-    } else if(excesos_actuales == 1) {
-        strcpy(categoria_aqi, "MODERADO");
-        strcpy(color_aqi, "AMARILLO");
-        valor_aqi = 75;
-    } else if(excesos_actuales == 2) {
-        strcpy(categoria_aqi, "DANINO PARA SENSIBLES");
-        strcpy(color_aqi, "NARANJA");
-        valor_aqi = 125;
-    } else if(excesos_actuales == 3) {
-        strcpy(categoria_aqi, "DANINO");
-        strcpy(color_aqi, "ROJO");
-        valor_aqi = 175;
-    } else {
-        strcpy(categoria_aqi, "MUY DANINO");
-        strcpy(color_aqi, "MORADO");
-        valor_aqi = 225;
+    CentroideDigest actual = lista[0];
+    for(int i = 1; i < cantidad; i++) {
+        double propuesto = (double)actual.peso + lista[i].peso;
+        double q = (acumulado + propuesto / 2.0) / total;
+        double limite = 4.0 * total * q * (1.0 - q) / COMPRESION_DIGEST;
+        if(limite < piso) limite = piso;
+        
+        if(propuesto <= limite) {
+            actual.media += (lista[i].media - actual.media) * lista[i].peso / (float)propuesto;
+            actual.peso = (float)propuesto;
+        } else {
+            digest->centroides[digest->num_centroides++] = actual;
+            acumulado += actual.peso;
+            actual = lista[i];
+        }
     }
+    digest->centroides[digest->num_centroides++] = actual;
+}
+
+// Incorpora las lecturas pendientes: se ordenan (son pocas), se intercalan con los
+// centroides y la lista resultante se vuelve a agrupar
+void compactarDigest(DigestCuantiles *digest) {
+    CentroideDigest lista[MAX_CENTROIDES_DIGEST + PENDIENTES_DIGEST];
+    int cantidad = 0, c = 0, p = 0;
     
-    // ENCABEZADO DEL REPORTE
-    fprintf(archivo, "┌─────────────────────────────────────────────────────────────────────────────┐\n");
-    fprintf(archivo, "│                           REPORTE DE CALIDAD DEL AIRE                      │\n");
-    fprintf(archivo, "├─────────────────────────────────────────────────────────────────────────────┤\n");
-    fprintf(archivo, "│  Zona: %-30s                                      │\n", zona->nombre);
-    fprintf(archivo, "│  ID de Zona: %-3d                                                         │\n", zona->id_zona);
-    fprintf(archivo, "│  Fecha: %02d/%02d/%04d a las %02d:%02d                                          │\n", 
-            tiempo_local->tm_mday, tiempo_local->tm_mon + 1, tiempo_local->tm_year + 1900,
-            tiempo_local->tm_hour, tiempo_local->tm_min);
-    fprintf(archivo, "│  Dias monitoreados: %-3d                                                   │\n", zona->dias_registrados);
-    fprintf(archivo, "└─────────────────────────────────────────────────────────────────────────────┘\n\n");
-    
-    // ÍNDICE DE CALIDAD DEL AIRE PRINCIPAL
-    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
-    fprintf(archivo, "║                            INDICE DE CALIDAD DEL AIRE                           ║\n");
-    fprintf(archivo, "╠══════════════════════════════════════════════════════════════════════════════════╣\n");
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "║                                 AQI: %3d                                       ║\n", valor_aqi);
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "║                               %s                                               ║\n", categoria_aqi);
-    fprintf(archivo, "║                                Nivel: %s                                       ║\n", color_aqi);
-    fprintf(archivo, "║                                                                                  ║\n");
-    
-    if(excesos_actuales == 0) {
-        fprintf(archivo, "║    ┌─────────────────────────────────────────────────────────────────────────┐    ║\n");
-        fprintf(archivo, "║    │ * AIRE LIMPIO Y SALUDABLE - CONDICIONES OPTIMAS PARA TODOS            │    ║\n");
-        fprintf(archivo, "║    └─────────────────────────────────────────────────────────────────────────┘    ║\n");
-    } else if(excesos_actuales == 1) {
-        fprintf(archivo, "║    ┌─────────────────────────────────────────────────────────────────────────┐    ║\n");
-        fprintf(archivo, "║    │ ! CALIDAD ACEPTABLE - PRECAUCION PARA GRUPOS SENSIBLES                │    ║\n");
-        fprintf(archivo, "║    └─────────────────────────────────────────────────────────────────────────┘    ║\n");
-    } else if(excesos_actuales <= 2) {
-        fprintf(archivo, "║    ┌─────────────────────────────────────────────────────────────────────────┐    ║\n");
-        fprintf(archivo, "║    │ !! DANINO PARA GRUPOS SENSIBLES - LIMITE ACTIVIDADES EXTERIORES        │    ║\n");
-        fprintf(archivo, "║    └─────────────────────────────────────────────────────────────────────────┘    ║\n");
-    } else if(excesos_actuales == 3) {
-        fprintf(archivo, "║    ┌─────────────────────────────────────────────────────────────────────────┐    ║\n");
-        fprintf(archivo, "║    │ !!! AIRE DANINO - TODOS DEBEN REDUCIR EXPOSICION EXTERIOR                │    ║\n");
-        fprintf(archivo, "║    └─────────────────────────────────────────────────────────────────────────┘    ║\n");
-    } else {
-        fprintf(archivo, "║    ┌─────────────────────────────────────────────────────────────────────────┐    ║\n");
-        fprintf(archivo, "║    │ !!!! PELIGROSO - EVITAR COMPLETAMENTE ACTIVIDADES AL AIRE LIBRE            │    ║\n");
-        fprintf(archivo, "║    └─────────────────────────────────────────────────────────────────────────┘    ║\n");
+    if(digest->num_pendientes == 0) {
+        return;
+    }
+    for(int i = 1; i < digest->num_pendientes; i++) {
+        float valor = digest->pendientes[i];
+        int j = i - 1;
+        while(j >= 0 && digest->pendientes[j] > valor) {
+            digest->pendientes[j + 1] = digest->pendientes[j];
+            j--;
+        }
+        digest->pendientes[j + 1] = valor;
     }
     
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n\n");
+    while(c < digest->num_centroides || p < digest->num_pendientes) {
+        if(p == digest->num_pendientes ||
+           (c < digest->num_centroides && digest->centroides[c].media <= digest->pendientes[p])) {
+            lista[cantidad++] = digest->centroides[c++];
+        } else {
+            lista[cantidad].media = digest->pendientes[p++];
+            lista[cantidad++].peso = 1.0;
+        }
+    }
+    digest->num_pendientes = 0;
+    agruparCentroidesDigest(digest, lista, cantidad);
+}
+
+void agregarValorDigest(DigestCuantiles *digest, float valor) {
+    if(digest->total == 0 || valor < digest->minimo) digest->minimo = valor;
+    if(digest->total == 0 || valor > digest->maximo) digest->maximo = valor;
+    digest->total += 1.0;
+    
+    digest->pendientes[digest->num_pendientes++] = valor;
+    if(digest->num_pendientes == PENDIENTES_DIGEST) {
+        compactarDigest(digest);
+    }
+}
+
+// Suma al destino las lecturas resumidas en el origen
+void combinarDigest(DigestCuantiles *destino, DigestCuantiles *origen) {
+    CentroideDigest lista[2 * MAX_CENTROIDES_DIGEST];
+    int cantidad = 0, a = 0, b = 0;
     
-    /* NIVELES ACTUALES */
-    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
-    fprintf(archivo, "║                       NIVELES ACTUALES DE CONTAMINANTES                         ║\n");
-    fprintf(archivo, "╠══════════════════════════════════════════════════════════════════════════════════╣\n");
-    fprintf(archivo, "║                                                                                  ║\n");
+    if(origen->total == 0) {
+        return;
+    }
+    compactarDigest(origen);
+    compactarDigest(destino);
+    if(destino->total == 0 || origen->minimo < destino->minimo) destino->minimo = origen->minimo;
+    if(destino->total == 0 || origen->maximo > destino->maximo) destino->maximo = origen->maximo;
+    destino->total += origen->total;
+    
+    while(a < destino->num_centroides || b < origen->num_centroides) {
+        if(b == origen->num_centroides ||
+           (a < destino->num_centroides && destino->centroides[a].media <= origen->centroides[b].media)) {
+            lista[cantidad++] = destino->centroides[a++];
+        } else {
+            lista[cantidad++] = origen->centroides[b++];
+        }
+    }
+    agruparCentroidesDigest(destino, lista, cantidad);
+}
+
+// Valor del cuantil (0 a 1). Cada centroide representa el centro de sus lecturas; entre
+// centros se interpola linealmente y los extremos se anclan en el mínimo y el máximo.
+float cuantilDigest(DigestCuantiles *digest, float cuantil) {
+    if(digest->total == 0) {
+        return 0;
+    }
+    compactarDigest(digest);
+    if(cuantil <= 0) return digest->minimo;
+    if(cuantil >= 1) return digest->maximo;
+    
+    CentroideDigest *centroides = digest->centroides;
+    int n = digest->num_centroides;
+    double posicion = cuantil * digest->total;
+    
+    // Cola inferior: entre el mínimo y el centro del primer centroide
+    if(posicion < centroides[0].peso / 2.0) {
+        if(centroides[0].peso <= 1) return centroides[0].media;
+        return digest->minimo + (centroides[0].media - digest->minimo) *
+               (float)(posicion / (centroides[0].peso / 2.0));
+    }
+    // Cola superior: entre el centro del último centroide y el máximo
+    if(posicion >= digest->total - centroides[n - 1].peso / 2.0) {
+        if(centroides[n - 1].peso <= 1) return centroides[n - 1].media;
+        double desde_centro = posicion - (digest->total - centroides[n - 1].peso / 2.0);
+        return centroides[n - 1].media + (digest->maximo - centroides[n - 1].media) *
+               (float)(desde_centro / (centroides[n - 1].peso / 2.0));
+    }
     
-    fprintf(archivo, "║  CO2:    %6.1f ppm      │ Limite OMS: %6.1f │ ", zona->niveles_actuales.co2, LIMITE_CO2_OMS);
-    if(zona->niveles_actuales.co2 <= LIMITE_CO2_OMS) {
-        fprintf(archivo, "* NORMAL         ║\n");
-    } else {
-        fprintf(archivo, "! EXCEDIDO %.1f%%   ║\n", 
-                (zona->niveles_actuales.co2 / LIMITE_CO2_OMS - 1) * 100);
+    double centro = centroides[0].peso / 2.0;
+    for(int i = 0; i < n - 1; i++) {
+        double siguiente = centro + (centroides[i].peso + centroides[i + 1].peso) / 2.0;
+        if(posicion < siguiente) {
+            float t = (float)((posicion - centro) / (siguiente - centro));
+            return centroides[i].media + (centroides[i + 1].media - centroides[i].media) * t;
+        }
+        centro = siguiente;
+    }
+    return centroides[n - 1].media;
+}
+
+// Resúmenes del año indicado; con 'crear' se agrega el año si no existe (en orden)
+CuantilesAnio *cuantilesDeAnio(ZonaUrbana *zona, int año, int crear) {
+    int posicion = 0;
+    while(posicion < zona->num_anios_cuantiles && zona->cuantiles[posicion].año < año) {
+        posicion++;
+    }
+    if(posicion < zona->num_anios_cuantiles && zona->cuantiles[posicion].año == año) {
+        return &zona->cuantiles[posicion];
+    }
+    if(!crear) {
+        return NULL;
     }
     
-    fprintf(archivo, "║  SO2:    %6.1f ug/m3   │ Limite OMS: %6.1f │ ", zona->niveles_actuales.so2, LIMITE_SO2_OMS);
-    if(zona->niveles_actuales.so2 <= LIMITE_SO2_OMS) {
-        fprintf(archivo, "* NORMAL         ║\n");
+    CuantilesAnio *nuevos = realloc(zona->cuantiles, (zona->num_anios_cuantiles + 1) * sizeof(CuantilesAnio));
+    if(nuevos == NULL) {
+        return NULL;
+    }
+    zona->cuantiles = nuevos;
+    memmove(&nuevos[posicion + 1], &nuevos[posicion],
+            (zona->num_anios_cuantiles - posicion) * sizeof(CuantilesAnio));
+    zona->num_anios_cuantiles++;
+    
+    memset(&nuevos[posicion], 0, sizeof(CuantilesAnio));
+    nuevos[posicion].año = año;
+    for(int c = 0; c < 4; c++) {
+        iniciarDigest(&nuevos[posicion].digest[c]);
+    }
+    return &nuevos[posicion];
+}
+
+int agregarRegistroCuantiles(ZonaUrbana *zona, const RegistroHistorico *registro) {
+    CuantilesAnio *anio = cuantilesDeAnio(zona, registro->fecha.año, 1);
+    if(anio == NULL) {
+        return 0;
+    }
+    agregarValorDigest(&anio->digest[0], registro->niveles.co2);
+    agregarValorDigest(&anio->digest[1], registro->niveles.so2);
+    agregarValorDigest(&anio->digest[2], registro->niveles.no2);
+    agregarValorDigest(&anio->digest[3], registro->niveles.pm25);
+    return 1;
+}
+
+// Indica si todas las lecturas del año siguen como días crudos en memoria: el día más
+// antiguo en memoria es de un año anterior, o es de ese año y nada se compactó en disco
+int anioCompletoEnMemoria(ZonaUrbana *zona, int año) {
+    int total = diasTotalesZona(zona);
+    Fecha primer_agregado;
+    if(total == 0) {
+        return !primerDiaAgregado(zona->id_zona, &primer_agregado);
+    }
+    int anio_mas_antiguo = registroHistoricoCompleto(zona, total - 1).fecha.año;
+    if(anio_mas_antiguo != año) {
+        return anio_mas_antiguo < año;
+    }
+    return !primerDiaAgregado(zona->id_zona, &primer_agregado);
+}
+
+// Vuelve a calcular los resúmenes con los días reales en memoria (sin días completados
+// ni fechas repetidas). Con año 0 se reconstruyen todos los años.
+int reconstruirCuantilesZona(ZonaUrbana *zona, int año) {
+    if(año == 0) {
+        liberarCuantilesZona(zona);
     } else {
-        fprintf(archivo, "! EXCEDIDO %.1f%%   ║\n", 
-                (zona->niveles_actuales.so2 / LIMITE_SO2_OMS - 1) * 100);
+        CuantilesAnio *anio = cuantilesDeAnio(zona, año, 0);
+        if(anio != NULL) {
+            for(int c = 0; c < 4; c++) {
+                iniciarDigest(&anio->digest[c]);
+            }
+        }
     }
     
-    fprintf(archivo, "║  NO2:    %6.1f ug/m3   │ Limite OMS: %6.1f │ ", zona->niveles_actuales.no2, LIMITE_NO2_OMS);
-    if(zona->niveles_actuales.no2 <= LIMITE_NO2_OMS) {
-        fprintf(archivo, "* NORMAL         ║\n");
-    } else {
-        fprintf(archivo, "! EXCEDIDO %.1f%%   ║\n", 
-                (zona->niveles_actuales.no2 / LIMITE_NO2_OMS - 1) * 100);
+    for(int d = diasTotalesZona(zona) - 1; d >= 0; d--) {
+        RegistroHistorico registro;
+        if(d < zona->dias_registrados) {
+            if(diaImputado(zona, d) || diaDuplicado(zona, d)) continue;
+            registro = registroDeZona(zona, d);
+        } else {
+            registro = *registroArchivado(&zona->archivado, diasTotalesZona(zona) - 1 - d);
+        }
+        if(año != 0 && registro.fecha.año != año) continue;
+        if(!agregarRegistroCuantiles(zona, &registro)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void liberarCuantilesZona(ZonaUrbana *zona) {
+    free(zona->cuantiles);
+    zona->cuantiles = NULL;
+    zona->num_anios_cuantiles = 0;
+}
+
+// Escribe zona_N_cuantiles.dat (temporal + renombrado). Guarda la generación con que se
+// publicará zona_N.dat para detectar al cargar un archivo de percentiles desfasado.
+int guardarCuantilesZona(ZonaUrbana *zona, unsigned int generacion, int sincronizar) {
+    char nombre_archivo[100], nombre_temporal[100];
+    sprintf(nombre_archivo, "zona_%d_cuantiles.dat", zona->id_zona);
+    sprintf(nombre_temporal, "zona_%d_cuantiles.tmp", zona->id_zona);
+    
+    FILE *f = fopen(nombre_temporal, "wb");
+    if(f == NULL) {
+        return 0;
     }
     
-    fprintf(archivo, "║  PM2.5:  %6.1f ug/m3   │ Limite OMS: %6.1f │ ", zona->niveles_actuales.pm25, LIMITE_PM25_OMS);
-    if(zona->niveles_actuales.pm25 <= LIMITE_PM25_OMS) {
-        fprintf(archivo, "* NORMAL         ║\n");
-    } else {
-        fprintf(archivo, "! EXCEDIDO %.1f%%   ║\n", 
-                (zona->niveles_actuales.pm25 / LIMITE_PM25_OMS - 1) * 100);
+    CabeceraArchivoCuantiles cabecera;
+    memset(&cabecera, 0, sizeof(cabecera));
+    memcpy(cabecera.magia, MAGIA_ARCHIVO_CUANTILES, 4);
+    cabecera.version = VERSION_ARCHIVO_CUANTILES;
+    cabecera.num_anios = zona->num_anios_cuantiles;
+    cabecera.tamano_registro = sizeof(CuantilesAnio);
+    cabecera.generacion = generacion;
+    cabecera.crc = calcularCRC32(&cabecera, offsetof(CabeceraArchivoCuantiles, crc));
+    
+    int correcto = fwrite(&cabecera, sizeof(cabecera), 1, f) == 1;
+    for(int i = 0; correcto && i < zona->num_anios_cuantiles; i++) {
+        RegistroArchivoCuantiles registro;
+        memset(&registro, 0, sizeof(registro));
+        memcpy(&registro.anio, &zona->cuantiles[i], sizeof(CuantilesAnio));
+        registro.crc = calcularCRC32(&registro.anio, sizeof(CuantilesAnio));
+        correcto = fwrite(&registro, sizeof(registro), 1, f) == 1;
     }
     
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n");
-    fprintf(archivo, "\n");
+    if(correcto && sincronizar) {
+        sincronizarArchivo(f);
+    }
+    if(fclose(f) != 0) {
+        correcto = 0;
+    }
+    if(!correcto || reemplazarArchivo(nombre_temporal, nombre_archivo) != 0) {
+        remove(nombre_temporal);
+        return 0;
+    }
+    return 1;
+}
+
+// Lee zona_N_cuantiles.dat. Devuelve 0 si falta, está dañado o no corresponde a la
+// generación cargada de zona_N.dat; en ese caso la zona queda sin resúmenes.
+int cargarCuantilesZona(ZonaUrbana *zona) {
+    char nombre_archivo[100];
+    CabeceraArchivoCuantiles cabecera;
     
-    /* CONDICIONES CLIMATICAS */
-    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
-    fprintf(archivo, "║                        CONDICIONES CLIMATICAS ACTUALES                          ║\n");
-    fprintf(archivo, "╠══════════════════════════════════════════════════════════════════════════════════╣\n");
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "║  Temperatura:          %6.1f°C     │   Humedad:             %6.1f%%     ║\n", 
-            zona->clima_actual.temperatura, zona->clima_actual.humedad);
-    fprintf(archivo, "║                                     │                                       ║\n");
-    fprintf(archivo, "║  Velocidad del viento: %6.1f km/h  │   Presion atmosferica: %6.1f hPa  ║\n", 
-            zona->clima_actual.velocidad_viento, zona->clima_actual.presion_atmosferica);
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n\n");
+    liberarCuantilesZona(zona);
+    sprintf(nombre_archivo, "zona_%d_cuantiles.dat", zona->id_zona);
+    FILE *f = fopen(nombre_archivo, "rb");
+    if(f == NULL) {
+        return 0;
+    }
+    if(fread(&cabecera, sizeof(cabecera), 1, f) != 1 ||
+       memcmp(cabecera.magia, MAGIA_ARCHIVO_CUANTILES, 4) != 0 ||
+       cabecera.version != VERSION_ARCHIVO_CUANTILES ||
+       cabecera.crc != calcularCRC32(&cabecera, offsetof(CabeceraArchivoCuantiles, crc)) ||
+       cabecera.tamano_registro != (int)sizeof(CuantilesAnio) ||
+       cabecera.generacion != zona->generacion || cabecera.num_anios < 0) {
+        fclose(f);
+        return 0;
+    }
     
-    /* RECOMENDACIONES DE SALUD */
-    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
-    fprintf(archivo, "║                           RECOMENDACIONES DE SALUD                              ║\n");
-    fprintf(archivo, "╠══════════════════════════════════════════════════════════════════════════════════╣\n");
-    fprintf(archivo, "║                                                                                  ║\n");
+    zona->cuantiles = malloc((cabecera.num_anios + 1) * sizeof(CuantilesAnio));
+    int correcto = zona->cuantiles != NULL;
+    for(int i = 0; correcto && i < cabecera.num_anios; i++) {
+        RegistroArchivoCuantiles registro;
+        correcto = fread(&registro, sizeof(registro), 1, f) == 1 &&
+                   registro.crc == calcularCRC32(&registro.anio, sizeof(CuantilesAnio));
+        for(int c = 0; correcto && c < 4; c++) {
+            DigestCuantiles *digest = &registro.anio.digest[c];
+            correcto = digest->num_centroides >= 0 && digest->num_centroides <= MAX_CENTROIDES_DIGEST &&
+                       digest->num_pendientes >= 0 && digest->num_pendientes < PENDIENTES_DIGEST;
+        }
+        if(correcto) {
+            zona->cuantiles[i] = registro.anio;
+            zona->num_anios_cuantiles++;
+        }
+    }
+    fclose(f);
     
-    if(excesos_actuales == 0) {
-        fprintf(archivo, "║  POBLACION GENERAL:                                                            ║\n");
-        fprintf(archivo, "║    * Excelente dia para actividades al aire libre                              ║\n");
-        fprintf(archivo, "║    * Ideal para ejercicio y deportes                                            ║\n");
-        fprintf(archivo, "║    * Perfecto para que los ninos jueguen afuera                                ║\n");
-        fprintf(archivo, "║                                                                                  ║\n");
-        fprintf(archivo, "║  GRUPOS SENSIBLES:                                                             ║\n");
-        fprintf(archivo, "║    * Sin restricciones                                                          ║\n");
-        fprintf(archivo, "║    * Condiciones optimas para personas con asma                                ║\n");
-        fprintf(archivo, "║    * Seguro para adultos mayores y ninos pequenos                              ║\n");
-    } else if(excesos_actuales <= 1) {
-        fprintf(archivo, "║  POBLACION GENERAL:                                                            ║\n");
-        fprintf(archivo, "║    * Actividades al aire libre son aceptables                                  ║\n");
-        fprintf(archivo, "║    ! Considere reducir ejercicio intenso prolongado                            ║\n");
-        fprintf(archivo, "║    * Condiciones normales para la mayoria de personas                          ║\n");
-        fprintf(archivo, "║                                                                                  ║\n");
-        fprintf(archivo, "║  GRUPOS SENSIBLES:                                                             ║\n");
-        fprintf(archivo, "║    ! Personas con asma: limite actividades prolongadas                         ║\n");
-        fprintf(archivo, "║    ! Adultos mayores: prefiera actividades en interiores                       ║\n");
-        fprintf(archivo, "║    ! Ninos: reduzca tiempo de juego al aire libre                              ║\n");
-    } else if(excesos_actuales <= 2) {
-        fprintf(archivo, "║  POBLACION GENERAL:                                                            ║\n");
-        fprintf(archivo, "║    ! Reduzca actividades al aire libre prolongadas                             ║\n");
-        fprintf(archivo, "║    ! Evite ejercicio intenso al aire libre                                     ║\n");
-        fprintf(archivo, "║    ! Use mascarilla si es sensible a la contaminacion                          ║\n");
-        fprintf(archivo, "║                                                                                  ║\n");
-        fprintf(archivo, "║  GRUPOS SENSIBLES:                                                             ║\n");
-        fprintf(archivo, "║    ! Evite actividades al aire libre                                           ║\n");
-        fprintf(archivo, "║    ! Permanezca en interiores cuando sea posible                               ║\n");
-        fprintf(archivo, "║    ! Tenga medicamentos de emergencia a mano                                   ║\n");
-    } else {
-        fprintf(archivo, "║  POBLACION GENERAL:                                                            ║\n");
-        fprintf(archivo, "║    ! Evite todas las actividades al aire libre                                 ║\n");
-        fprintf(archivo, "║    ! Permanezca en interiores                                                   ║\n");
-        fprintf(archivo, "║    ! Use mascarilla si debe salir                                               ║\n");
-        fprintf(archivo, "║    ! Cancele eventos deportivos al aire libre                                   ║\n");
-        fprintf(archivo, "║                                                                                  ║\n");
-        fprintf(archivo, "║  GRUPOS SENSIBLES:                                                             ║\n");
-        fprintf(archivo, "║    !! ALERTA MEDICA: Permanezca en interiores                                   ║\n");
-        fprintf(archivo, "║    !! Tenga medicamentos listos                                                  ║\n");
-        fprintf(archivo, "║    !! Contacte a su medico si presenta sintomas                                  ║\n");
-        fprintf(archivo, "║    !! Busque atencion medica si tiene dificultad respiratoria                   ║\n");
+    if(!correcto) {
+        liberarCuantilesZona(zona);
+    }
+    return correcto;
+}
+
+// Combina en 'resultado' los resúmenes de un contaminante para los años indicados, de
+// una zona (id_zona) o de todas (id_zona = 0). Devuelve los resúmenes anuales usados.
+int combinarCuantilesZonas(ZonaUrbana zonas[], int id_zona, int anio_desde, int anio_hasta,
+                           int contaminante, DigestCuantiles *resultado) {
+    int usados = 0;
+    iniciarDigest(resultado);
+    for(int z = 0; z < MAX_ZONAS; z++) {
+        ZonaUrbana *zona = &zonas[z];
+        if(zona->id_zona < 1 || (id_zona != 0 && zona->id_zona != id_zona)) continue;
+        for(int i = 0; i < zona->num_anios_cuantiles; i++) {
+            if(zona->cuantiles[i].año < anio_desde || zona->cuantiles[i].año > anio_hasta) continue;
+            combinarDigest(resultado, &zona->cuantiles[i].digest[contaminante]);
+            usados++;
+        }
+    }
+    return usados;
+}
+
+void consultarPercentiles(ZonaUrbana zonas[]) {
+    char *nombres[] = {"CO2 (ppm)", "SO2 (ug/m3)", "NO2 (ug/m3)", "PM2.5 (ug/m3)"};
+    float cuantiles[] = {0.50, 0.90, 0.95, 0.99};
+    int id_zona, anio_desde, anio_hasta, val;
+    
+    printf("=== PERCENTILES DE CONTAMINANTES ===\n");
+    printf("====================================\n\n");
+    printf("Zonas:\n");
+    printf("0. Todas las zonas\n");
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        printf("%d. %s", zonas[i].id_zona, zonas[i].nombre);
+        if(zonas[i].num_anios_cuantiles > 0) {
+            printf(" (%d-%d)\n", zonas[i].cuantiles[0].año,
+                   zonas[i].cuantiles[zonas[i].num_anios_cuantiles - 1].año);
+        } else {
+            printf(" (Sin datos)\n");
+        }
     }
     
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n\n");
+    do {
+        printf("\nSeleccione la zona (0-%d): ", MAX_ZONAS);
+        val = scanf("%d", &id_zona);
+        fflush(stdin);
+        if(val != 1 || id_zona < 0 || id_zona > MAX_ZONAS) {
+            printf("Opcion invalida. Por favor, intente de nuevo.\n");
+        }
+    } while(val != 1 || id_zona < 0 || id_zona > MAX_ZONAS);
     
-    /* PRONOSTICO DE 24 HORAS */
-    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
-    fprintf(archivo, "║                          PRONOSTICO PARA LAS PROXIMAS 24 HORAS                 ║\n");
-    fprintf(archivo, "╠══════════════════════════════════════════════════════════════════════════════════╣\n");
-    fprintf(archivo, "║                                                                                  ║\n");
+    do {
+        printf("Desde el año (0 = sin limite): ");
+        val = scanf("%d", &anio_desde);
+        fflush(stdin);
+        if(val == 1 && anio_desde >= 0) {
+            printf("Hasta el año (0 = sin limite): ");
+            val = scanf("%d", &anio_hasta);
+            fflush(stdin);
+        }
+        if(val != 1 || anio_desde < 0 || anio_hasta < 0 ||
+           (anio_hasta != 0 && anio_hasta < anio_desde)) {
+            printf("Rango de años invalido. Por favor, intente de nuevo.\n");
+            val = 0;
+        }
+    } while(val != 1);
+    if(anio_hasta == 0) {
+        anio_hasta = 9999;
+    }
     
-    /* Calcular pronostico simple basado en tendencia historica */
-    if(zona->dias_registrados >= 3) {
-        float tendencia_co2 = (zona->historico_fechas[0].niveles.co2 - zona->historico_fechas[2].niveles.co2) / 2.0;
-        float tendencia_so2 = (zona->historico_fechas[0].niveles.so2 - zona->historico_fechas[2].niveles.so2) / 2.0;
-        float tendencia_no2 = (zona->historico_fechas[0].niveles.no2 - zona->historico_fechas[2].niveles.no2) / 2.0;
-        float tendencia_pm25 = (zona->historico_fechas[0].niveles.pm25 - zona->historico_fechas[2].niveles.pm25) / 2.0;
-        
-        float pronostico_co2 = zona->niveles_actuales.co2 + tendencia_co2;
-        float pronostico_so2 = zona->niveles_actuales.so2 + tendencia_so2;
-        float pronostico_no2 = zona->niveles_actuales.no2 + tendencia_no2;
-        float pronostico_pm25 = zona->niveles_actuales.pm25 + tendencia_pm25;
-        
-        fprintf(archivo, "║  NIVELES ESPERADOS:                                                            ║\n");
-        fprintf(archivo, "║                                                                                  ║\n");
-        
-        fprintf(archivo, "║  CO2:   %6.1f ppm     │ Tendencia: ", pronostico_co2);
-        if(tendencia_co2 > 0) {
-            fprintf(archivo, "* SUBIENDO +%5.1f            ║\n", tendencia_co2);
-        } else {
-            fprintf(archivo, "* BAJANDO %6.1f            ║\n", tendencia_co2);
+    printf("\nContaminante   | Lecturas | P50     | P90     | P95     | P99     | Maximo\n");
+    printf("---------------|----------|---------|---------|---------|---------|--------\n");
+    double ms_consultas = 0;
+    int anios_usados = 0;
+    for(int c = 0; c < 4; c++) {
+        DigestCuantiles digest;
+        float valores[4];
+        double inicio = milisegundosActuales();
+        anios_usados = combinarCuantilesZonas(zonas, id_zona, anio_desde, anio_hasta, c, &digest);
+        for(int q = 0; q < 4; q++) {
+            valores[q] = cuantilDigest(&digest, cuantiles[q]);
         }
+        ms_consultas += milisegundosActuales() - inicio;
         
-        fprintf(archivo, "║  SO2:   %6.1f ug/m3  │ Tendencia: ", pronostico_so2);
-        if(tendencia_so2 > 0) {
-            fprintf(archivo, "* SUBIENDO +%5.1f            ║\n", tendencia_so2);
-        } else {
-            fprintf(archivo, "* BAJANDO %6.1f            ║\n", tendencia_so2);
+        if(digest.total == 0) {
+            printf("%-14s | %8d | Sin datos en el rango\n", nombres[c], 0);
+            continue;
         }
-        
-        fprintf(archivo, "║  NO2:   %6.1f ug/m3  │ Tendencia: ", pronostico_no2);
-        if(tendencia_no2 > 0) {
-            fprintf(archivo, "* SUBIENDO +%5.1f            ║\n", tendencia_no2);
-        } else {
-            fprintf(archivo, "* BAJANDO %6.1f            ║\n", tendencia_no2);
+        printf("%-14s | %8.0f | %7.1f | %7.1f | %7.1f | %7.1f | %7.1f\n", nombres[c], digest.total,
+               valores[0], valores[1], valores[2], valores[3], digest.maximo);
+    }
+    printf("\nResumenes anuales combinados por contaminante: %d\n", anios_usados);
+    printf("Tiempo de consulta: %.1f microsegundos por contaminante\n", ms_consultas * 1000.0 / 4);
+    printf("(Percentiles aproximados con t-digest)\n");
+    
+    printf("\nPresione Enter para continuar...");
+    getchar();
+}
+
+// ================= FUNCIONES PARA IMPORTAR HISTORICO =================
+
+// Agrega a la zona los días de 'origen' anteriores a su día más antiguo (incluido el
+// histórico compactado en disco): primero completan la ventana de historico[] y el
+// resto va al histórico archivado. Las fechas repetidas se omiten. Devuelve los días
+// agregados.
+int importarDiasAnteriores(ZonaUrbana *zona, ZonaUrbana *origen) {
+    int total_origen = diasTotalesZona(origen);
+    int tiene_datos = diasTotalesZona(zona) > 0;
+    int en_ventana = 0;
+    Fecha limite = {0, 0, 0};
+    HistoricoArchivado nuevos;
+    
+    memset(&nuevos, 0, sizeof(nuevos));
+    if(zona->archivado.num_registros > 0) {
+        limite = registroArchivado(&zona->archivado, 0)->fecha;
+    } else if(zona->dias_registrados > 0) {
+        limite = zona->historico_fechas[zona->dias_registrados - 1].fecha;
+    }
+    // Los periodos ya compactados en disco no vuelven a importarse
+    Fecha primer_agregado;
+    if(primerDiaAgregado(zona->id_zona, &primer_agregado) &&
+       (!tiene_datos || compararFechas(primer_agregado, limite) < 0)) {
+        limite = primer_agregado;
+        tiene_datos = 1;
+    }
+    
+    // Del más reciente al más antiguo del archivo importado
+    for(int d = 0; d < total_origen; d++) {
+        RegistroHistorico registro;
+        if(diaImputado(origen, d)) {
+            continue; // Solo se importan lecturas reales
         }
-        
-        fprintf(archivo, "║  PM2.5: %6.1f ug/m3  │ Tendencia: ", pronostico_pm25);
-        if(tendencia_pm25 > 0) {
-            fprintf(archivo, "* SUBIENDO +%5.1f            ║\n", tendencia_pm25);
+        if(d < origen->dias_registrados) {
+            registro = registroDeZona(origen, d);
         } else {
-            fprintf(archivo, "* BAJANDO %6.1f            ║\n", tendencia_pm25);
+            registro = *registroArchivado(&origen->archivado, total_origen - 1 - d);
         }
+        if(tiene_datos && compararFechas(registro.fecha, limite) >= 0) {
+            continue;
+        }
+        limite = registro.fecha;
+        tiene_datos = 1;
+        agregarRegistroCuantiles(zona, &registro);
         
-        /* Calcular excesos proyectados */
-        int excesos_pronostico = 0;
-        if(pronostico_co2 > LIMITE_CO2_OMS) excesos_pronostico++;
-        if(pronostico_so2 > LIMITE_SO2_OMS) excesos_pronostico++;
-        if(pronostico_no2 > LIMITE_NO2_OMS) excesos_pronostico++;
-        if(pronostico_pm25 > LIMITE_PM25_OMS) excesos_pronostico++;
-        
-        fprintf(archivo, "║                                                                                  ║\n");
-        fprintf(archivo, "║  EXPECTATIVA DE CALIDAD:                                                       ║\n");
-        if(excesos_pronostico < excesos_actuales) {
-            fprintf(archivo, "║    * MEJORANDO - Se espera mejoria en las condiciones                           ║\n");
-        } else if(excesos_pronostico > excesos_actuales) {
-            fprintf(archivo, "║    ! EMPEORANDO - Se espera deterioro en las condiciones                       ║\n");
-        } else {
-            fprintf(archivo, "║    = ESTABLE - Condiciones similares esperadas                                 ║\n");
+        if(zona->dias_registrados < MAX_DIAS_HISTORICOS) {
+            zona->historico[zona->dias_registrados] = registro.niveles;
+            zona->historico_fechas[zona->dias_registrados] = registro;
+            zona->dias_registrados++;
+            en_ventana++;
+        } else if(!archivarRegistro(&nuevos, registro)) {
+            break;
         }
-    } else {
-        fprintf(archivo, "║ ! Datos insuficientes para generar pronostico confiable                        ║\n");
-        fprintf(archivo, "║    (Se requieren al menos 3 dias de datos historicos)                           ║\n");
     }
     
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n\n");
+    if(nuevos.num_registros == 0) {
+        return en_ventana;
+    }
     
-    /* RESUMEN ESTADISTICO */
-    if (zona->dias_registrados > 0) {
-        fprintf(archivo, "RESUMEN ESTADISTICO DEL PERIODO:\n");
-        fprintf(archivo, "===============================================================================\n");
-        
-        /* Calcular valores maximos y dias con excesos */
-        float max_co2 = zona->historico_fechas[0].niveles.co2;
-        float max_so2 = zona->historico_fechas[0].niveles.so2;
-        float max_no2 = zona->historico_fechas[0].niveles.no2;
-        float max_pm25 = zona->historico_fechas[0].niveles.pm25;
-        
-        float min_co2 = zona->historico_fechas[0].niveles.co2;
-        float min_so2 = zona->historico_fechas[0].niveles.so2;
-        float min_no2 = zona->historico_fechas[0].niveles.no2;
-        float min_pm25 = zona->historico_fechas[0].niveles.pm25;
-        
-        int dias_exceso = 0;
-        int dias_buenos = 0;
+    // Los días importados son anteriores a todo lo archivado: van delante
+    invertirHistoricoArchivado(&nuevos);
+    int correcto = 1;
+    for(int i = 0; correcto && i < zona->archivado.num_registros; i++) {
+        correcto = archivarRegistro(&nuevos, *registroArchivado(&zona->archivado, i));
+    }
+    if(!correcto) {
+        printf("ERROR: Memoria insuficiente para archivar los dias importados de %s.\n", zona->nombre);
+        liberarHistoricoArchivado(&nuevos);
+        return en_ventana;
+    }
+    int archivados = nuevos.num_registros - zona->archivado.num_registros;
+    liberarHistoricoArchivado(&zona->archivado);
+    zona->archivado = nuevos;
+    return en_ventana + archivados;
+}
+
+// Importación única del histórico de archivos zona_N.dat de otra carpeta (respaldos o
+// instalaciones anteriores, en cualquier formato soportado). Solo se agregan días
+// anteriores a los que ya tiene cada zona, así que copias de años distintos pueden
+// importarse una tras otra.
+void importarHistoricoLegado(ZonaUrbana zonas[]) {
+    char carpeta[200], nombre_archivo[300];
+    
+    printf("=== IMPORTAR HISTORICO ===\n");
+    printf("==========================\n\n");
+    do {
+        printf("Carpeta con los archivos zona_N.dat a importar: ");
+        leerCadena(carpeta, sizeof(carpeta));
+    } while(strlen(carpeta) == 0);
+    
+    ZonaUrbana *importada = malloc(sizeof(ZonaUrbana));
+    if(importada == NULL) {
+        printf("ERROR: Memoria insuficiente para la importacion.\n");
+        return;
+    }
+    
+    for(int i = 0; i < MAX_ZONAS; i++) {
+        ZonaUrbana *zona = &zonas[i];
+        EstadisticasCarga estadisticas;
         
-        int i;
-        for (i = 0; i < zona->dias_registrados; i++) {
-            /* Maximos */
-            if (zona->historico_fechas[i].niveles.co2 > max_co2) max_co2 = zona->historico_fechas[i].niveles.co2;
-            if (zona->historico_fechas[i].niveles.so2 > max_so2) max_so2 = zona->historico_fechas[i].niveles.so2;
-            if (zona->historico_fechas[i].niveles.no2 > max_no2) max_no2 = zona->historico_fechas[i].niveles.no2;
-            if (zona->historico_fechas[i].niveles.pm25 > max_pm25) max_pm25 = zona->historico_fechas[i].niveles.pm25;
-            
-            /* Minimos */
-            if (zona->historico_fechas[i].niveles.co2 < min_co2) min_co2 = zona->historico_fechas[i].niveles.co2;
-            if (zona->historico_fechas[i].niveles.so2 < min_so2) min_so2 = zona->historico_fechas[i].niveles.so2;
-            if (zona->historico_fechas[i].niveles.no2 < min_no2) min_no2 = zona->historico_fechas[i].niveles.no2;
-            if (zona->historico_fechas[i].niveles.pm25 < min_pm25) min_pm25 = zona->historico_fechas[i].niveles.pm25;
-            
-            /* Contar dias con excesos */
-            int excesos_dia = 0;
-            if (zona->historico_fechas[i].niveles.co2 > LIMITE_CO2_OMS) excesos_dia++;
-            if (zona->historico_fechas[i].niveles.so2 > LIMITE_SO2_OMS) excesos_dia++;
-            if (zona->historico_fechas[i].niveles.no2 > LIMITE_NO2_OMS) excesos_dia++;
-            if (zona->historico_fechas[i].niveles.pm25 > LIMITE_PM25_OMS) excesos_dia++;
-            
-            if(excesos_dia > 0) dias_exceso++;
-            else dias_buenos++;
+        if(zona->id_zona < 1) continue;
+        memset(&estadisticas, 0, sizeof(estadisticas));
+        sprintf(nombre_archivo, "%s/zona_%d.dat", carpeta, zona->id_zona);
+        if(!cargarArchivoZona(importada, nombre_archivo, &estadisticas)) {
+            printf("%-20.20s | sin archivo para importar\n", zona->nombre);
+            continue;
+        }
+        if(importada->id_zona != zona->id_zona) {
+            printf("%-20.20s | ERROR: el archivo pertenece a otra zona\n", zona->nombre);
+            liberarHistoricoArchivado(&importada->archivado);
+            continue;
         }
         
-        fprintf(archivo, "PROMEDIOS DEL PERIODO (%d dias):\n", zona->dias_registrados);
-        fprintf(archivo, "   CO2:   %.1f ppm\n", zona->promedio_30_dias[0]);
-        fprintf(archivo, "   SO2:   %.1f ug/m3\n", zona->promedio_30_dias[1]);
-        fprintf(archivo, "   NO2:   %.1f ug/m3\n", zona->promedio_30_dias[2]);
-        fprintf(archivo, "   PM2.5: %.1f ug/m3\n\n", zona->promedio_30_dias[3]);
-        
-        fprintf(archivo, "VALORES MAXIMOS REGISTRADOS:\n");
-        fprintf(archivo, "   CO2:   %.1f ppm\n", max_co2);
-        fprintf(archivo, "   SO2:   %.1f ug/m3\n", max_so2);
-        fprintf(archivo, "   NO2:   %.1f ug/m3\n", max_no2);
-        fprintf(archivo, "   PM2.5: %.1f ug/m3\n\n", max_pm25);
-        
-        fprintf(archivo, "VALORES MINIMOS REGISTRADOS:\n");
-        fprintf(archivo, "   CO2:   %.1f ppm\n", min_co2);
-        fprintf(archivo, "   SO2:   %.1f ug/m3\n", min_so2);
-        fprintf(archivo, "   NO2:   %.1f ug/m3\n", min_no2);
-        fprintf(archivo, "   PM2.5: %.1f ug/m3\n\n", min_pm25);
-        
-        fprintf(archivo, "ANALISIS DE CALIDAD:\n");
-        fprintf(archivo, "   Dias con buena calidad:    %2d de %2d (%.1f%%)\n", 
-                dias_buenos, zona->dias_registrados, 
-                (float)dias_buenos / zona->dias_registrados * 100.0);
-        fprintf(archivo, "   Dias con excesos OMS:      %2d de %2d (%.1f%%)\n", 
-                dias_exceso, zona->dias_registrados, 
-                (float)dias_exceso / zona->dias_registrados * 100.0);
+        if(!bloquearZona(zona->id_zona)) {
+            printf("%-20.20s | ERROR: zona bloqueada por otra instancia\n", zona->nombre);
+            liberarHistoricoArchivado(&importada->archivado);
+            continue;
+        }
+        refrescarZona(zona);
+        int agregados = importarDiasAnteriores(zona, importada);
+        if(agregados > 0) {
+            zona->modelos_ajustados = 0; // El histórico cambió: reajustar
+            zona->modificada = 1;
+            recalcularMapaExcesos(zona);
+            invalidarDerivados(zona, TODOS_LOS_DERIVADOS);
+            publicarInstantaneaZona(zona);
+            aplicarRetencionZona(zona);
+            guardarZonaBloqueada(zona);
+        }
+        desbloquearZona(zona->id_zona);
+        liberarHistoricoArchivado(&importada->archivado);
         
-        if(dias_exceso == 0) {
-            fprintf(archivo, "   EXCELENTE: Sin dias con excesos registrados\n");
-        } else if(dias_exceso <= zona->dias_registrados * 0.1) {
-            fprintf(archivo, "   BUENO: Muy pocos dias con excesos\n");
-        } else if(dias_exceso <= zona->dias_registrados * 0.3) {
-            fprintf(archivo, "   MODERADO: Algunos dias con excesos\n");
-        } else {
-            fprintf(archivo, "   PREOCUPANTE: Muchos dias con excesos\n");
+        printf("%-20.20s | %d dia(s) importado(s), %d dia(s) en total\n",
+               zona->nombre, agregados, diasTotalesZona(zona));
+    }
+    free(importada);
+    
+    printf("\nPresione Enter para continuar...");
+    getchar();
+}
+
+// ================ FUNCIONES PARA RETENCION DEL HISTORICO ================
+
+// Número de día desde el 01/01/1970 (calendario gregoriano)
+long numeroDeDia(Fecha fecha) {
+    long año = fecha.año - (fecha.mes <= 2);
+    long era = (año >= 0 ? año : año - 399) / 400;
+    long año_era = año - era * 400;
+    long dia_año = (153 * (fecha.mes + (fecha.mes > 2 ? -3 : 9)) + 2) / 5 + fecha.dia - 1;
+    long dia_era = año_era * 365 + año_era / 4 - año_era / 100 + dia_año;
+    return era * 146097 + dia_era - 719468;
+}
+
+// Fecha correspondiente a un número de día (inversa de numeroDeDia)
+Fecha fechaDeNumeroDeDia(long numero) {
+    Fecha fecha;
+    long z = numero + 719468;
+    long era = (z >= 0 ? z : z - 146096) / 146097;
+    long dia_era = z - era * 146097;
+    long año_era = (dia_era - dia_era / 1460 + dia_era / 36524 - dia_era / 146096) / 365;
+    long dia_año = dia_era - (365 * año_era + año_era / 4 - año_era / 100);
+    long mes_marzo = (5 * dia_año + 2) / 153; // Meses contados desde marzo
+    fecha.dia = dia_año - (153 * mes_marzo + 2) / 5 + 1;
+    fecha.mes = mes_marzo < 10 ? mes_marzo + 3 : mes_marzo - 9;
+    fecha.año = año_era + era * 400 + (fecha.mes <= 2);
+    return fecha;
+}
+
+// Semana (de lunes a domingo) a la que pertenece la fecha
+long numeroDeSemana(Fecha fecha) {
+    return (numeroDeDia(fecha) + 3) / 7; // El 01/01/1970 fue jueves
+}
+
+void iniciarAgregado(RegistroAgregado *agregado, Fecha inicio) {
+    memset(agregado, 0, sizeof(RegistroAgregado));
+    agregado->inicio = inicio;
+    agregado->fin = inicio;
+}
+
+void acumularEnAgregado(RegistroAgregado *agregado, RegistroHistorico registro) {
+    if(agregado->dias == 0 || registro.niveles.co2 > agregado->maximo.co2) agregado->maximo.co2 = registro.niveles.co2;
+    if(agregado->dias == 0 || registro.niveles.so2 > agregado->maximo.so2) agregado->maximo.so2 = registro.niveles.so2;
+    if(agregado->dias == 0 || registro.niveles.no2 > agregado->maximo.no2) agregado->maximo.no2 = registro.niveles.no2;
+    if(agregado->dias == 0 || registro.niveles.pm25 > agregado->maximo.pm25) agregado->maximo.pm25 = registro.niveles.pm25;
+    
+    agregado->suma.co2 += registro.niveles.co2;
+    agregado->suma.so2 += registro.niveles.so2;
+    agregado->suma.no2 += registro.niveles.no2;
+    agregado->suma.pm25 += registro.niveles.pm25;
+    agregado->suma_clima.temperatura += registro.clima.temperatura;
+    agregado->suma_clima.velocidad_viento += registro.clima.velocidad_viento;
+    agregado->suma_clima.humedad += registro.clima.humedad;
+    agregado->suma_clima.presion_atmosferica += registro.clima.presion_atmosferica;
+    agregado->fin = registro.fecha;
+    agregado->dias++;
+}
+
+void combinarAgregados(RegistroAgregado *destino, RegistroAgregado *origen) {
+    if(origen->dias == 0) {
+        return;
+    }
+    if(destino->dias == 0) {
+        *destino = *origen;
+        return;
+    }
+    if(origen->maximo.co2 > destino->maximo.co2) destino->maximo.co2 = origen->maximo.co2;
+    if(origen->maximo.so2 > destino->maximo.so2) destino->maximo.so2 = origen->maximo.so2;
+    if(origen->maximo.no2 > destino->maximo.no2) destino->maximo.no2 = origen->maximo.no2;
+    if(origen->maximo.pm25 > destino->maximo.pm25) destino->maximo.pm25 = origen->maximo.pm25;
+    
+    destino->suma.co2 += origen->suma.co2;
+    destino->suma.so2 += origen->suma.so2;
+    destino->suma.no2 += origen->suma.no2;
+    destino->suma.pm25 += origen->suma.pm25;
+    destino->suma_clima.temperatura += origen->suma_clima.temperatura;
+    destino->suma_clima.velocidad_viento += origen->suma_clima.velocidad_viento;
+    destino->suma_clima.humedad += origen->suma_clima.humedad;
+    destino->suma_clima.presion_atmosferica += origen->suma_clima.presion_atmosferica;
+    if(compararFechas(origen->inicio, destino->inicio) < 0) destino->inicio = origen->inicio;
+    if(compararFechas(origen->fin, destino->fin) > 0) destino->fin = origen->fin;
+    destino->dias += origen->dias;
+}
+
+// Clave de orden de un agregado: semana o mes en que empieza
+long claveAgregado(Fecha inicio, int mensual) {
+    return mensual ? inicio.año * 12L + inicio.mes - 1 : numeroDeSemana(inicio);
+}
+
+// Suma 'nuevo' en el agregado de su mismo periodo o lo inserta en orden. La lista debe
+// tener espacio para un elemento más.
+void insertarEnAgregados(RegistroAgregado *lista, int *num_registros, RegistroAgregado *nuevo, int mensual) {
+    long clave = claveAgregado(nuevo->inicio, mensual);
+    int i = *num_registros;
+    
+    // Lo habitual es añadir al final: se busca desde el periodo más reciente
+    while(i > 0 && claveAgregado(lista[i - 1].inicio, mensual) > clave) {
+        i--;
+    }
+    if(i > 0 && claveAgregado(lista[i - 1].inicio, mensual) == clave) {
+        combinarAgregados(&lista[i - 1], nuevo);
+        return;
+    }
+    memmove(lista + i + 1, lista + i, (*num_registros - i) * sizeof(RegistroAgregado));
+    lista[i] = *nuevo;
+    (*num_registros)++;
+}
+
+int fechaEnRango(Fecha fecha, Fecha desde, Fecha hasta) {
+    return desde.año != 0 && compararFechas(fecha, desde) >= 0 && compararFechas(fecha, hasta) <= 0;
+}
+
+// Lee un archivo de agregados completo, reservando 'adicionales' posiciones libres al
+// final. Un archivo inexistente equivale a uno vacío; los agregados con CRC incorrecto
+// se omiten. *registros queda en la arena.
+int leerArchivoAgregados(ArenaTemporal *arena, char *nombre_archivo, int adicionales,
+                         RegistroAgregado **registros, int *num_registros,
+                         CabeceraArchivoAgregados *cabecera) {
+    *num_registros = 0;
+    memset(cabecera, 0, sizeof(CabeceraArchivoAgregados));
+    
+    FILE *f = fopen(nombre_archivo, "rb");
+    if(f != NULL) {
+        if(fread(cabecera, sizeof(CabeceraArchivoAgregados), 1, f) != 1 ||
+           memcmp(cabecera->magia, MAGIA_ARCHIVO_AGREGADOS, 4) != 0 ||
+           cabecera->version != VERSION_ARCHIVO_AGREGADOS ||
+           cabecera->crc != calcularCRC32(cabecera, offsetof(CabeceraArchivoAgregados, crc)) ||
+           cabecera->num_registros < 0) {
+            fclose(f);
+            printf("ERROR: Cabecera danada en %s\n", nombre_archivo);
+            return 0;
         }
     }
     
-    fprintf(archivo, "\n");
+    int en_archivo = f != NULL ? cabecera->num_registros : 0;
+    *registros = reservarArena(arena, (en_archivo + adicionales + 1) * sizeof(RegistroAgregado));
+    MarcaArena marca = marcaArena(arena);
+    RegistroArchivoAgregado *contenido = reservarArena(arena, (en_archivo + 1) * sizeof(RegistroArchivoAgregado));
+    if(*registros == NULL || contenido == NULL) {
+        *registros = NULL;
+        if(f != NULL) fclose(f);
+        return 0;
+    }
     
-    /* PIE DEL REPORTE */
-    fprintf(archivo, "╔══════════════════════════════════════════════════════════════════════════════════╗\n");
-    fprintf(archivo, "║                              INFORMACION ADICIONAL                              ║\n");
-    fprintf(archivo, "╠══════════════════════════════════════════════════════════════════════════════════╣\n");
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "║  Para actualizaciones en tiempo real:    www.airnow-quito.gov.ec             ║\n");
-    fprintf(archivo, "║  Emergencias ambientales:                911                                  ║\n");
-    fprintf(archivo, "║  Salud respiratoria MSP:                  171                                  ║\n");
-    fprintf(archivo, "║  Los limites utilizados corresponden a las Guias OMS 2021                     ║\n");
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "║                Cuidemos juntos la calidad del aire de Quito                   ║\n");
-    fprintf(archivo, "║                                                                                  ║\n");
-    fprintf(archivo, "╚══════════════════════════════════════════════════════════════════════════════════╝\n");
-    fprintf(archivo, "                                                                                    \n");
-    fprintf(archivo, "              ███████ ███  ██ ██████   █████  ███████  ██████  ███████ ██████   █████  ██████  ████████\n");
-    fprintf(archivo, "              ██      ████ ██ ██   ██ ██   ██ ██      ██   ██ ██      ██   ██ ██   ██ ██   ██    ██   \n");
-    fprintf(archivo, "              █████   ██ ████ ██   ██ ██   ██ █████   ██████  █████   ██████  ██   ██ ██████     ██   \n");
-    fprintf(archivo, "              ██      ██  ███ ██   ██ ██   ██ ██      ██   ██ ██      ██      ██   ██ ██   ██    ██   \n");
-    fprintf(archivo, "              ███████ ██   ██ ██████   █████  ██      ██   ██ ███████ ██       █████  ██   ██    ██   \n");
-    fprintf(archivo, "                                                                                    \n");
+    int leidos = 0;
+    if(f != NULL) {
+        leidos = fread(contenido, sizeof(RegistroArchivoAgregado), en_archivo, f);
+        fclose(f);
+    }
+    for(int i = 0; i < leidos; i++) {
+        if(contenido[i].crc == calcularCRC32(&contenido[i].agregado, sizeof(RegistroAgregado))) {
+            (*registros)[(*num_registros)++] = contenido[i].agregado;
+        }
+    }
+    if(*num_registros < en_archivo) {
+        printf("ADVERTENCIA: %d agregado(s) danado(s) omitido(s) en %s\n",
+               en_archivo - *num_registros, nombre_archivo);
+    }
+    restaurarArena(arena, marca);
+    return 1;
+}
+
+// Escribe un archivo de agregados con el mismo esquema temporal + renombrado que las zonas
+int escribirArchivoAgregados(char *nombre_archivo, RegistroAgregado *registros, int num_registros,
+                             Fecha desde, Fecha hasta) {
+    char nombre_temporal[120];
+    sprintf(nombre_temporal, "%s.tmp", nombre_archivo);
+    
+    FILE *f = fopen(nombre_temporal, "wb");
+    if(f == NULL) {
+        return 0;
+    }
     
-    fclose(archivo);
-    printf("Reporte AirQuality exportado exitosamente: %s\n", nombre_archivo);
+    CabeceraArchivoAgregados cabecera;
+    memset(&cabecera, 0, sizeof(cabecera));
+    memcpy(cabecera.magia, MAGIA_ARCHIVO_AGREGADOS, 4);
+    cabecera.version = VERSION_ARCHIVO_AGREGADOS;
+    cabecera.num_registros = num_registros;
+    cabecera.desde = desde;
+    cabecera.hasta = hasta;
+    cabecera.crc = calcularCRC32(&cabecera, offsetof(CabeceraArchivoAgregados, crc));
+    
+    int correcto = fwrite(&cabecera, sizeof(cabecera), 1, f) == 1;
+    for(int i = 0; correcto && i < num_registros; i++) {
+        RegistroArchivoAgregado registro;
+        memset(&registro, 0, sizeof(registro));
+        registro.agregado = registros[i];
+        registro.crc = calcularCRC32(&registro.agregado, sizeof(RegistroAgregado));
+        correcto = fwrite(&registro, sizeof(registro), 1, f) == 1;
+    }
+    // Los datos de origen se descartan tras escribir el agregado: debe llegar al disco
+    if(correcto) {
+        sincronizarArchivo(f);
+    }
+    if(fclose(f) != 0) {
+        correcto = 0;
+    }
+    if(!correcto || reemplazarArchivo(nombre_temporal, nombre_archivo) != 0) {
+        remove(nombre_temporal);
+        return 0;
+    }
+    return 1;
 }
 
-void menuExportarReportes(ZonaUrbana zonas[]) {
-    printf("=== EXPORTAR REPORTES ===\n");
-    printf("==========================\n\n");
+// Pasa las semanas más antiguas que exceden MAX_SEMANAS_AGREGADAS a agregados mensuales
+// (cada semana cuenta en el mes en que empieza)
+int compactarSemanasEnMeses(int id_zona, RegistroAgregado *semanas, int *num_semanas,
+                            CabeceraArchivoAgregados *cabecera_semanas) {
+    char archivo_semanas[100], archivo_meses[100];
+    RegistroAgregado *meses;
+    CabeceraArchivoAgregados cabecera;
+    int num_meses;
+    int exceso = *num_semanas - MAX_SEMANAS_AGREGADAS;
+    
+    sprintf(archivo_semanas, "zona_%d_semanas.dat", id_zona);
+    sprintf(archivo_meses, "zona_%d_meses.dat", id_zona);
+    if(!leerArchivoAgregados(arenaReportes(), archivo_meses, exceso, &meses, &num_meses, &cabecera)) {
+        return 0;
+    }
     
-    printf("Zonas disponibles:\n");
-    for(int i = 0; i < MAX_ZONAS; i++) {
-        printf("%d. %s\n", zonas[i].id_zona, zonas[i].nombre);
+    for(int i = 0; i < exceso; i++) {
+        // Semanas ya sumadas por una compactación que no llegó a reescribir las semanas
+        if(fechaEnRango(semanas[i].inicio, cabecera.desde, cabecera.hasta)) continue;
+        insertarEnAgregados(meses, &num_meses, &semanas[i], 1);
     }
     
-    int zona_id, val;
-    do {
-        printf("\nIngrese el ID de la zona (1-%d): ", MAX_ZONAS);
-        val = scanf("%d", &zona_id);
-        fflush(stdin);
+    int correcto = escribirArchivoAgregados(archivo_meses, meses, num_meses,
+                                            semanas[0].inicio, semanas[exceso - 1].inicio);
+    if(!correcto) {
+        return 0;
+    }
+    memmove(semanas, semanas + exceso, (*num_semanas - exceso) * sizeof(RegistroAgregado));
+    *num_semanas -= exceso;
+    return escribirArchivoAgregados(archivo_semanas, semanas, *num_semanas,
+                                    cabecera_semanas->desde, cabecera_semanas->hasta);
+}
+
+// Mantiene acotada la memoria del histórico: los días archivados que exceden
+// MAX_DIAS_ARCHIVADOS se agregan por semana en zona_N_semanas.dat y se descartan de
+// memoria, y las semanas más antiguas pasan a zona_N_meses.dat. Devuelve los días
+// compactados (la zona queda modificada y debe guardarse).
+int aplicarRetencionZona(ZonaUrbana *zona) {
+    char archivo_semanas[100];
+    RegistroAgregado *semanas;
+    CabeceraArchivoAgregados cabecera;
+    int num_semanas;
+    int exceso = zona->archivado.num_registros - MAX_DIAS_ARCHIVADOS;
+    
+    if(exceso <= 0) {
+        return 0;
+    }
+    sprintf(archivo_semanas, "zona_%d_semanas.dat", zona->id_zona);
+    // Como máximo una semana nueva por día compactado
+    ArenaTemporal *arena = arenaReportes();
+    MarcaArena marca = marcaArena(arena);
+    if(!leerArchivoAgregados(arena, archivo_semanas, exceso, &semanas, &num_semanas, &cabecera)) {
+        restaurarArena(arena, marca);
+        return 0;
+    }
+    
+    for(int i = 0; i < exceso; i++) {
+        RegistroHistorico registro = *registroArchivado(&zona->archivado, i);
+        // Días ya sumados por una compactación cuya zona no llegó a guardarse
+        if(fechaEnRango(registro.fecha, cabecera.desde, cabecera.hasta)) continue;
         
-        if(val != 1 || zona_id < 1 || zona_id > MAX_ZONAS) {
-            printf("ID de zona inválido. Por favor, intente de nuevo.\n");
+        RegistroAgregado dia;
+        iniciarAgregado(&dia, registro.fecha);
+        acumularEnAgregado(&dia, registro);
+        insertarEnAgregados(semanas, &num_semanas, &dia, 0);
+    }
+    cabecera.desde = registroArchivado(&zona->archivado, 0)->fecha;
+    cabecera.hasta = registroArchivado(&zona->archivado, exceso - 1)->fecha;
+    
+    int correcto = escribirArchivoAgregados(archivo_semanas, semanas, num_semanas,
+                                            cabecera.desde, cabecera.hasta);
+    if(correcto) {
+        descartarArchivadosAntiguos(&zona->archivado, exceso);
+        zona->modificada = 1;
+        if(num_semanas > MAX_SEMANAS_AGREGADAS &&
+           !compactarSemanasEnMeses(zona->id_zona, semanas, &num_semanas, &cabecera)) {
+            printf("ADVERTENCIA: No se pudieron compactar las semanas de %s en meses.\n", zona->nombre);
         }
-    } while(val != 1 || zona_id < 1 || zona_id > MAX_ZONAS);
+    } else {
+        printf("ERROR: No se pudo escribir %s; el historico se conserva en memoria.\n", archivo_semanas);
+    }
+    restaurarArena(arena, marca);
+    return correcto ? exceso : 0;
+}
+
+// Primer día del histórico compactado en disco (meses o semanas), si existe
+int primerDiaAgregado(int id_zona, Fecha *fecha) {
+    char nombre_archivo[100];
+    char *capas[] = {"meses", "semanas"};
+    int encontrado = 0;
+    ArenaTemporal *arena = arenaReportes();
+    
+    for(int c = 0; c < 2; c++) {
+        RegistroAgregado *agregados;
+        CabeceraArchivoAgregados cabecera;
+        int num_agregados;
+        MarcaArena marca = marcaArena(arena);
+        sprintf(nombre_archivo, "zona_%d_%s.dat", id_zona, capas[c]);
+        if(leerArchivoAgregados(arena, nombre_archivo, 0, &agregados, &num_agregados, &cabecera) &&
+           num_agregados > 0 && (!encontrado || compararFechas(agregados[0].inicio, *fecha) < 0)) {
+            *fecha = agregados[0].inicio;
+            encontrado = 1;
+        }
+        restaurarArena(arena, marca);
+    }
+    return encontrado;
+}
+
+// Suma un agregado en el resumen del año en que empieza
+void sumarEnResumenAnual(RegistroAgregado resumen[], int *num_anios, int max_anios, RegistroAgregado *agregado) {
+    for(int i = 0; i < *num_anios; i++) {
+        if(resumen[i].inicio.año == agregado->inicio.año) {
+            combinarAgregados(&resumen[i], agregado);
+            return;
+        }
+    }
+    if(*num_anios < max_anios) {
+        resumen[(*num_anios)++] = *agregado;
+    }
+}
+
+// Resumen por año con todas las capas del histórico: meses y semanas en disco, días
+// archivados y ventana en memoria. Devuelve los años, del más antiguo al más reciente.
+int resumenAnualZona(ZonaUrbana *zona, RegistroAgregado resumen[], int max_anios) {
+    char nombre_archivo[100];
+    char *capas[] = {"meses", "semanas"};
+    int num_anios = 0;
+    
+    ArenaTemporal *arena = arenaReportes();
+    
+    for(int c = 0; c < 2; c++) {
+        RegistroAgregado *agregados;
+        CabeceraArchivoAgregados cabecera;
+        int num_agregados;
+        MarcaArena marca = marcaArena(arena);
+        sprintf(nombre_archivo, "zona_%d_%s.dat", zona->id_zona, capas[c]);
+        if(leerArchivoAgregados(arena, nombre_archivo, 0, &agregados, &num_agregados, &cabecera)) {
+            for(int i = 0; i < num_agregados; i++) {
+                sumarEnResumenAnual(resumen, &num_anios, max_anios, &agregados[i]);
+            }
+        }
+        restaurarArena(arena, marca);
+    }
     
-    exportarReportePorZona(zonas, zona_id);
+    for(int i = 0; i < diasTotalesZona(zona); i++) {
+        RegistroAgregado dia;
+        RegistroHistorico registro;
+        if(i < zona->archivado.num_registros) {
+            registro = *registroArchivado(&zona->archivado, i);
+        } else if(diaExcluidoDeAnalisis(zona, diasTotalesZona(zona) - 1 - i)) {
+            continue; // Día imputado o duplicado de la ventana
+        } else {
+            registro = registroDeZona(zona, diasTotalesZona(zona) - 1 - i);
+        }
+        iniciarAgregado(&dia, registro.fecha);
+        acumularEnAgregado(&dia, registro);
+        sumarEnResumenAnual(resumen, &num_anios, max_anios, &dia);
+    }
     
-    printf("\nPresione Enter para continuar...");
-    getchar();
+    // Orden cronológico (inserción: pocos años)
+    for(int i = 1; i < num_anios; i++) {
+        RegistroAgregado actual = resumen[i];
+        int j = i - 1;
+        while(j >= 0 && resumen[j].inicio.año > actual.inicio.año) {
+            resumen[j + 1] = resumen[j];
+            j--;
+        }
+        resumen[j + 1] = actual;
+    }
+    return num_anios;
 }
-
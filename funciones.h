@@ -8,6 +8,15 @@
 #define LIMITE_NO2_OMS 25.0      // µg/m³ (24h)
 #define LIMITE_PM25_OMS 15.0     // µg/m³ (24h)
 
+// Configuración en tiempo de ejecución: los límites anteriores y los múltiplos de alerta
+// son los valores por defecto si el archivo no los define
+#define ARCHIVO_CONFIGURACION "configuracion.cfg"
+#define MULTIPLICADOR_ALERTA_AMARILLA 1.5
+#define MULTIPLICADOR_ALERTA_NARANJA 2.0
+#define MAX_PERFILES_UMBRALES 8   // Perfiles de límites para zonas sensibles (escuelas, hospitales)
+#define MAX_NOMBRE_PERFIL 32
+#define PERFIL_GENERAL 0          // Zona sin perfil: usa los límites generales
+
 // Niveles de alerta
 #define ALERTA_VERDE 0
 #define ALERTA_AMARILLA 1
@@ -20,6 +29,126 @@
 #define PESO_DIA_3 0.2    // Tercer día
 #define PESO_RESTO 0.1    // Días anteriores
 
+// Histórico archivado (días anteriores a los MAX_DIAS_HISTORICOS más recientes)
+#define REGISTROS_POR_BLOQUE 64   // Días por bloque
+#define BLOQUES_POR_RESERVA 16    // Bloques que se piden juntos al sistema
+
+// Retención: los días crudos más antiguos pasan a agregados semanales y mensuales en disco
+#define MAX_DIAS_ARCHIVADOS 365   // Días crudos archivados en memoria además de la ventana
+#define MAX_SEMANAS_AGREGADAS 156 // Semanas (3 años) antes de pasar a agregados mensuales
+#define MAGIA_ARCHIVO_AGREGADOS "ZQAG"
+#define VERSION_ARCHIVO_AGREGADOS 1
+#define MAX_ANIOS_RESUMEN 50      // Años del resumen de largo plazo
+
+// Formato de los archivos de zona
+#define MAGIA_ARCHIVO_ZONA "ZQAI"
+#define VERSION_ARCHIVO_ZONA 3
+#define LOTE_SINCRONIZACION 8     // Guardados entre sincronizaciones con el disco
+
+// Bloqueo de zonas entre instancias (archivo zona_N.lck)
+#define INTENTOS_BLOQUEO 100
+#define ESPERA_BLOQUEO_MS 20      // Espera entre intentos
+#define ANTIGUEDAD_BLOQUEO_SEG 30 // Un bloqueo más antiguo se considera abandonado
+
+// Instantáneas del histórico para reportes
+#define MAX_SEGMENTOS_INSTANTANEA 16 // Al llenarse, los segmentos se compactan en uno
+
+// Arena de memoria temporal para reportes y análisis
+#define TAM_INICIAL_ARENA 65536   // Bytes del primer bloque
+#define ALINEACION_ARENA 16
+
+// Salida con buffer para tablas largas
+#define TAM_BUFFER_SALIDA 32768   // Bytes acumulados antes de escribir
+
+// Visor paginado del historial
+#define FILAS_POR_PAGINA 20
+
+// Campos corregibles de un día (misma numeración que el editor)
+#define CAMPO_CO2 1
+#define CAMPO_SO2 2
+#define CAMPO_NO2 3
+#define CAMPO_PM25 4
+#define CAMPO_TEMPERATURA 5
+#define CAMPO_VIENTO 6
+#define CAMPO_HUMEDAD 7
+#define CAMPO_PRESION 8
+#define NUM_CAMPOS_CORRECCION 8
+
+// Detección de anomalías al registrar lecturas
+#define VENTANA_ANOMALIAS 30      // Lecturas recientes por contaminante
+#define MIN_LECTURAS_ANOMALIA 7   // Lecturas antes de empezar a evaluar
+#define UMBRAL_Z_ROBUSTO 3.5      // |z| con mediana y MAD para marcar un valor atípico
+#define UMBRAL_Z_CLASICO 4.0      // |z| con media y desviación si la MAD es cero
+#define DIAS_SENSOR_PLANO 5       // Lecturas idénticas seguidas que indican un sensor trabado
+#define ANOMALIA_ATIPICA 1
+#define ANOMALIA_SENSOR_PLANO 2
+#define ARCHIVO_ANOMALIAS "anomalias.log"
+
+// Huecos y fechas repetidas en la ventana de historico[]
+#define MAX_DIAS_IMPUTABLES 6     // Huecos más largos se informan pero no se completan
+#define PERIODO_ESTACIONAL 7      // Ciclo semanal usado en la interpolación estacional
+#define PALABRAS_MAPA_DIAS ((MAX_DIAS_HISTORICOS + 31) / 32)
+
+// Mapas de excesos sobre el límite OMS (un bit por día y contaminante: 4 bits por día)
+#define DIAS_MAPA_EXCESOS (MAX_DIAS_HISTORICOS + MAX_DIAS_ARCHIVADOS) // Ventana + archivados en memoria
+#define PALABRAS_MAPA_EXCESOS ((DIAS_MAPA_EXCESOS + 31) / 32)
+
+// Correlaciones entre variables y entre zonas
+#define VARIABLES_CORRELACION 8   // 4 contaminantes y 4 variables climáticas por zona
+#define COLUMNAS_CORRELACION (MAX_ZONAS * VARIABLES_CORRELACION)
+#define MAX_DIAS_CORRELACION (MAX_DIAS_HISTORICOS + MAX_DIAS_ARCHIVADOS)
+#define MAX_DESFASE_CORRELACION 7 // Días de adelanto o retraso entre zonas
+#define MIN_DIAS_CORRELACION 10   // Días en común para calcular una correlación
+#define TAM_BLOQUE_CORRELACION 128 // Días por bloque en los productos cruzados
+#define CORRELACION_NO_DISPONIBLE -2.0
+#define ARCHIVO_MATRIZ_CORRELACION "matriz_correlacion.csv"
+
+// Resúmenes de percentiles (t-digest por zona, año y contaminante)
+#define COMPRESION_DIGEST 50.0    // Mayor = centroides más finos en las colas
+#define MAX_CENTROIDES_DIGEST 320 // Tope de memoria; un año usa unos 120
+#define PENDIENTES_DIGEST 32      // Lecturas acumuladas antes de compactar
+#define MAGIA_ARCHIVO_CUANTILES "ZQCU"
+#define VERSION_ARCHIVO_CUANTILES 1
+
+// Índice de calidad del aire (tablas de cortes de la EPA)
+#define TAM_TABLA_ICA 8           // Tramos por tabla (potencia de 2; los sobrantes son relleno)
+#define PERIODO_ICA_1H 0
+#define PERIODO_ICA_24H 1
+#define NUM_PERIODOS_ICA 2
+#define ICA_MAXIMO 500
+#define NUM_CATEGORIAS_ICA 6      // Bueno, Moderado, Dañino sensibles, Dañino, Muy dañino, Peligroso
+#define CORTE_SIN_USO 1e30         // Inicio de los tramos de relleno: nunca se alcanza
+#define ARCHIVO_SERIE_ICA "serie_ica.csv"
+
+// Pronóstico multi-horizonte
+#define NUM_HORIZONTES 4          // 24h, 48h, 72h y 7 días
+#define MAX_HORIZONTE_DIAS 7      // Último día pronosticado
+
+// Valores derivados de cada zona, recalculados al pedirlos si cambió algo de lo que dependen
+#define NUM_DERIVADOS 4
+#define DERIVADO_PROMEDIO_30 0    // promedio_30_dias
+#define DERIVADO_ESTADISTICAS 1   // Promedio, máximo y mínimo de la ventana
+#define DERIVADO_PRONOSTICO 2     // Pronóstico multi-horizonte
+#define DERIVADO_ALERTAS 3        // Alertas e ICA actuales y alerta pronosticada
+#define TODOS_LOS_DERIVADOS ((1 << NUM_DERIVADOS) - 1)
+#define ENTRADA_CONTAMINANTES 1   // Datos de los que puede depender un derivado
+#define ENTRADA_CLIMA 2
+#define DIAS_PROMEDIO_MOVIL 30
+
+// Modelo estadístico (suavizado exponencial doble de Holt)
+#define NUM_CANDIDATOS_ALFA 5
+#define NUM_CANDIDATOS_BETA 5
+#define NUM_CANDIDATOS_HOLT (NUM_CANDIDATOS_ALFA * NUM_CANDIDATOS_BETA)
+#define VENTANA_ERROR_HOLT 30     // Días del error cuadrático medio móvil
+
+// Evaluación del pronóstico sobre el histórico (backtest)
+#define NUM_CONJUNTOS_PESOS 6     // Conjuntos de pesos comparados
+
+// Malla de contaminación de la ciudad (interpolación IDW)
+#define MAX_DIMENSION_MALLA 4000  // Filas/columnas máximas del ráster
+#define TAM_BLOQUE_MALLA 64       // Lado del bloque para recorrer la malla por caché
+#define MARGEN_MALLA 0.02         // Margen en grados alrededor de las estaciones
+
 // Estructura para datos climáticos
 typedef struct {
     float temperatura;
@@ -50,6 +179,200 @@ typedef struct {
     DatosClimaticos clima;
 } RegistroHistorico;
 
+// Estructura para coordenadas geográficas de una zona (grados decimales)
+typedef struct {
+    float latitud;
+    float longitud;
+} CoordenadasZona;
+
+// Estado del modelo de Holt para un par de parámetros (alfa, beta)
+typedef struct {
+    float nivel;
+    float tendencia;
+    float error_cuadratico; // Error cuadrático medio de las predicciones a 1 día
+} EstadoHolt;
+
+// Modelo de Holt de un contaminante: todos los candidatos de la rejilla (alfa, beta)
+// se actualizan con cada lectura y se usa el de menor error
+typedef struct {
+    EstadoHolt candidatos[NUM_CANDIDATOS_HOLT];
+    int mejor;
+    int observaciones;
+} ModeloHolt;
+
+// Ventana móvil de un contaminante para detectar anomalías. Las sumas dan media y
+// varianza en O(1); la copia ordenada da mediana y MAD sin ordenar en cada lectura.
+typedef struct {
+    float valores[VENTANA_ANOMALIAS];   // Anillo en orden de llegada
+    float ordenados[VENTANA_ANOMALIAS]; // Los mismos valores ordenados
+    int inicio;                         // Posición de la lectura más antigua del anillo
+    int cantidad;
+    double suma;
+    double suma_cuadrados;
+    float ultima_lectura;
+    int lecturas_iguales;               // Lecturas seguidas iguales a ultima_lectura
+} DetectorAnomalias;
+
+// Lectura marcada por el detector
+typedef struct {
+    int contaminante;  // 0 = CO2, 1 = SO2, 2 = NO2, 3 = PM2.5
+    int tipo;          // ANOMALIA_ATIPICA o ANOMALIA_SENSOR_PLANO
+    float valor;
+    float mediana;
+    float mad;
+    float z;
+    int lecturas_iguales;
+} AnomaliaDetectada;
+
+// Series diarias de todas las zonas sobre un eje de fechas común, por columnas
+// (columna = zona * VARIABLES_CORRELACION + variable). Cada columna es continua entre
+// inicio y fin (los días faltantes intermedios se interpolan) y vale 0 fuera de ese
+// rango, así que un producto cruzado sobre todo el eje solo suma los días en común.
+typedef struct {
+    int num_dias;
+    long primer_dia;           // numeroDeDia() del día 0 del eje
+    float *valores;            // [columna * num_dias + dia]
+    double *sumas;             // Sumas acumuladas [columna * (num_dias + 1) + dia]
+    double *sumas_cuadrados;
+    int inicio[COLUMNAS_CORRELACION];
+    int fin[COLUMNAS_CORRELACION]; // Exclusivo; inicio == fin si la zona no tiene datos
+    int interpolados;          // Días intermedios sin lectura completados
+} SeriesCorrelacion;
+
+// Centroide de un t-digest: media de las lecturas agrupadas y cuántas son
+typedef struct {
+    float media;
+    float peso;
+} CentroideDigest;
+
+// Resumen mezclable de la distribución de un contaminante (t-digest). Los centroides
+// están ordenados por media; cerca de los extremos agrupan pocas lecturas, así que los
+// percentiles altos (P95, P99) salen casi exactos con memoria fija.
+typedef struct {
+    CentroideDigest centroides[MAX_CENTROIDES_DIGEST];
+    int num_centroides;
+    float pendientes[PENDIENTES_DIGEST]; // Lecturas aún no incorporadas a los centroides
+    int num_pendientes;
+    double total;                        // Lecturas resumidas (centroides + pendientes)
+    float minimo;
+    float maximo;
+} DigestCuantiles;
+
+// Resúmenes de un año calendario de la zona, uno por contaminante
+typedef struct {
+    int año;
+    DigestCuantiles digest[4];
+} CuantilesAnio;
+
+// Cabecera de los archivos zona_N_cuantiles.dat
+typedef struct {
+    char magia[4];             // MAGIA_ARCHIVO_CUANTILES
+    int version;
+    int num_anios;
+    int tamano_registro;       // sizeof(CuantilesAnio)
+    unsigned int generacion;   // Generación de zona_N.dat publicada junto con este archivo
+    unsigned int crc;          // CRC32 de los campos anteriores
+} CabeceraArchivoCuantiles;
+
+// Año de resúmenes en archivo, con su propio CRC32
+typedef struct {
+    CuantilesAnio anio;
+    unsigned int crc;
+} RegistroArchivoCuantiles;
+
+// Tabla de cortes de un contaminante para un periodo de promedio. El tramo k va de
+// concentracion_baja[k] a concentracion_alta[k] (en la unidad de la tabla) y se
+// proyecta linealmente entre indice_bajo[k] e indice_alto[k].
+typedef struct {
+    float concentracion_baja[TAM_TABLA_ICA]; // Ordenada; los tramos sin uso llevan un valor enorme
+    float concentracion_alta[TAM_TABLA_ICA];
+    float indice_bajo[TAM_TABLA_ICA];
+    float indice_alto[TAM_TABLA_ICA];
+    int tramos;                              // 0 = sin tabla para ese periodo
+    float microgramos_por_unidad;            // ug/m3 por unidad de la tabla (ppb); 1 si ya es ug/m3
+    float resolucion;                        // La concentración se trunca a esta resolución
+} TablaICA;
+
+// ICA de un día: el índice es el mayor de los subíndices por contaminante
+typedef struct {
+    int indice;
+    int subindices[4];          // Por contaminante como en obtenerNivelContaminante; -1 sin tabla (CO2)
+    int contaminante_principal; // El de mayor subíndice
+    int categoria;              // 0 = Bueno ... NUM_CATEGORIAS_ICA - 1 = Peligroso
+} ResultadoICA;
+
+// Estructura para pronóstico de varios días (24h, 48h, 72h, 7d)
+typedef struct {
+    int zona_id;
+    int dias_horizonte[NUM_HORIZONTES];
+    float niveles[NUM_HORIZONTES][4];  // [horizonte][CO2, SO2, NO2, PM2.5]
+    int nivel_alerta[NUM_HORIZONTES];  // Alerta general (la más alta) por horizonte
+    DatosClimaticos clima_predicho;
+} PronosticoZona;
+
+// Promedio, máximo y mínimo de cada contaminante en la ventana
+typedef struct {
+    float promedio[4];
+    float maximo[4];
+    float minimo[4];
+} EstadisticasVentana;
+
+// Alertas de una zona: por contaminante según los niveles actuales y la del pronóstico
+typedef struct {
+    int nivel[4];
+    int general;            // La más alta de las cuatro
+    ResultadoICA ica;       // De los niveles actuales (tablas de 24 horas)
+    int general_24h;        // Alerta general pronosticada a 24h; -1 sin datos suficientes
+} AlertasZona;
+
+// Nodo del grafo de derivados: qué datos lee y de qué otros derivados depende
+typedef struct {
+    int entradas;           // ENTRADA_CONTAMINANTES | ENTRADA_CLIMA
+    int depende_de;         // Bit n: usa el derivado n
+} NodoDerivado;
+
+// Bloque de días del histórico archivado, tomado de un pool compartido
+typedef struct BloqueHistorico {
+    RegistroHistorico registros[REGISTROS_POR_BLOQUE];
+    struct BloqueHistorico *siguiente_libre; // Enlace en la lista de bloques libres
+} BloqueHistorico;
+
+// Días más antiguos que la ventana de MAX_DIAS_HISTORICOS, en orden cronológico
+// (el índice 0 es el día más antiguo)
+typedef struct {
+    BloqueHistorico **bloques;
+    int num_bloques;
+    int capacidad_bloques;
+    int primero;          // Posición del día más antiguo dentro del primer bloque
+    int num_registros;
+} HistoricoArchivado;
+
+// Agregado de un periodo (semana, mes o año) del histórico
+typedef struct {
+    Fecha inicio;                  // Primer día con datos del periodo
+    Fecha fin;                     // Último día con datos del periodo
+    int dias;
+    NivelesContaminacion suma;     // Promedio = suma / dias
+    NivelesContaminacion maximo;
+    DatosClimaticos suma_clima;
+} RegistroAgregado;
+
+// Cabecera de los archivos zona_N_semanas.dat y zona_N_meses.dat
+typedef struct {
+    char magia[4];        // MAGIA_ARCHIVO_AGREGADOS
+    int version;
+    int num_registros;
+    Fecha desde;          // Rango de la última compactación (días o inicios de semana),
+    Fecha hasta;          // para no sumarla dos veces si la zona no llegó a guardarse
+    unsigned int crc;     // CRC32 de los campos anteriores
+} CabeceraArchivoAgregados;
+
+// Agregado en archivo, cada uno con su propio CRC32
+typedef struct {
+    RegistroAgregado agregado;
+    unsigned int crc;
+} RegistroArchivoAgregado;
+
 // Estructura para límites OMS
 typedef struct {
     float co2_limite;
@@ -58,6 +381,43 @@ typedef struct {
     float pm25_limite;
 } LimitesOMS;
 
+// Perfil de umbrales: límites propios para las zonas que lo usan
+typedef struct {
+    char nombre[MAX_NOMBRE_PERFIL];
+    float limites[4];               // Por contaminante como en obtenerNivelContaminante
+} PerfilUmbrales;
+
+// Límites, umbrales de alerta y factores de ajuste climático vigentes. Una configuración
+// publicada no se modifica: recargar arma otra y cambia el puntero.
+typedef struct {
+    LimitesOMS limites;
+    float multiplicador_amarilla;   // Hasta este múltiplo del límite: alerta amarilla
+    float multiplicador_naranja;    // Hasta este múltiplo: naranja; por encima, roja
+    float temperatura_alta;         // °C; por encima se aplica factor_temperatura_alta
+    float factor_temperatura_alta;
+    float temperatura_baja;         // °C; por debajo se aplica factor_temperatura_baja
+    float factor_temperatura_baja;
+    float viento_fuerte;            // km/h; por encima dispersa
+    float factor_viento_fuerte;
+    float viento_calmo;             // km/h; por debajo acumula
+    float factor_viento_calmo;
+    float humedad_alta;             // %
+    float factor_humedad_alta;
+    float presion_baja;             // hPa
+    float factor_presion_baja;
+    PerfilUmbrales perfiles[MAX_PERFILES_UMBRALES];
+    int num_perfiles;
+    int perfil_zona[MAX_ZONAS];     // Por id de zona - 1: 1 + índice en perfiles, o PERFIL_GENERAL
+} ConfiguracionSistema;
+
+// Clave del archivo de configuración y campo de ConfiguracionSistema que define
+typedef struct {
+    const char *clave;
+    size_t desplazamiento;          // offsetof del campo (float)
+    float minimo;
+    float maximo;
+} ClaveConfiguracion;
+
 // Estructura para una zona urbana
 typedef struct {
     char nombre[MAX_NOMBRE];
@@ -68,8 +428,181 @@ typedef struct {
     DatosClimaticos clima_actual;
     float promedio_30_dias[4]; // Para CO₂, SO₂, NO₂, PM2.5
     int dias_registrados;
+    CoordenadasZona ubicacion; // Punto de la estación de monitoreo
+    ModeloHolt modelos[4];     // Modelo estadístico por contaminante
+    int modelos_ajustados;     // 0 = pendiente de ajuste con todo el histórico
+    int modificada;            // Cambios en memoria aún no escritos en zona_N.dat
+    unsigned int generacion;   // Generación del archivo con que coincide la memoria
+    HistoricoArchivado archivado; // Días anteriores a la ventana de historico[]
+    DetectorAnomalias detectores[4]; // Solo en memoria, se preparan con la ventana
+    int detectores_listos;           // 0 = pendientes de preparar
+    unsigned int dias_imputados[PALABRAS_MAPA_DIAS];  // Bit i: historico[i] completado al cargar (no se guarda)
+    unsigned int dias_duplicados[PALABRAS_MAPA_DIAS]; // Bit i: historico[i] repite la fecha de un día más reciente
+    int huecos_sin_completar;        // Huecos de más de MAX_DIAS_IMPUTABLES días en la ventana
+    unsigned int excesos[4][PALABRAS_MAPA_EXCESOS]; // Bit i del contaminante c: el día i del histórico completo excede su límite
+    CuantilesAnio *cuantiles;        // Percentiles por año, de más antiguo a más reciente
+    int num_anios_cuantiles;
+    float limites[4];                    // Límites de la zona según su perfil, resueltos al cargar
+    char perfil[MAX_NOMBRE_PERFIL];      // Nombre del perfil, "general" si no tiene
+    int derivados_pendientes;            // Bit n: el derivado n se recalcula al pedirlo
+    int alcance_derivados[NUM_DERIVADOS]; // Días de la ventana (desde el más reciente) que leyó cada uno
+    EstadisticasVentana estadisticas;
+    PronosticoZona pronostico;
+    int pronostico_disponible;           // 0 = menos de 3 días distintos
+    AlertasZona alertas;
 } ZonaUrbana;
 
+// Cabecera de los archivos zona_N.dat
+typedef struct {
+    char magia[4];        // MAGIA_ARCHIVO_ZONA
+    int version;
+    int num_registros;    // Días guardados a continuación del bloque de zona
+    int tamano_registro;  // sizeof(RegistroHistorico) al escribir
+    unsigned int generacion; // Se incrementa en cada guardado
+    unsigned int crc;     // CRC32 de los campos anteriores
+} CabeceraArchivoZona;
+
+// Cabecera de la versión 2 (sin generación), solo para lectura
+typedef struct {
+    char magia[4];
+    int version;
+    int num_registros;
+    int tamano_registro;
+    unsigned int crc;
+} CabeceraArchivoZonaV2;
+
+// Datos de la zona sin el histórico, tal como se guardan tras la cabecera
+typedef struct {
+    char nombre[MAX_NOMBRE];
+    int id_zona;
+    NivelesContaminacion niveles_actuales;
+    DatosClimaticos clima_actual;
+    float promedio_30_dias[4];
+    CoordenadasZona ubicacion;
+    ModeloHolt modelos[4];
+    int modelos_ajustados;
+} DatosZonaArchivo;
+
+// Registro diario en archivo, cada uno con su propio CRC32
+typedef struct {
+    RegistroHistorico registro;
+    unsigned int crc;
+} RegistroArchivoZona;
+
+// Tiempos y resultado de la carga de un archivo de zona
+typedef struct {
+    int id_zona;
+    int cargada;
+    int registros_danados;
+    long bytes;
+    double ms_apertura;
+    double ms_lectura;
+    double ms_validacion;
+} EstadisticasCarga;
+
+// Segmento inmutable del histórico (días del más reciente al más antiguo),
+// compartido por todas las instantáneas que lo usan
+typedef struct {
+    int referencias;
+    int num_registros;
+    RegistroHistorico registros[];
+} SegmentoHistorico;
+
+// Instantánea inmutable de una zona para lectura. Un registro nuevo crea una
+// instantánea con un segmento de un día delante de los segmentos anteriores.
+typedef struct {
+    int referencias;
+    char nombre[MAX_NOMBRE];
+    int id_zona;
+    NivelesContaminacion niveles_actuales;
+    DatosClimaticos clima_actual;
+    float promedio_30_dias[4];
+    EstadisticasVentana estadisticas;
+    float limites[4];                            // Límites de la zona al publicarla
+    char perfil[MAX_NOMBRE_PERFIL];
+    int dias_registrados;
+    unsigned int excesos[4][PALABRAS_MAPA_DIAS]; // Mapas de excesos de la ventana
+    RegistroAgregado resumen_anual[MAX_ANIOS_RESUMEN]; // Promedios anuales de todas las capas
+    int num_anios_resumen;
+    int num_segmentos;
+    SegmentoHistorico *segmentos[MAX_SEGMENTOS_INSTANTANEA]; // El primero es el más reciente
+} InstantaneaZona;
+
+// Bloque adicional de la arena, pedido cuando el principal no alcanza
+typedef struct BloqueArena {
+    struct BloqueArena *siguiente;
+    size_t tamano;
+} BloqueArena;
+
+// Arena de memoria temporal: cada reporte toma de aquí sus datos intermedios y los
+// libera todos juntos al terminar. Si un reporte desborda el bloque principal, este
+// crece al liberarse, de modo que los siguientes reportes no piden memoria al sistema.
+typedef struct {
+    unsigned char *bloque;      // Bloque principal
+    size_t tamano;
+    size_t usado;
+    BloqueArena *adicionales;
+    size_t usado_adicionales;
+    size_t pico;                // Máximo usado en un reporte
+    long reservas;              // Pedidos atendidos por la arena
+    long reservas_sistema;      // Pedidos hechos a malloc
+} ArenaTemporal;
+
+// Posición de la arena para devolver solo lo reservado después de ella
+typedef struct {
+    size_t usado;
+    BloqueArena *adicionales;
+} MarcaArena;
+
+// Texto acumulado en memoria que se escribe de una vez en 'destino'
+typedef struct {
+    char *datos;
+    size_t longitud;
+    size_t capacidad;
+    FILE *destino;
+    long escrituras;            // Llamadas a fwrite realizadas
+} BufferSalida;
+
+// Suma de los días anteriores a una posición del historial (0 = más reciente): el
+// resumen de cualquier rango es la diferencia de dos acumulados
+typedef struct {
+    double suma[4];             // CO2, SO2, NO2, PM2.5
+    int dias_por_estado[4];     // Bueno, Moderado, Danino, Peligroso
+} AcumuladoHistorial;
+
+// Entrada del índice de fechas del visor
+typedef struct {
+    long numero_dia;
+    int posicion;
+} EntradaIndiceFechas;
+
+// Visor paginado sobre los días más recientes de una zona
+typedef struct {
+    ZonaUrbana *zona;
+    int total_dias;
+    int pagina;                 // 0 = página más reciente
+    int num_paginas;
+    EntradaIndiceFechas *indice_fechas; // Ordenado por fecha
+    AcumuladoHistorial *acumulados;     // total_dias + 1 acumulados
+} VistaHistorial;
+
+// Corrección de un campo de un día. La posición es la que tenía el día al preparar
+// la corrección; si al confirmar ya no coincide la fecha, el día se busca por fecha.
+typedef struct {
+    int id_zona;
+    Fecha fecha;
+    int posicion;               // -1 = buscar solo por fecha
+    int campo;                  // CAMPO_CO2 ... CAMPO_PRESION
+    float valor;
+} CorreccionDato;
+
+// Correcciones preparadas que se confirman juntas: una escritura por zona
+typedef struct {
+    CorreccionDato *correcciones;
+    int num_correcciones;
+    int capacidad;
+} TransaccionCorrecciones;
+
 // Estructura para predicciones
 typedef struct {
     int zona_id;
@@ -78,6 +611,23 @@ typedef struct {
     int nivel_alerta; // 0=Verde, 1=Amarillo, 2=Naranja, 3=Rojo
 } Prediccion;
 
+// Pesos del promedio ponderado de predicción
+typedef struct {
+    float dia_1;   // Día más reciente
+    float dia_2;
+    float dia_3;
+    float resto;   // Repartido entre los días anteriores
+} PesosPrediccion;
+
+// Resultado acumulado de un backtest para un conjunto de pesos
+typedef struct {
+    PesosPrediccion pesos;
+    int predicciones[4];           // Por contaminante
+    double suma_error_absoluto[4];
+    double suma_error_cuadratico[4];
+    int confusion[4][4][4];        // [contaminante][alerta real][alerta predicha]
+} ResultadoBacktest;
+
 // Estructura para recomendaciones
 typedef struct {
     char mensaje[200];
@@ -95,14 +645,138 @@ void funcionValidarDatosdeRegistro(float *valor, char *nombre_dato, float min_va
 // Permite modificar datos históricos de contaminantes y clima para una zona y día específico
 void corregirDatosIngresados(ZonaUrbana zonas[]);
 
+// Transacciones de corrección (editor y archivo CSV de correcciones)
+void iniciarTransaccion(TransaccionCorrecciones *transaccion);
+void liberarTransaccion(TransaccionCorrecciones *transaccion);
+int campoDeCorreccion(const char *nombre);
+int agregarCorreccion(TransaccionCorrecciones *transaccion, int id_zona, Fecha fecha, int posicion,
+                      int campo, float valor);
+void aplicarCorreccionDia(ZonaUrbana *zona, int dia, int campo, float valor);
+int confirmarTransaccion(ZonaUrbana zonas[], TransaccionCorrecciones *transaccion);
+int aplicarCorreccionesCSV(ZonaUrbana zonas[], char *nombre_archivo);
+
 // Funciones de inicialización
 void inicializarZonas(ZonaUrbana zonas[]);
 
+// Correlaciones entre contaminantes, clima y zonas
+float variableDeRegistro(const RegistroHistorico *registro, int variable);
+int prepararSeriesCorrelacion(ZonaUrbana zonas[], SeriesCorrelacion *series, ArenaTemporal *arena);
+int correlacionDeSumas(SeriesCorrelacion *series, int columna_x, int columna_y, int desfase,
+                       double producto, float *correlacion);
+void calcularMatrizCorrelacion(SeriesCorrelacion *series, float *matriz);
+void correlacionesDesfasadas(SeriesCorrelacion *series, int columna_x, int columna_y, float resultados[]);
+int exportarMatrizCorrelacion(ZonaUrbana zonas[], float *matriz, char *nombre_archivo);
+void analisisCorrelaciones(ZonaUrbana zonas[]);
+
+// Percentiles por zona, año y contaminante (t-digest en zona_N_cuantiles.dat)
+void iniciarDigest(DigestCuantiles *digest);
+void agregarValorDigest(DigestCuantiles *digest, float valor);
+void compactarDigest(DigestCuantiles *digest);
+void combinarDigest(DigestCuantiles *destino, DigestCuantiles *origen);
+float cuantilDigest(DigestCuantiles *digest, float cuantil);
+CuantilesAnio *cuantilesDeAnio(ZonaUrbana *zona, int año, int crear);
+int agregarRegistroCuantiles(ZonaUrbana *zona, const RegistroHistorico *registro);
+int anioCompletoEnMemoria(ZonaUrbana *zona, int año);
+int reconstruirCuantilesZona(ZonaUrbana *zona, int año);
+void liberarCuantilesZona(ZonaUrbana *zona);
+int guardarCuantilesZona(ZonaUrbana *zona, unsigned int generacion, int sincronizar);
+int cargarCuantilesZona(ZonaUrbana *zona);
+int combinarCuantilesZonas(ZonaUrbana zonas[], int id_zona, int anio_desde, int anio_hasta,
+                           int contaminante, DigestCuantiles *resultado);
+void consultarPercentiles(ZonaUrbana zonas[]);
+
+// Funciones para el histórico archivado
+int archivarRegistro(HistoricoArchivado *archivado, RegistroHistorico registro);
+RegistroHistorico *registroArchivado(HistoricoArchivado *archivado, int indice);
+void liberarHistoricoArchivado(HistoricoArchivado *archivado);
+int diasTotalesZona(ZonaUrbana *zona);
+RegistroHistorico registroDeZona(ZonaUrbana *zona, int dia);
+RegistroHistorico registroHistoricoCompleto(ZonaUrbana *zona, int dia);
+void importarHistoricoLegado(ZonaUrbana zonas[]);
+
+// Huecos y fechas repetidas de la ventana (mapas de bits por día)
+int bitDeMapa(const unsigned int *mapa, int dia);
+void marcarBitDeMapa(unsigned int *mapa, int dia, int valor);
+void desplazarMapaDias(unsigned int *mapa);
+int contarBitsMapa(const unsigned int *mapa);
+int diaImputado(ZonaUrbana *zona, int dia);
+int diaDuplicado(ZonaUrbana *zona, int dia);
+int diaExcluidoDeAnalisis(ZonaUrbana *zona, int dia);
+void marcarDuplicadosZona(ZonaUrbana *zona);
+int buscarDiaEnSerie(long numeros[], int fin, long objetivo);
+float interpolarLineal(float antes, float despues, float t);
+float interpolarEstacional(float semana, float antes, float antes_semana,
+                           float despues, float despues_semana, float t);
+int completarHuecosZona(ZonaUrbana *zona, int *huecos_completados);
+
+// Mapas de excesos por día (conteos por rango con popcount)
+int contarBitsPalabra(unsigned int palabra);
+void desplazarMapaBits(unsigned int *mapa, int palabras, int bits);
+int excesosDeNiveles(NivelesContaminacion niveles, const float *limites);
+int excesosDeDia(ZonaUrbana *zona, int dia);
+void marcarExcesosDia(ZonaUrbana *zona, int dia, NivelesContaminacion niveles);
+void agregarDiaMapaExcesos(ZonaUrbana *zona, NivelesContaminacion niveles);
+void recalcularMapaExcesos(ZonaUrbana *zona);
+int excesosEnPlanos(const unsigned int *planos, int palabras, int dia);
+int contarDiasConExcesosEnPlanos(const unsigned int *planos, int palabras, int desde, int hasta, int minimo);
+int siguienteDiaConExcesos(const unsigned int *planos, int palabras, int desde, int hasta);
+int contarExcesosContaminante(ZonaUrbana *zona, int desde, int hasta, int tipo_contaminante);
+int contarDiasConExcesos(ZonaUrbana *zona, int desde, int hasta, int minimo);
+
+// Funciones de retención del histórico (agregados semanales y mensuales en disco)
+long numeroDeDia(Fecha fecha);
+Fecha fechaDeNumeroDeDia(long numero);
+int aplicarRetencionZona(ZonaUrbana *zona);
+int primerDiaAgregado(int id_zona, Fecha *fecha);
+void iniciarAgregado(RegistroAgregado *agregado, Fecha inicio);
+void acumularEnAgregado(RegistroAgregado *agregado, RegistroHistorico registro);
+void sumarEnResumenAnual(RegistroAgregado resumen[], int *num_anios, int max_anios, RegistroAgregado *agregado);
+int resumenAnualZona(ZonaUrbana *zona, RegistroAgregado resumen[], int max_anios);
+
+// Arena de memoria temporal para reportes y análisis
+ArenaTemporal *arenaReportes(void);
+void *reservarArena(ArenaTemporal *arena, size_t tamano);
+char *formatearEnArena(ArenaTemporal *arena, const char *formato, ...);
+MarcaArena marcaArena(ArenaTemporal *arena);
+void restaurarArena(ArenaTemporal *arena, MarcaArena marca);
+void liberarArena(ArenaTemporal *arena);
+
+// Salida de texto con buffer (formato propio de enteros y decimales)
+void iniciarBufferSalida(BufferSalida *salida, ArenaTemporal *arena, size_t capacidad, FILE *destino);
+void vaciarBufferSalida(BufferSalida *salida);
+void agregarTexto(BufferSalida *salida, const char *texto);
+void agregarTextoAncho(BufferSalida *salida, const char *texto, int ancho);
+void agregarEntero(BufferSalida *salida, long valor, int ancho, char relleno);
+void agregarDecimal(BufferSalida *salida, float valor, int ancho, int decimales, int a_la_izquierda);
+void agregarFilaHistorial(BufferSalida *salida, const RegistroHistorico *registro, int imputado,
+                          const float *limites);
+void medirRenderizadoHistorial(ZonaUrbana zonas[]);
+
 // Funciones para archivos separados
-void guardarZona(ZonaUrbana *zona);
+unsigned int calcularCRC32(const void *datos, size_t longitud);
+int guardarZona(ZonaUrbana *zona);
+const char *tokenInstancia(void);
+int leerBloqueo(char *nombre_bloqueo, long long *creado, char *token);
+int borrarBloqueoSiCoincide(char *nombre_bloqueo, long long creado, const char *token);
+int bloquearZona(int id_zona);
+void desbloquearZona(int id_zona);
+int refrescarZona(ZonaUrbana *zona);
+int guardarZonaBloqueada(ZonaUrbana *zona);
+void sincronizarZonasPendientes(void);
 void guardarTodasLasZonas(ZonaUrbana zonas[]);
 int cargarZona(ZonaUrbana *zona, int id_zona);
+int cargarZonaConEstadisticas(ZonaUrbana *zona, int id_zona, EstadisticasCarga *estadisticas);
 int cargarTodasLasZonas(ZonaUrbana zonas[]);
+unsigned int leerGeneracionArchivo(int id_zona);
+double milisegundosActuales(void);
+int recargarZonasModificadasExternamente(ZonaUrbana zonas[]);
+
+// Instantáneas del histórico (lectura sin bloquear el registro de datos)
+void publicarInstantaneaZona(ZonaUrbana *zona);
+void publicarRegistroNuevo(ZonaUrbana *zona);
+InstantaneaZona *fijarInstantanea(int id_zona);
+void liberarInstantanea(InstantaneaZona *instantanea);
+const RegistroHistorico *registroInstantanea(const InstantaneaZona *instantanea, int dia);
 
 // Funciones principales del sistema
 void registroDatosDiario(ZonaUrbana zonas[]);
@@ -114,18 +788,92 @@ void mostrarEstadoSistema(ZonaUrbana zonas[]);
 // Funciones auxiliares para predicción
 float calcularPrediccion(float *historico, int dias_disponibles);
 float ajustarPorClima(float prediccion_base, DatosClimaticos clima);
-int determinarNivelAlerta(float valor, int tipo_contaminante);
+float obtenerLimiteOMS(int tipo_contaminante);
+int determinarNivelAlerta(float valor, float limite);
 void mostrarRecomendaciones(int nivel_alerta, char *contaminante);
 
+// Índice de calidad del aire
+const TablaICA *tablaICA(int tipo_contaminante, int periodo);
+int indiceDeTabla(const TablaICA *tabla, float concentracion);
+void calcularICALote(const float *concentraciones, int cantidad, int tipo_contaminante, int periodo,
+                     short *indices);
+int categoriaICA(int indice);
+const char *nombreCategoriaICA(int categoria);
+const char *colorCategoriaICA(int categoria);
+void calcularICA(NivelesContaminacion niveles, int periodo, ResultadoICA *resultado);
+int exportarSerieICA(ZonaUrbana zonas[], char *nombre_archivo);
+
+// Configuración de límites y umbrales (archivo, recarga en caliente)
+const ConfiguracionSistema *configuracionActual(void);
+int leerArchivoConfiguracion(char *nombre_archivo, ConfiguracionSistema *configuracion);
+int cargarConfiguracion(char *nombre_archivo);
+void resolverLimitesZona(ZonaUrbana *zona);
+void aplicarConfiguracionZonas(ZonaUrbana zonas[]);
+void recargarConfiguracion(ZonaUrbana zonas[]);
+void manejarSenalRecarga(int senal);
+void instalarRecargaConfiguracion(void);
+void atenderRecargaConfiguracion(ZonaUrbana zonas[]);
+void mostrarConfiguracion(ZonaUrbana zonas[]);
+
+// Funciones para pronóstico multi-horizonte
+int calcularPronosticoMultiHorizonte(ZonaUrbana *zona, PronosticoZona *pronostico);
+int calcularPronosticoTodasLasZonas(ZonaUrbana zonas[], PronosticoZona pronosticos[]);
+void pronosticoMultiHorizonte(ZonaUrbana zonas[]);
+
+// Valores derivados con recálculo perezoso
+void invalidarDerivados(ZonaUrbana *zona, int derivados);
+void registrarCambioDia(ZonaUrbana *zona, int dia, int entradas);
+const float *obtenerPromedio30Dias(ZonaUrbana *zona);
+const EstadisticasVentana *obtenerEstadisticasVentana(ZonaUrbana *zona);
+const PronosticoZona *obtenerPronosticoZona(ZonaUrbana *zona);
+const AlertasZona *obtenerAlertasZona(ZonaUrbana *zona);
+
+// Funciones del modelo estadístico (Holt)
+void actualizarModeloHolt(ModeloHolt *modelo, float valor);
+void ajustarModelosZona(ZonaUrbana *zona);
+void actualizarModelosZona(ZonaUrbana *zona, NivelesContaminacion niveles);
+float pronosticoHolt(ModeloHolt *modelo, int dias, float *desviacion);
+float probabilidadExceder(float prediccion, float desviacion, float limite);
+void mostrarModeloEstadistico(ZonaUrbana zonas[]);
+
+// Detección de anomalías (valores atípicos y sensores trabados) al registrar
+void agregarLecturaDetector(DetectorAnomalias *detector, float valor);
+float medianaDetector(DetectorAnomalias *detector);
+float madDetector(DetectorAnomalias *detector, float mediana);
+int evaluarLecturaDetector(DetectorAnomalias *detector, float valor, AnomaliaDetectada *anomalia);
+void prepararDetectoresZona(ZonaUrbana *zona, int desde);
+void registrarAnomaliasEnLog(ZonaUrbana *zona, Fecha fecha, AnomaliaDetectada anomalias[], int num_anomalias);
+int detectarAnomaliasZona(ZonaUrbana *zona);
+
+// Funciones de evaluación del pronóstico (backtest)
+void ejecutarBacktestZona(ZonaUrbana *zona, ResultadoBacktest *resultado);
+void evaluarPronosticoHistorico(ZonaUrbana zonas[]);
+
 // Funciones para predicción climática
 DatosClimaticos predecirClima24h(ZonaUrbana *zona);
-float calcularPrediccionClimatica(float *historico_clima, int dias_disponibles);
 
 // Funciones para manejo de fechas
 void mostrarFecha(Fecha fecha);
 int compararFechas(Fecha f1, Fecha f2);
 void inicializarDatosHistoricosConFechas(ZonaUrbana zonas[]);
 void mostrarHistorialConFechas(ZonaUrbana zonas[]);
+void leerFecha(Fecha *fecha);
+
+// Funciones del visor paginado del historial
+int estadoDeRegistro(const RegistroHistorico *registro, const float *limites);
+int abrirVistaHistorial(VistaHistorial *vista, ZonaUrbana *zona, int total_dias, ArenaTemporal *arena);
+void resumenRangoHistorial(VistaHistorial *vista, int desde, int hasta, AcumuladoHistorial *resumen);
+int buscarDiaPorFecha(VistaHistorial *vista, Fecha fecha, int *exacta);
+void mostrarPaginaHistorial(VistaHistorial *vista);
+int navegarVistaHistorial(VistaHistorial *vista);
+
+// Funciones para malla de contaminación de la ciudad (interpolación IDW)
+NivelesContaminacion predecirNivelesZona24h(ZonaUrbana *zona, DatosClimaticos *clima_predicho);
+float obtenerNivelContaminante(NivelesContaminacion niveles, int tipo_contaminante);
+CoordenadasZona coordenadasPorDefecto(int id_zona);
+int generarMallaContaminacion(ZonaUrbana zonas[], int tipo_contaminante, int usar_prediccion,
+                              int filas, int columnas, char *nombre_archivo);
+void menuMallaContaminacion(ZonaUrbana zonas[]);
 
 // Funciones para exportación de reportes
 void exportarReportePorZona(ZonaUrbana zonas[], int zona_id);
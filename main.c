@@ -47,6 +47,10 @@ int main(int argc, char *argv[]) {
     printf("======================================================\n");
     printf("Inicializando sistema...\n\n");
     
+    // Los límites se leen antes de cargar las zonas: los mapas de excesos dependen de ellos
+    cargarConfiguracion(ARCHIVO_CONFIGURACION);
+    instalarRecargaConfiguracion();
+    
     // Cargar zonas desde archivos separados
     zonas_cargadas = cargarTodasLasZonas(zonas);
     
@@ -58,11 +62,19 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
+    // Modo no interactivo: aplica un archivo CSV de correcciones y termina
+    if(argc == 3 && strcmp(argv[1], "--correcciones") == 0) {
+        int aplicadas = aplicarCorreccionesCSV(zonas, argv[2]);
+        sincronizarZonasPendientes();
+        return aplicadas < 0 ? 1 : 0;
+    }
+    
     printf("Sistema listo con %d zonas operativas\n\n", zonas_cargadas);
     
     // Menú principal
     do {
         opcion = menu();
+        atenderRecargaConfiguracion(zonas);
         
         switch(opcion) {
             case 1:
@@ -107,6 +119,46 @@ int main(int argc, char *argv[]) {
                 mostrarEstadoSistema(zonas);
                 break;
                 
+            case 9:
+                printf("\n");
+                menuMallaContaminacion(zonas);
+                break;
+                
+            case 10:
+                printf("\n");
+                pronosticoMultiHorizonte(zonas);
+                break;
+                
+            case 11:
+                printf("\n");
+                mostrarModeloEstadistico(zonas);
+                break;
+                
+            case 12:
+                printf("\n");
+                evaluarPronosticoHistorico(zonas);
+                break;
+                
+            case 13:
+                printf("\n");
+                importarHistoricoLegado(zonas);
+                break;
+                
+            case 14:
+                printf("\n");
+                analisisCorrelaciones(zonas);
+                break;
+                
+            case 15:
+                printf("\n");
+                consultarPercentiles(zonas);
+                break;
+                
+            case 16:
+                printf("\n");
+                mostrarConfiguracion(zonas);
+                break;
+                
             case 0:
                 printf("\n");
                 printf("\n");